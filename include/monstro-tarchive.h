@@ -0,0 +1,84 @@
+/**
+ * @file monstro-tarchive.h
+ * 
+ * @section LICENSE License
+ * 
+ * This is free and unencumbered software released into the public domain.
+ *
+ * Anyone is free to copy, modify, publish, use, compile, sell, or
+ * distribute this software, either in source code form or as a compiled
+ * binary, for any purpose, commercial or non-commercial, and by any
+ * means.
+ * 
+ * In jurisdictions that recognize copyright laws, the author or authors
+ * of this software dedicate any and all copyright interest in the
+ * software to the public domain. We make this dedication for the benefit
+ * of the public at large and to the detriment of our heirs and
+ * successors. We intend this dedication to be an overt act of
+ * relinquishment in perpetuity of all present and future rights to this
+ * software under copyright law.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+ * OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ * 
+ * For more information, please refer to <https://unlicense.org>
+ * 
+ * @section DESCRIPTION Description
+ * 
+ * This file contains the struct definitions and function prototypes for 
+ * the replay archive in monstro-tarchive.c.
+ */
+
+#ifndef MONSTRO_TARCHIVE_H
+#define MONSTRO_TARCHIVE_H
+
+#ifndef MONSTRO_TWANT_REPLAY
+#error "MONSTRO_TWANT_ARCHIVE requires MONSTRO_TWANT_REPLAY"
+#endif
+
+#include <stddef.h>
+#include <stdint.h>
+#include "monstro-treplay.h"
+
+#define MONSTRO_TARCHIVE_VERSION            1
+#define MONSTRO_TARCHIVE_INTERVAL        4096      // Default number of ticks between keyframes
+
+
+
+// Archive opened for appending replays; see open_archive_writer()
+typedef struct {
+    int file;               // File descriptors of the archive and its index
+    int index;
+    uint64_t size;          // Size of the archive, in bytes
+    uint64_t count;         // Number of replays in the archive
+} MONSTRO_TARCHIVE_WRITER;
+
+// Archive mapped for reading; see open_archive()
+typedef struct {
+    const uint8_t *data;    // The whole archive, mapped in memory
+    uint64_t size;
+    const uint8_t *index;   // Offset of each replay, 8 bytes each
+    uint64_t count;         // Number of replays in the archive
+    uint64_t end;           // Offset right after the last complete replay
+    uint8_t *index_copy;    // Set if the index file couldn't be updated and was rebuilt in memory
+    size_t index_mapping;   // Size of the mapping of the index file
+} MONSTRO_TARCHIVE;
+
+
+
+// Public function prototypes
+int open_archive_writer(MONSTRO_TARCHIVE_WRITER *writer, const char *path);
+int append_replay(MONSTRO_TARCHIVE_WRITER *writer, const uint8_t *replay, size_t size, uint64_t interval);
+void close_archive_writer(MONSTRO_TARCHIVE_WRITER *writer);
+int open_archive(MONSTRO_TARCHIVE *archive, const char *path);
+void close_archive(MONSTRO_TARCHIVE *archive);
+int archive_replay(const MONSTRO_TARCHIVE *archive, uint64_t i, const uint8_t **replay, size_t *size);
+int seek_replay(const MONSTRO_TARCHIVE *archive, uint64_t i, uint64_t tick, MONSTRO_TGAME *game, 
+                MONSTRO_TREPLAY_CURSOR *cursor, MONSTRO_TREPLAY_RESULT *result);
+
+#endif
@@ -0,0 +1,87 @@
+/**
+ * @file monstro-tbatch.h
+ * 
+ * @section LICENSE License
+ * 
+ * This is free and unencumbered software released into the public domain.
+ *
+ * Anyone is free to copy, modify, publish, use, compile, sell, or
+ * distribute this software, either in source code form or as a compiled
+ * binary, for any purpose, commercial or non-commercial, and by any
+ * means.
+ * 
+ * In jurisdictions that recognize copyright laws, the author or authors
+ * of this software dedicate any and all copyright interest in the
+ * software to the public domain. We make this dedication for the benefit
+ * of the public at large and to the detriment of our heirs and
+ * successors. We intend this dedication to be an overt act of
+ * relinquishment in perpetuity of all present and future rights to this
+ * software under copyright law.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+ * OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ * 
+ * For more information, please refer to <https://unlicense.org>
+ * 
+ * @section DESCRIPTION Description
+ * 
+ * This file contains the struct definition and function prototypes for 
+ * the batch engine in monstro-tbatch.c.
+ */
+
+#ifndef MONSTRO_TBATCH_H
+#define MONSTRO_TBATCH_H
+
+#include <stdint.h>
+#include "monstro-tlogic.h"
+
+#if defined(MONSTRO_TWANT_COLORS) || defined(MONSTRO_TWANT_COLUMNS) || defined(MONSTRO_TWANT_HASH)
+#error "MONSTRO_TWANT_BATCH can't be combined with MONSTRO_TWANT_COLORS, MONSTRO_TWANT_COLUMNS or MONSTRO_TWANT_HASH"
+#endif
+
+#define MONSTRO_TBATCH_LANES                8      // Games processed by each vector operation
+#define MONSTRO_TBATCH_GUARD                4      // Spare rows below and above each playfield
+#define MONSTRO_TBATCH_STRIDE              (MONSTRO_TFIELD_SIZE + 2 * MONSTRO_TBATCH_GUARD)
+
+
+
+// A batch of games stored as parallel arrays, one element per game, 
+// see monstro-tbatch.c. The arrays have the same meaning as the fields 
+// of MONSTRO_TGAME; snap_index and drop_index are not stored since 
+// mover_piezas() computes them from the inputs at every call.
+typedef struct {
+    int count;                  // Number of games in the batch
+    int capacity;               // count rounded up to a multiple of MONSTRO_TBATCH_LANES
+    MONSTRO_TROW *playfields;   // Game i uses MONSTRO_TFIELD_SIZE rows from playfields + i * MONSTRO_TBATCH_STRIDE
+    int32_t *piece;
+    int32_t *rotation;
+    int32_t *x, *y;
+    int32_t *inputs;
+    int32_t *flags;
+    int32_t *snap_default;
+    int32_t *snap_count;
+    int32_t *drop_default;
+    int32_t *drop_count;
+    int32_t *move_default;
+    int32_t *move_count;
+    int32_t *move_index;
+    uint64_t *random_state;
+    void *memory;               // The single allocation holding all of the above
+} MONSTRO_TBATCH;
+
+
+
+// Public function prototypes
+int init_batch(MONSTRO_TBATCH *batch, int count);
+void free_batch(MONSTRO_TBATCH *batch);
+void set_game(MONSTRO_TBATCH *batch, int i, const MONSTRO_TGAME *game);
+void get_game(const MONSTRO_TBATCH *batch, int i, MONSTRO_TGAME *game);
+void mover_piezas(MONSTRO_TBATCH *batch);
+int spawn_piece_batch(MONSTRO_TBATCH *batch, int i);
+
+#endif
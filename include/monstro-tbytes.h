@@ -0,0 +1,75 @@
+/**
+ * @file monstro-tbytes.h
+ * 
+ * @section LICENSE License
+ * 
+ * This is free and unencumbered software released into the public domain.
+ * 
+ * Anyone is free to copy, modify, publish, use, compile, sell, or
+ * distribute this software, either in source code form or as a compiled
+ * binary, for any purpose, commercial or non-commercial, and by any
+ * means.
+ * 
+ * In jurisdictions that recognize copyright laws, the author or authors
+ * of this software dedicate any and all copyright interest in the
+ * software to the public domain. We make this dedication for the benefit
+ * of the public at large and to the detriment of our heirs and
+ * successors. We intend this dedication to be an overt act of
+ * relinquishment in perpetuity of all present and future rights to this
+ * software under copyright law.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+ * OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ * 
+ * For more information, please refer to <https://unlicense.org>
+ * 
+ * @section DESCRIPTION Description
+ * 
+ * This file contains the helpers that read and write the little endian
+ * integers of the snapshot, archive, session, stream and server
+ * formats, so every format stores its values the same way no matter
+ * the byte order of the machine.
+ */
+
+#ifndef MONSTRO_TBYTES_H
+#define MONSTRO_TBYTES_H
+
+#include <stdint.h>
+#include <string.h>
+
+
+
+/**
+ * Stores a value of up to 64 bits in little endian order.
+ */
+static inline void put_le(uint8_t *buffer, uint64_t value, int bytes) {
+#if __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+    memcpy(buffer, &value, bytes);
+#else
+    for (int i = 0; i < bytes; i++)
+        buffer[i] = value >> (i * 8);
+#endif
+}
+
+
+
+/**
+ * Loads a value of up to 64 bits stored in little endian order.
+ */
+static inline uint64_t get_le(const uint8_t *buffer, int bytes) {
+    uint64_t value = 0;
+#if __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+    memcpy(&value, buffer, bytes);
+#else
+    for (int i = 0; i < bytes; i++)
+        value |= (uint64_t)buffer[i] << (i * 8);
+#endif
+    return value;
+}
+
+#endif
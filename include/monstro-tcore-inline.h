@@ -0,0 +1,158 @@
+/**
+ * @file monstro-tcore-inline.h
+ * 
+ * @section LICENSE License
+ * 
+ * This is free and unencumbered software released into the public domain.
+ *
+ * Anyone is free to copy, modify, publish, use, compile, sell, or
+ * distribute this software, either in source code form or as a compiled
+ * binary, for any purpose, commercial or non-commercial, and by any
+ * means.
+ * 
+ * In jurisdictions that recognize copyright laws, the author or authors
+ * of this software dedicate any and all copyright interest in the
+ * software to the public domain. We make this dedication for the benefit
+ * of the public at large and to the detriment of our heirs and
+ * successors. We intend this dedication to be an overt act of
+ * relinquishment in perpetuity of all present and future rights to this
+ * software under copyright law.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+ * OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ * 
+ * For more information, please refer to <https://unlicense.org>
+ * 
+ * @section DESCRIPTION Description
+ * 
+ * This file contains the definitions of the core functions that are 
+ * called at every step of the game logic: poner_pieza(), borrar_pieza() 
+ * and puede_mover().
+ * 
+ * When \c MONSTRO_TWANT_INLINE_CORE is defined, monstro-tcore.h includes 
+ * this file and the functions are defined as \c static \c inline in 
+ * every file that uses them, so the compiler can inline them into the 
+ * logic instead of calling them in a different translation unit. 
+ * Otherwise, monstro-tcore.c includes this file to provide the external 
+ * definitions of the functions.
+ * 
+ * The playfield rows are read and written through memcpy() instead of 
+ * casting the \c MONSTRO_TROW pointer to \c uint64_t, which keeps the 
+ * code valid under strict aliasing rules; compilers turn these memcpy() 
+ * calls into single load and store instructions.
+ */
+
+#ifndef MONSTRO_TCORE_INLINE_H
+#define MONSTRO_TCORE_INLINE_H
+
+#include <stdint.h>
+#include <string.h>
+#include <stdbool.h>
+#include "monstro-tcore.h"
+
+#ifndef MONSTRO_TCORE_INLINE
+#define MONSTRO_TCORE_INLINE static inline
+#endif
+
+
+
+/**
+ * Pone una pieza en la posición (x, y) del tablero.
+ * 
+ * Esta función coloca una pieza en el tablero. La pieza a colocar 
+ * debe encajar libremente en la posición especificada, de 
+ * lo contrario se podría producir basura en el tablero.
+ * 
+ * @param area_de_juego Un apuntador a un arreglo de \c MONSTRO_TROW 
+ *                      representando el tablero del juego.
+ * @param pieza         La pieza a colocar, representada como un entero 
+ *                      de 64 bits \c uint64_t.
+ * @param x             La posición \c x en la que se colocará la pieza.
+ * @param y             La posición \c y en la que se colocará la pieza.
+ */
+MONSTRO_TCORE_INLINE void poner_pieza(MONSTRO_TROW *area_de_juego, uint64_t pieza, int x, int y) {
+#if MONSTRO_TFIELD_WIDTH == 16
+    uint64_t destino;
+    memcpy(&destino, &area_de_juego[y], sizeof(destino));
+    destino |= pieza << x;
+    memcpy(&area_de_juego[y], &destino, sizeof(destino));
+#else
+    for (int i = 0; i < 4; i++)
+        area_de_juego[y + i] |= (MONSTRO_TROW)((pieza >> (i * 16)) & 0xFFFF) << x;
+#endif
+}
+
+
+
+/**
+ * Borra una pieza de la posición (x, y) del tablero.
+ * 
+ * Esta función borra del tablero una pieza previamente colocada con la 
+ * función poner_pieza(). Llamar esta función sin haber llamado 
+ * previamente poner_pieza(), o bien usando coordenadas distintas a las 
+ * que se usaron para colocar la pieza, podría producir basura en 
+ * el tablero.
+ * 
+ * @param area_de_juego Un apuntador a un arreglo de \c MONSTRO_TROW 
+ *                      representando el tablero del juego.
+ * @param pieza         La pieza a colocar, representada como un entero 
+ *                      de 64 bits \c uint64_t.
+ * @param x             La posición \c x en la que se colocará la pieza.
+ * @param y             La posición \c y en la que se colocará la pieza.
+ */
+MONSTRO_TCORE_INLINE void borrar_pieza(MONSTRO_TROW *area_de_juego, uint64_t pieza, int x, int y) {
+#if MONSTRO_TFIELD_WIDTH == 16
+    uint64_t destino;
+    memcpy(&destino, &area_de_juego[y], sizeof(destino));
+    destino ^= pieza << x;
+    memcpy(&area_de_juego[y], &destino, sizeof(destino));
+#else
+    for (int i = 0; i < 4; i++)
+        area_de_juego[y + i] ^= (MONSTRO_TROW)((pieza >> (i * 16)) & 0xFFFF) << x;
+#endif
+}
+
+
+
+/**
+ * Verifica si se puede colocar una pieza en el tablero en la 
+ * posición (x, y).
+ * 
+ * Esta función verifica si se puede colocar una pieza en el tablero. 
+ * Regresa \c true si la pieza puede encajar libremente en el tablero; 
+ * de lo contrario regresa \c false.
+ * 
+ * @param area_de_juego Un apuntador a un arreglo de \c MONSTRO_TROW 
+ *                      representando el tablero del juego.
+ * @param pieza         La pieza a colocar, representada como un entero 
+ *                      de 64 bits \c uint64_t.
+ * @param x             La posición \c x en la que se verificará si 
+ *                      puede ser colocada la pieza.
+ * @param y             La posición \c y en la que se verificará si 
+ *                      puede ser colocada la pieza.
+ * @return              \c true si la pieza puede ser colocada 
+ *                      libremente en el tablero en la posición (x, y); 
+ *                      de lo contrario, \c false.
+ */
+MONSTRO_TCORE_INLINE int puede_mover(MONSTRO_TROW *area_de_juego, uint64_t pieza, int x, int y) {
+#if MONSTRO_TFIELD_WIDTH == 16
+    uint64_t destino;
+    memcpy(&destino, &area_de_juego[y], sizeof(destino));
+    if (destino & (pieza << x)) return false;
+    return true;
+#else
+// Con filas de más de 16 bits, cada fila de la pieza se desplaza por separado
+    MONSTRO_TROW choque = 0;
+    for (int i = 0; i < 4; i++)
+        choque |= area_de_juego[y + i] & ((MONSTRO_TROW)((pieza >> (i * 16)) & 0xFFFF) << x);
+    if (choque == 0) return true;
+    return false;
+#endif
+}
+
+#endif
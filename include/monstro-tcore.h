@@ -0,0 +1,109 @@
+/**
+ * @file monstro-tcore.h
+ * 
+ * @section LICENSE License
+ * 
+ * This is free and unencumbered software released into the public domain.
+ *
+ * Anyone is free to copy, modify, publish, use, compile, sell, or
+ * distribute this software, either in source code form or as a compiled
+ * binary, for any purpose, commercial or non-commercial, and by any
+ * means.
+ * 
+ * In jurisdictions that recognize copyright laws, the author or authors
+ * of this software dedicate any and all copyright interest in the
+ * software to the public domain. We make this dedication for the benefit
+ * of the public at large and to the detriment of our heirs and
+ * successors. We intend this dedication to be an overt act of
+ * relinquishment in perpetuity of all present and future rights to this
+ * software under copyright law.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+ * OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ * 
+ * For more information, please refer to <https://unlicense.org>
+ * 
+ * @section DESCRIPTION Description
+ * 
+ * This file contains the playfield dimensions and the function 
+ * prototypes for the core functions in monstro-tcore.c and for the 
+ * optional column index in monstro-tcolumns.c. When 
+ * \c MONSTRO_TWANT_INLINE_CORE is defined, it also includes the inline 
+ * definitions in monstro-tcore-inline.h.
+ */
+
+#ifndef MONSTRO_TCORE_H
+#define MONSTRO_TCORE_H
+
+#include <stdint.h>
+
+
+
+// Playfield dimensions; these can be changed at compile time but the 
+// defaults are the fastest option and enough for a typical playfield
+#ifndef MONSTRO_TFIELD_SIZE
+#define MONSTRO_TFIELD_SIZE                24      // Number of rows, including the floor and the 4 hidden rows
+#endif
+#ifndef MONSTRO_TFIELD_WIDTH
+#define MONSTRO_TFIELD_WIDTH               16      // Number of bits per row; 16, 32 or 64
+#endif
+
+#if MONSTRO_TFIELD_WIDTH == 16
+typedef uint16_t MONSTRO_TROW;
+#elif MONSTRO_TFIELD_WIDTH == 32
+typedef uint32_t MONSTRO_TROW;
+#elif MONSTRO_TFIELD_WIDTH == 64
+typedef uint64_t MONSTRO_TROW;
+#else
+#error "MONSTRO_TFIELD_WIDTH must be 16, 32 or 64"
+#endif
+
+#define MONSTRO_TFULL_ROW                  ((MONSTRO_TROW)~(MONSTRO_TROW)0)
+
+// Type used by the optional column index; one bit per row, plus 4 spare bits
+#if MONSTRO_TFIELD_SIZE <= 28
+typedef uint32_t MONSTRO_TCOLUMN;
+#elif MONSTRO_TFIELD_SIZE <= 60
+typedef uint64_t MONSTRO_TCOLUMN;
+#else
+#error "MONSTRO_TFIELD_SIZE must be 60 or less"
+#endif
+
+
+
+// Public function prototypes
+#ifdef MONSTRO_TWANT_INLINE_CORE
+#include "monstro-tcore-inline.h"
+#else
+void poner_pieza(MONSTRO_TROW *area_de_juego, uint64_t pieza, int x, int y);
+void borrar_pieza(MONSTRO_TROW *area_de_juego, uint64_t pieza, int x, int y);
+int puede_mover(MONSTRO_TROW *area_de_juego, uint64_t pieza, int x, int y);
+#endif
+#if MONSTRO_TFIELD_WIDTH == 16
+uint64_t posiciones_libres(MONSTRO_TROW *area_de_juego, const uint64_t *rotaciones, int y);
+#endif
+int borrar_completas(MONSTRO_TROW *area_de_juego, int y);
+MONSTRO_TROW subir_basura(MONSTRO_TROW *area_de_juego, const MONSTRO_TROW *basura, int filas);
+#ifdef MONSTRO_TWANT_COLUMNS
+void iniciar_columnas(MONSTRO_TCOLUMN *columnas, MONSTRO_TROW *area_de_juego);
+void poner_columnas(MONSTRO_TCOLUMN *columnas, uint64_t pieza, int x, int y);
+void borrar_columnas(MONSTRO_TCOLUMN *columnas, uint64_t pieza, int x, int y);
+void borrar_completas_columnas(MONSTRO_TCOLUMN *columnas, int y, int completas);
+int altura_columna(MONSTRO_TCOLUMN *columnas, int x);
+int caida_pieza(MONSTRO_TCOLUMN *columnas, uint64_t pieza, int x, int y);
+#endif
+#ifdef MONSTRO_TWANT_HASH
+void iniciar_claves(void);
+uint64_t calcular_hash(MONSTRO_TROW *area_de_juego);
+void poner_hash(uint64_t *hash, uint64_t pieza, int x, int y);
+void borrar_hash(uint64_t *hash, uint64_t pieza, int x, int y);
+void borrar_completas_hash(uint64_t *hash, MONSTRO_TROW *area_de_juego, int y, int completas);
+uint64_t hash_estado(int pieza, int rotacion, int x, int y);
+#endif
+
+#endif
@@ -0,0 +1,63 @@
+/**
+ * @file monstro-tfeatures.h
+ * 
+ * @section LICENSE License
+ * 
+ * This is free and unencumbered software released into the public domain.
+ *
+ * Anyone is free to copy, modify, publish, use, compile, sell, or
+ * distribute this software, either in source code form or as a compiled
+ * binary, for any purpose, commercial or non-commercial, and by any
+ * means.
+ * 
+ * In jurisdictions that recognize copyright laws, the author or authors
+ * of this software dedicate any and all copyright interest in the
+ * software to the public domain. We make this dedication for the benefit
+ * of the public at large and to the detriment of our heirs and
+ * successors. We intend this dedication to be an overt act of
+ * relinquishment in perpetuity of all present and future rights to this
+ * software under copyright law.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+ * OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ * 
+ * For more information, please refer to <https://unlicense.org>
+ * 
+ * @section DESCRIPTION Description
+ * 
+ * This file contains the struct definitions and function prototypes for 
+ * the board feature extractor in monstro-tfeatures.c.
+ */
+
+#ifndef MONSTRO_TFEATURES_H
+#define MONSTRO_TFEATURES_H
+
+#include <stdint.h>
+#include "monstro-tlogic.h"
+
+
+
+// Features of a playfield, as used by the evaluation functions of bots; 
+// see extract_features()
+typedef struct {
+    int height;                 // Highest row with a block, 0 if the well is empty
+    int aggregate_height;       // Sum of the heights of the columns
+    int holes;                  // Empty cells with a block above them in the same column
+    int bumpiness;              // Sum of the height differences between adjacent columns
+    int row_transitions;        // Changes between filled and empty cells along each row, walls included
+    int column_transitions;     // Changes between filled and empty cells along each column, floor included
+    int wells;                  // Sum of the depths of the well cells, each counted from the top of its well
+} MONSTRO_TFEATURES;
+
+
+
+// Public function prototypes
+void extract_features(const MONSTRO_TROW *playfield, MONSTRO_TFEATURES *features);
+void extract_features_batch(const MONSTRO_TROW *playfields, int count, MONSTRO_TFEATURES *features);
+
+#endif
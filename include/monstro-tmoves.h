@@ -0,0 +1,85 @@
+/**
+ * @file monstro-tmoves.h
+ * 
+ * @section LICENSE License
+ * 
+ * This is free and unencumbered software released into the public domain.
+ *
+ * Anyone is free to copy, modify, publish, use, compile, sell, or
+ * distribute this software, either in source code form or as a compiled
+ * binary, for any purpose, commercial or non-commercial, and by any
+ * means.
+ * 
+ * In jurisdictions that recognize copyright laws, the author or authors
+ * of this software dedicate any and all copyright interest in the
+ * software to the public domain. We make this dedication for the benefit
+ * of the public at large and to the detriment of our heirs and
+ * successors. We intend this dedication to be an overt act of
+ * relinquishment in perpetuity of all present and future rights to this
+ * software under copyright law.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+ * OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ * 
+ * For more information, please refer to <https://unlicense.org>
+ * 
+ * @section DESCRIPTION Description
+ * 
+ * This file contains the struct definitions and function prototypes for 
+ * the move generator in monstro-tmoves.c.
+ */
+
+#ifndef MONSTRO_TMOVES_H
+#define MONSTRO_TMOVES_H
+
+#include <stdint.h>
+#include "monstro-tlogic.h"
+
+#define MONSTRO_TMOVES_MIN_Y               -1      // Lowest row of a piece, the I piece lying on the floor
+#define MONSTRO_TMOVES_ROWS                (MONSTRO_TFIELD_SIZE - 4 - MONSTRO_TMOVES_MIN_Y + 1)
+#define MONSTRO_TMOVES_COLUMNS             (MONSTRO_TFIELD_WIDTH - 3)
+// Number of piece states, an upper bound for the number of placements
+#define MONSTRO_TMOVES_MAX                 (4 * MONSTRO_TMOVES_ROWS * MONSTRO_TMOVES_COLUMNS)
+// Index of row y in the bitboards of MONSTRO_TREACH; index 0 is the row below the lowest one
+#define MONSTRO_TMOVES_ROW(y)              ((y) - MONSTRO_TMOVES_MIN_Y + 1)
+
+// Placement flags; kicks use the game action flags MONSTRO_TACTION_WALL_KICK 
+// and MONSTRO_TACTION_FLOOR_KICK, see reach_flags()
+#define MONSTRO_TMOVES_TUCK               0x1      // Not a straight drop from the row of the piece
+
+
+
+// A place where the current piece can lock; see generate_placements()
+typedef struct {
+    int8_t x, y;            // Position of the piece
+    uint8_t rotation;       // Rotation of the piece
+    uint8_t inputs;         // Fewest inputs needed to get there from the current position
+    uint8_t flags;          // Placement flags from reach_flags(), only set by flood_placements()
+} MONSTRO_TPLACEMENT;
+
+// Bitboards of the states of the current piece, a bit mask over x for 
+// each rotation and row; see flood_reach()
+typedef struct {
+    int piece;
+    int rotation, x, y;     // Position the piece was at
+    uint64_t fits[4][MONSTRO_TMOVES_ROWS + 1];          // States where the piece fits
+    uint64_t reachable[4][MONSTRO_TMOVES_ROWS + 1];     // States the piece can get to
+    uint64_t unkicked[4][MONSTRO_TMOVES_ROWS + 1];      // States the piece can get to without kicks
+    uint64_t wall_kicked[4][MONSTRO_TMOVES_ROWS + 1];   // States the piece can get to with wall kicks only
+    uint64_t dropped[4][MONSTRO_TMOVES_ROWS + 1];       // Straight drops from the row of the piece
+} MONSTRO_TREACH;
+
+
+
+// Public function prototypes
+int generate_placements(const MONSTRO_TGAME *game, MONSTRO_TPLACEMENT *placements);
+int flood_reach(const MONSTRO_TGAME *game, MONSTRO_TREACH *reach);
+int reach_flags(const MONSTRO_TREACH *reach, int rotation, int x, int y);
+int flood_placements(const MONSTRO_TGAME *game, MONSTRO_TPLACEMENT *placements);
+
+#endif
@@ -0,0 +1,61 @@
+/**
+ * @file monstro-tpieces.h
+ * 
+ * @section LICENSE License
+ * 
+ * This is free and unencumbered software released into the public domain.
+ *
+ * Anyone is free to copy, modify, publish, use, compile, sell, or
+ * distribute this software, either in source code form or as a compiled
+ * binary, for any purpose, commercial or non-commercial, and by any
+ * means.
+ * 
+ * In jurisdictions that recognize copyright laws, the author or authors
+ * of this software dedicate any and all copyright interest in the
+ * software to the public domain. We make this dedication for the benefit
+ * of the public at large and to the detriment of our heirs and
+ * successors. We intend this dedication to be an overt act of
+ * relinquishment in perpetuity of all present and future rights to this
+ * software under copyright law.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+ * OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ * 
+ * For more information, please refer to <https://unlicense.org>
+ * 
+ * @section DESCRIPTION Description
+ * 
+ * This file contains the pieces used by the logic implementation in 
+ * monstro-tlogic.c, in the representation expected by the core 
+ * functions in monstro-tcore.c. They are defined here, instead of in 
+ * monstro-tlogic.c, so that other files working on the same game 
+ * state, like monstro-tsnapshot.c, use the very same tables.
+ */
+
+#ifndef MONSTRO_TPIECES_H
+#define MONSTRO_TPIECES_H
+
+#include <stdint.h>
+
+
+
+// Piezas:
+enum {_I_, _O_, _T_, _J_, _L_, _S_, _Z_};   // Named values for the pieces' index
+// I,    O,      T,      J,    L,      S,    Z
+// cyan, yellow, purple, blue, orange, lime, red
+static const uint64_t pieza_I[] = {0xF00000000, 0x2000200020002, 0xF0000, 0x4000400040004};
+static const uint64_t pieza_O[] = {0x600060000, 0x600060000, 0x600060000, 0x600060000};
+static const uint64_t pieza_T[] = {0x200070000, 0x200030002, 0x70002, 0x200060002};
+static const uint64_t pieza_J[] = {0x400070000, 0x300020002, 0x70001, 0x200020006};
+static const uint64_t pieza_L[] = {0x100070000, 0x200020003, 0x70004, 0x600020002};
+static const uint64_t pieza_S[] = {0x300060000, 0x200030001, 0x30006, 0x400060002};
+static const uint64_t pieza_Z[] = {0x600030000, 0x100030002, 0x60003, 0x200060004};
+// Use 0xF000700030001 to see the way the board maps to an uint64_t
+static const uint64_t *const piezas[] = {pieza_I, pieza_O, pieza_T, pieza_J, pieza_L, pieza_S, pieza_Z};
+
+#endif
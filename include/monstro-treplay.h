@@ -0,0 +1,101 @@
+/**
+ * @file monstro-treplay.h
+ * 
+ * @section LICENSE License
+ * 
+ * This is free and unencumbered software released into the public domain.
+ *
+ * Anyone is free to copy, modify, publish, use, compile, sell, or
+ * distribute this software, either in source code form or as a compiled
+ * binary, for any purpose, commercial or non-commercial, and by any
+ * means.
+ * 
+ * In jurisdictions that recognize copyright laws, the author or authors
+ * of this software dedicate any and all copyright interest in the
+ * software to the public domain. We make this dedication for the benefit
+ * of the public at large and to the detriment of our heirs and
+ * successors. We intend this dedication to be an overt act of
+ * relinquishment in perpetuity of all present and future rights to this
+ * software under copyright law.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+ * OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ * 
+ * For more information, please refer to <https://unlicense.org>
+ * 
+ * @section DESCRIPTION Description
+ * 
+ * This file contains the struct definitions and function prototypes for 
+ * the replay recorder and player in monstro-treplay.c.
+ */
+
+#ifndef MONSTRO_TREPLAY_H
+#define MONSTRO_TREPLAY_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "monstro-tlogic.h"
+
+#define MONSTRO_TREPLAY_VERSION             2
+#define MONSTRO_TREPLAY_INTERVAL          256      // Default number of ticks between state checkpoints
+
+// Results of play_replay() and continue_replay()
+#define MONSTRO_TREPLAY_OK                  0      // The replay played to the end and every checkpoint matched
+#define MONSTRO_TREPLAY_DESYNC              1      // A checkpoint didn't match the re-simulated state
+#define MONSTRO_TREPLAY_CORRUPT             2      // The replay data is truncated or invalid
+#define MONSTRO_TREPLAY_INCOMPATIBLE        3      // The replay was recorded with different playfield dimensions or version
+#define MONSTRO_TREPLAY_PAUSED              4      // The replay reached the requested tick; see continue_replay()
+
+
+
+// Replay recorder; see start_recording()
+typedef struct {
+    uint8_t *data;          // The replay recorded so far
+    size_t size;
+    size_t capacity;
+    uint64_t ticks;         // Number of ticks recorded
+    int interval;           // Number of ticks between checkpoints, 0 for none
+    int inputs;             // Inputs of the current run
+    uint64_t run;           // Length of the current run, in ticks
+    int snap_default;       // Last recorded limits
+    int drop_default;
+    int move_default;
+    int failed;             // Set if the memory for the replay couldn't be allocated
+} MONSTRO_TRECORDER;
+
+// Position of a replay being played; see start_replay()
+typedef struct {
+    size_t offset;          // Offset of the next record
+    int inputs;             // Inputs of the current run
+    uint64_t run;           // Number of ticks left in the current run
+    int spawn;              // Set if a piece must be spawned before the next tick
+} MONSTRO_TREPLAY_CURSOR;
+
+// Outcome of play_replay()
+typedef struct {
+    uint64_t seed;
+    uint64_t ticks;         // Number of ticks played
+    uint64_t pieces;        // Number of pieces spawned, including the first one
+    uint64_t lines;         // Number of lines cleared
+    uint64_t checkpoints;   // Number of checkpoints verified, including the final state
+    int game_over;          // Set if a piece couldn't be spawned
+} MONSTRO_TREPLAY_RESULT;
+
+
+
+// Public function prototypes
+int start_recording(MONSTRO_TRECORDER *recorder, const MONSTRO_TGAME *game, uint64_t seed, int interval);
+void mover_pieza_recorded(MONSTRO_TRECORDER *recorder, MONSTRO_TGAME *game);
+size_t finish_recording(MONSTRO_TRECORDER *recorder, const MONSTRO_TGAME *game);
+void free_recording(MONSTRO_TRECORDER *recorder);
+int start_replay(const uint8_t *data, size_t size, MONSTRO_TGAME *game, MONSTRO_TREPLAY_CURSOR *cursor, MONSTRO_TREPLAY_RESULT *result);
+int continue_replay(const uint8_t *data, size_t size, MONSTRO_TGAME *game, MONSTRO_TREPLAY_CURSOR *cursor, 
+                    MONSTRO_TREPLAY_RESULT *result, uint64_t ticks);
+int play_replay(const uint8_t *data, size_t size, MONSTRO_TGAME *game, MONSTRO_TREPLAY_RESULT *result);
+
+#endif
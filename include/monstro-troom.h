@@ -0,0 +1,101 @@
+/**
+ * @file monstro-troom.h
+ * 
+ * @section LICENSE License
+ * 
+ * This is free and unencumbered software released into the public domain.
+ *
+ * Anyone is free to copy, modify, publish, use, compile, sell, or
+ * distribute this software, either in source code form or as a compiled
+ * binary, for any purpose, commercial or non-commercial, and by any
+ * means.
+ * 
+ * In jurisdictions that recognize copyright laws, the author or authors
+ * of this software dedicate any and all copyright interest in the
+ * software to the public domain. We make this dedication for the benefit
+ * of the public at large and to the detriment of our heirs and
+ * successors. We intend this dedication to be an overt act of
+ * relinquishment in perpetuity of all present and future rights to this
+ * software under copyright law.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+ * OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ * 
+ * For more information, please refer to <https://unlicense.org>
+ * 
+ * @section DESCRIPTION Description
+ * 
+ * This file contains the struct definitions and function prototypes for 
+ * the battle room in monstro-troom.c.
+ */
+
+#ifndef MONSTRO_TROOM_H
+#define MONSTRO_TROOM_H
+
+#include <stdint.h>
+#include "monstro-tlogic.h"
+
+#define MONSTRO_TROOM_BOARDS              128      // Largest number of boards in a room
+#define MONSTRO_TROOM_QUEUE                16      // Number of attacks that can wait on a board, a power of 2
+#define MONSTRO_TROOM_GARBAGE               8      // Largest number of garbage rows added to a board per piece
+#define MONSTRO_TROOM_RATE                 60      // Ticks per second
+#define MONSTRO_TROOM_MAX_LATE              6      // Number of late ticks after which the scheduler gives up catching up
+
+
+
+// Garbage sent by one board to another
+typedef struct {
+    uint16_t from;          // Index of the board that sent it
+    uint8_t rows;           // Number of garbage rows
+    uint8_t hole;           // Column of the hole, the same for every row
+} MONSTRO_TROOM_ATTACK;
+
+// State of one board of a room
+typedef struct {
+    MONSTRO_TGAME game;
+    uint64_t lines;         // Number of lines cleared
+    int level_lines;        // Lines cleared since the last speed increase
+    int game_over;          // Set if the board topped out
+    int place;              // Final place of the board, 1 for the winner, 0 while it's still playing
+    int target;             // Index of the board this one attacks
+    uint32_t head, tail;    // Attacks waiting in the queue, from head to tail
+    MONSTRO_TROOM_ATTACK queue[MONSTRO_TROOM_QUEUE];
+    uint64_t sent;          // Number of garbage rows sent, after cancelling
+    uint64_t cancelled;     // Number of garbage rows cancelled by clearing lines
+    uint64_t received;      // Number of garbage rows added to the playfield
+    uint64_t knockouts;     // Number of boards that topped out while this one was attacking them
+} MONSTRO_TROOM_BOARD;
+
+// Battle room; see init_room()
+typedef struct {
+    int count;              // Number of boards
+    int alive;              // Number of boards still playing
+    uint64_t tick;          // Number of ticks played
+    uint64_t random_state;  // Random generator for targets and holes
+    int sent;               // Number of attacks sent during the current tick
+    MONSTRO_TROOM_ATTACK outbox[MONSTRO_TROOM_BOARDS];      // Attacks sent during the current tick
+    int16_t targets[MONSTRO_TROOM_BOARDS];                  // Target of each attack in the outbox
+// Scheduler
+    int64_t period;         // Length of a tick, in nanoseconds
+    int64_t deadline;       // Time of the next tick, in nanoseconds of CLOCK_MONOTONIC
+    uint64_t late;          // Number of ticks that started a whole period or more after their deadline
+    uint64_t dropped;       // Number of ticks given up to catch up
+    int64_t worst_lag;      // Longest delay between a deadline and the start of its tick, in nanoseconds
+    int64_t busy;           // Time spent in advance_room(), in nanoseconds
+    int64_t worst_busy;     // Longest call to advance_room(), in nanoseconds
+    MONSTRO_TROOM_BOARD boards[MONSTRO_TROOM_BOARDS];
+} MONSTRO_TROOM;
+
+
+
+// Public function prototypes
+int init_room(MONSTRO_TROOM *room, uint64_t seed, int count);
+void advance_room(MONSTRO_TROOM *room, const uint8_t *inputs);
+int64_t wait_room(MONSTRO_TROOM *room);
+
+#endif
@@ -0,0 +1,89 @@
+/**
+ * @file monstro-tsched.h
+ * 
+ * @section LICENSE License
+ * 
+ * This is free and unencumbered software released into the public domain.
+ *
+ * Anyone is free to copy, modify, publish, use, compile, sell, or
+ * distribute this software, either in source code form or as a compiled
+ * binary, for any purpose, commercial or non-commercial, and by any
+ * means.
+ * 
+ * In jurisdictions that recognize copyright laws, the author or authors
+ * of this software dedicate any and all copyright interest in the
+ * software to the public domain. We make this dedication for the benefit
+ * of the public at large and to the detriment of our heirs and
+ * successors. We intend this dedication to be an overt act of
+ * relinquishment in perpetuity of all present and future rights to this
+ * software under copyright law.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+ * OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ * 
+ * For more information, please refer to <https://unlicense.org>
+ * 
+ * @section DESCRIPTION Description
+ * 
+ * This file contains the struct definitions and function prototypes for 
+ * the session scheduler in monstro-tsched.c.
+ */
+
+#ifndef MONSTRO_TSCHED_H
+#define MONSTRO_TSCHED_H
+
+#include <stdint.h>
+
+#define MONSTRO_TSCHED_SLOTS              256      // Number of slots of the timer wheel, a power of 2
+#define MONSTRO_TSCHED_RESOLUTION      250000      // Length of a slot, in nanoseconds
+#define MONSTRO_TSCHED_LATE           1000000      // Lag after which a tick counts as late, in nanoseconds
+#define MONSTRO_TSCHED_MAX_LATE             6      // Number of late periods after which a task gives up catching up
+
+
+
+// A task resumed once per period, such as a game session; see add_task()
+typedef struct MONSTRO_TTASK {
+    struct MONSTRO_TTASK *next, *prev;      // Tasks in the same slot of the wheel
+    int slot;               // Slot of the wheel holding the task
+// Resumes the task for one tick; returns false to remove it from the scheduler
+    int (*resume)(struct MONSTRO_TTASK *task);
+    void *data;             // Free for the owner of the task
+    int state;              // Free for the owner of the task, 0 when added
+    int64_t period;         // Time between ticks, in nanoseconds
+    int64_t deadline;       // Time of the next tick, in nanoseconds of CLOCK_MONOTONIC
+// Lag metrics; the lag of a tick is the delay between its deadline and 
+// the moment the task is resumed
+    uint64_t ticks;         // Number of ticks played
+    uint64_t late;          // Number of ticks with a lag over MONSTRO_TSCHED_LATE
+    uint64_t skipped;       // Number of ticks given up to catch up
+    int64_t last_lag;       // Lag of the last tick, in nanoseconds
+    int64_t worst_lag;      // Largest lag, in nanoseconds
+    int64_t total_lag;      // Sum of the lags of every tick, in nanoseconds
+} MONSTRO_TTASK;
+
+// Hashed timer wheel; see init_scheduler()
+typedef struct {
+    MONSTRO_TTASK *slots[MONSTRO_TSCHED_SLOTS];
+    int64_t slot;           // Number of the next slot to check, counting from time 0
+    int count;              // Number of tasks
+    uint64_t resumed;       // Number of calls to the resume functions
+    uint64_t wakeups;       // Number of times run_scheduler() slept and woke up
+    int64_t busy;           // Time spent resuming tasks, in nanoseconds
+} MONSTRO_TSCHEDULER;
+
+
+
+// Public function prototypes
+void init_scheduler(MONSTRO_TSCHEDULER *scheduler);
+int add_task(MONSTRO_TSCHEDULER *scheduler, MONSTRO_TTASK *task, int64_t start, int64_t period);
+void remove_task(MONSTRO_TSCHEDULER *scheduler, MONSTRO_TTASK *task);
+int64_t advance_scheduler(MONSTRO_TSCHEDULER *scheduler, int64_t now);
+void run_scheduler(MONSTRO_TSCHEDULER *scheduler, int64_t end);
+int64_t scheduler_time(void);
+
+#endif
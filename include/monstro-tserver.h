@@ -0,0 +1,60 @@
+/**
+ * @file monstro-tserver.h
+ * 
+ * @section LICENSE License
+ * 
+ * This is free and unencumbered software released into the public domain.
+ *
+ * Anyone is free to copy, modify, publish, use, compile, sell, or
+ * distribute this software, either in source code form or as a compiled
+ * binary, for any purpose, commercial or non-commercial, and by any
+ * means.
+ * 
+ * In jurisdictions that recognize copyright laws, the author or authors
+ * of this software dedicate any and all copyright interest in the
+ * software to the public domain. We make this dedication for the benefit
+ * of the public at large and to the detriment of our heirs and
+ * successors. We intend this dedication to be an overt act of
+ * relinquishment in perpetuity of all present and future rights to this
+ * software under copyright law.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+ * OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ * 
+ * For more information, please refer to <https://unlicense.org>
+ * 
+ * @section DESCRIPTION Description
+ * 
+ * This file contains the message types and sizes of the protocol used 
+ * between the game server in monstro-tserver.c and its clients, such 
+ * as the scripted client in monstro-tclient.c.
+ */
+
+#ifndef MONSTRO_TSERVER_H
+#define MONSTRO_TSERVER_H
+
+#include "monstro-tlogic.h"
+
+#define MONSTRO_TSERVER_PORT             7777      // Default TCP port
+
+// Client messages
+#define MONSTRO_TSERVER_START             'S'      // Seed, 8 bytes; starts a new game
+#define MONSTRO_TSERVER_INPUTS            'I'      // Number of inputs, 1 byte, then the inputs, 1 byte each
+#define MONSTRO_TSERVER_QUERY             'Q'      // No data; asks for a MONSTRO_TSERVER_CHECKSUM message
+
+// Server messages
+#define MONSTRO_TSERVER_DELTA             'D'      // State after a MONSTRO_TSERVER_START or MONSTRO_TSERVER_INPUTS message
+#define MONSTRO_TSERVER_CHECKSUM          'C'      // Ticks, lines, game_checksum() and game over flag of the game
+
+#define MONSTRO_TSERVER_MASK_SIZE          ((MONSTRO_TFIELD_SIZE + 7) / 8)
+#define MONSTRO_TSERVER_DELTA_HEADER       (12 + MONSTRO_TSERVER_MASK_SIZE)
+#define MONSTRO_TSERVER_DELTA_SIZE         (MONSTRO_TSERVER_DELTA_HEADER + MONSTRO_TFIELD_SIZE * sizeof(MONSTRO_TROW))
+#define MONSTRO_TSERVER_CHECKSUM_SIZE      22
+#define MONSTRO_TSERVER_INPUTS_SIZE        (2 + 255)
+
+#endif
@@ -0,0 +1,96 @@
+/**
+ * @file monstro-tsession.h
+ * 
+ * @section LICENSE License
+ * 
+ * This is free and unencumbered software released into the public domain.
+ *
+ * Anyone is free to copy, modify, publish, use, compile, sell, or
+ * distribute this software, either in source code form or as a compiled
+ * binary, for any purpose, commercial or non-commercial, and by any
+ * means.
+ * 
+ * In jurisdictions that recognize copyright laws, the author or authors
+ * of this software dedicate any and all copyright interest in the
+ * software to the public domain. We make this dedication for the benefit
+ * of the public at large and to the detriment of our heirs and
+ * successors. We intend this dedication to be an overt act of
+ * relinquishment in perpetuity of all present and future rights to this
+ * software under copyright law.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+ * OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ * 
+ * For more information, please refer to <https://unlicense.org>
+ * 
+ * @section DESCRIPTION Description
+ * 
+ * This file contains the struct definitions and function prototypes for 
+ * the rollback session in monstro-tsession.c.
+ */
+
+#ifndef MONSTRO_TSESSION_H
+#define MONSTRO_TSESSION_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "monstro-tlogic.h"
+
+#define MONSTRO_TSESSION_FRAMES            64      // Number of ticks of inputs and states kept, a power of 2
+#define MONSTRO_TSESSION_MAX_LAG           31      // Largest input delay plus rollback window
+#define MONSTRO_TSESSION_PACKET_SIZE       (31 + MONSTRO_TSESSION_FRAMES)
+
+
+
+// State of one player of a session
+typedef struct {
+    MONSTRO_TGAME game;
+    uint64_t lines;         // Number of lines cleared
+    int level_lines;        // Lines cleared since the last speed increase
+    int game_over;          // Set if a piece couldn't be spawned
+    uint64_t restarts;      // Number of times the game topped out and started over
+} MONSTRO_TSESSION_PLAYER;
+
+// Two player rollback session; see init_session()
+typedef struct {
+    MONSTRO_TSESSION_PLAYER players[2];
+    int local;              // Index of the local player, 0 or 1
+    int delay;              // Number of ticks between a local input and the tick it applies to
+    int window;             // Largest number of ticks simulated with predicted remote inputs
+    int restart;            // If set, a game that tops out starts over instead of stopping
+    uint64_t tick;          // Number of ticks simulated
+    uint64_t confirmed;     // Number of ticks with known remote inputs
+    uint64_t acked;         // Number of ticks with local inputs known by the remote peer
+    uint64_t rollback;      // First tick to simulate again, UINT64_MAX if none
+    int last_remote;        // Last known remote inputs, used to predict the next ones
+    uint8_t inputs[2][MONSTRO_TSESSION_FRAMES];
+    uint64_t remote_ticks[MONSTRO_TSESSION_FRAMES];     // Tick of each received remote input
+    MONSTRO_TSESSION_PLAYER states[MONSTRO_TSESSION_FRAMES][2];     // State of the players at the start of each tick
+// Desync detection
+    uint64_t checked;       // Number of ticks with a final checksum
+    uint32_t checksums[MONSTRO_TSESSION_FRAMES];    // Chained game_checksum() of both games after each tick
+    uint64_t remote_checked;        // Last checksum received from the remote peer, not compared yet
+    uint32_t remote_checksum;
+    uint64_t desync;        // First tick found with a different checksum on the remote peer, UINT64_MAX if none
+// Statistics
+    uint64_t rollbacks;     // Number of rollbacks
+    uint64_t resimulated;   // Number of ticks simulated again by rollbacks
+    uint64_t stalls;        // Number of calls to advance_session() that had to wait for the remote peer
+} MONSTRO_TSESSION;
+
+
+
+// Public function prototypes
+int init_session(MONSTRO_TSESSION *session, uint64_t seed, int local, int delay, int window);
+int advance_session(MONSTRO_TSESSION *session, int inputs);
+void rollback_session(MONSTRO_TSESSION *session);
+int add_remote_input(MONSTRO_TSESSION *session, uint64_t tick, int inputs);
+size_t write_packet(const MONSTRO_TSESSION *session, uint8_t *buffer);
+int read_packet(MONSTRO_TSESSION *session, const uint8_t *buffer, size_t size);
+
+#endif
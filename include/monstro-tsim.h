@@ -0,0 +1,76 @@
+/**
+ * @file monstro-tsim.h
+ * 
+ * @section LICENSE License
+ * 
+ * This is free and unencumbered software released into the public domain.
+ *
+ * Anyone is free to copy, modify, publish, use, compile, sell, or
+ * distribute this software, either in source code form or as a compiled
+ * binary, for any purpose, commercial or non-commercial, and by any
+ * means.
+ * 
+ * In jurisdictions that recognize copyright laws, the author or authors
+ * of this software dedicate any and all copyright interest in the
+ * software to the public domain. We make this dedication for the benefit
+ * of the public at large and to the detriment of our heirs and
+ * successors. We intend this dedication to be an overt act of
+ * relinquishment in perpetuity of all present and future rights to this
+ * software under copyright law.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+ * OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ * 
+ * For more information, please refer to <https://unlicense.org>
+ * 
+ * @section DESCRIPTION Description
+ * 
+ * This file contains the struct definitions and function prototypes for 
+ * the simulation runner in monstro-tsim.c.
+ */
+
+#ifndef MONSTRO_TSIM_H
+#define MONSTRO_TSIM_H
+
+#include <stdint.h>
+#include "monstro-tlogic.h"
+
+#define MONSTRO_TSIM_FLAGS                 16      // Number of action flag bits counted in MONSTRO_TSTATS
+
+
+
+// Description of a simulation; see run_simulation()
+typedef struct {
+    uint64_t seed;      // Game i is seeded with seed + i
+    uint32_t games;     // Number of games to play
+    uint64_t max_ticks; // Games still running after this many ticks are stopped; 0 means no limit
+    int threads;        // Number of threads; 0 means one per online CPU
+// Returns the inputs for the next call to mover_pieza(); it's called 
+// from several threads at once, so it must not modify data. When NULL, 
+// a built-in policy plays random inputs.
+    int (*policy)(const MONSTRO_TGAME *game, uint64_t tick, void *data);
+    void *data;
+} MONSTRO_TSIMULATION;
+
+// Statistics aggregated over every game of a simulation
+typedef struct {
+    uint64_t games;
+    uint64_t ticks;                         // Total number of calls to mover_pieza()
+    uint64_t pieces;                        // Total number of pieces spawned
+    uint64_t lines;                         // Total number of lines cleared
+    uint64_t clears[4];                     // Number of locks that cleared 1, 2, 3 and 4 lines
+    uint64_t flags[MONSTRO_TSIM_FLAGS];     // Number of ticks with each action flag bit set
+    uint64_t shortest, longest;             // Length of the shortest and longest games, in ticks
+} MONSTRO_TSTATS;
+
+
+
+// Public function prototypes
+int run_simulation(const MONSTRO_TSIMULATION *simulation, MONSTRO_TSTATS *stats);
+
+#endif
@@ -0,0 +1,88 @@
+/**
+ * @file monstro-tstream.h
+ * 
+ * @section LICENSE License
+ * 
+ * This is free and unencumbered software released into the public domain.
+ *
+ * Anyone is free to copy, modify, publish, use, compile, sell, or
+ * distribute this software, either in source code form or as a compiled
+ * binary, for any purpose, commercial or non-commercial, and by any
+ * means.
+ * 
+ * In jurisdictions that recognize copyright laws, the author or authors
+ * of this software dedicate any and all copyright interest in the
+ * software to the public domain. We make this dedication for the benefit
+ * of the public at large and to the detriment of our heirs and
+ * successors. We intend this dedication to be an overt act of
+ * relinquishment in perpetuity of all present and future rights to this
+ * software under copyright law.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+ * OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ * 
+ * For more information, please refer to <https://unlicense.org>
+ * 
+ * @section DESCRIPTION Description
+ * 
+ * This file contains the struct definitions and function prototypes for 
+ * the spectator stream encoder and decoder in monstro-tstream.c.
+ */
+
+#ifndef MONSTRO_TSTREAM_H
+#define MONSTRO_TSTREAM_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "monstro-tlogic.h"
+
+#define MONSTRO_TSTREAM_INTERVAL           60      // Default number of frames between keyframes
+#define MONSTRO_TSTREAM_MASK_SIZE          ((MONSTRO_TFIELD_SIZE + 7) / 8)
+#define MONSTRO_TSTREAM_FRAME_SIZE         (8 + MONSTRO_TSTREAM_MASK_SIZE + MONSTRO_TFIELD_SIZE * sizeof(MONSTRO_TROW))
+
+// Frame contents, in the first byte of each frame
+#define MONSTRO_TSTREAM_KEYFRAME          0x1      // Every row follows, instead of a mask and the changed rows
+#define MONSTRO_TSTREAM_ROWS              0x2      // A mask and the changed rows follow
+#define MONSTRO_TSTREAM_PIECE             0x4      // The piece, rotation and position follow
+#define MONSTRO_TSTREAM_FLAGS             0x8      // The game action flags follow
+
+
+
+// Encoder of the frames of one game; see init_stream()
+typedef struct {
+    MONSTRO_TROW locked[MONSTRO_TFIELD_SIZE];       // Playfield without the current piece, as of the last frame
+    int piece, rotation, x, y;                      // Current piece as of the last frame
+    uint16_t frame;         // Number of the next frame
+    int interval;           // Number of frames between keyframes, 0 for none
+    int countdown;          // Number of frames until the next keyframe
+// Statistics
+    uint64_t frames;        // Number of frames encoded
+    uint64_t keyframes;     // Number of keyframes encoded, including the ones from write_keyframe()
+    uint64_t bytes;         // Size of all the frames encoded
+} MONSTRO_TSTREAM;
+
+// Game as seen by a spectator; see init_view()
+typedef struct {
+    MONSTRO_TROW locked[MONSTRO_TFIELD_SIZE];
+    int piece, rotation, x, y;
+    int flags;              // Game action flags of the last frame
+    uint16_t frame;         // Number of the next frame expected
+    int synced;             // Set once a keyframe has been decoded, cleared when a frame is missed
+} MONSTRO_TVIEW;
+
+
+
+// Public function prototypes
+void init_stream(MONSTRO_TSTREAM *stream, int interval);
+size_t encode_frame(MONSTRO_TSTREAM *stream, const MONSTRO_TGAME *game, uint8_t *buffer);
+size_t write_keyframe(MONSTRO_TSTREAM *stream, uint8_t *buffer);
+void init_view(MONSTRO_TVIEW *view);
+int decode_frame(MONSTRO_TVIEW *view, const uint8_t *buffer, size_t size);
+void draw_view(const MONSTRO_TVIEW *view, MONSTRO_TROW *playfield);
+
+#endif
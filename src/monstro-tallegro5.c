@@ -45,6 +45,7 @@
 
 
 #define BLOCK_SIZE      32
+#define VISIBLE_ROWS    (MONSTRO_TFIELD_SIZE - 4)      // Top 4 rows are not visible
 
 
 
@@ -55,11 +56,7 @@ ALLEGRO_TIMER *timer = NULL;
 ALLEGRO_EVENT event;
 
 // Game global variables
-MONSTRO_TGAME game = { .playfield = { 0xFFFF, 0xE007, 0xE007, 0xE007, 0xE007, 0xE007, 
-                                      0xE007, 0xE007, 0xE007, 0xE007, 0xE007, 0xE007, 
-                                      0xE007, 0xE007, 0xE007, 0xE007, 0xE007, 0xE007, 
-                                      0xE007, 0xE007, 0xE007, 0xE007, 0xE007, 0xE007 }, 
-                      .snap_default = MONSTRO_TSNAP_LIMIT, .snap_index = 1, 
+MONSTRO_TGAME game = { .snap_default = MONSTRO_TSNAP_LIMIT, .snap_index = 1, 
                       .drop_default = MONSTRO_TDROP_LIMIT, .drop_index = 1, 
                       .move_default = MONSTRO_TMOVE_LIMIT, .move_index = 1};
 ALLEGRO_COLOR colors[8];
@@ -92,15 +89,15 @@ void draw_block(int x, int y, ALLEGRO_COLOR color) {
  * @param game A \c MONSTRO_TGAME struct representing the current game.
  */
 void draw_playfield(MONSTRO_TGAME *game) {
-    for (int y = 0; y < MONSTRO_TFIELD_SIZE - 4; y++)
-        for (int x = 0; x < 16; x++)
-            if (game->playfield[y] & (1 << x))
+    for (int y = 0; y < VISIBLE_ROWS; y++)
+        for (int x = 0; x < MONSTRO_TFIELD_WIDTH; x++)
+            if (game->playfield[y] & ((MONSTRO_TROW)1 << x))
             // Dibuja de un color distinto las celdas fijas del tablero, este es el tipo de coloreado que se puede utilizar 
             // para darle variedad de color al juego usando simplemente la informacion básica proporcionada por la variable 
             // playfield[]
-                if (x < 3 || x > 12 || y == 0)
-                    draw_block((15 - x) * BLOCK_SIZE, (19 - y) * BLOCK_SIZE, colors[7]);
-                else draw_block((15 - x) * BLOCK_SIZE, (19 - y) * BLOCK_SIZE, colors[0]);
+                if ((MONSTRO_TWALLS >> x) & 1 || y == 0)
+                    draw_block((MONSTRO_TFIELD_WIDTH - 1 - x) * BLOCK_SIZE, (VISIBLE_ROWS - 1 - y) * BLOCK_SIZE, colors[7]);
+                else draw_block((MONSTRO_TFIELD_WIDTH - 1 - x) * BLOCK_SIZE, (VISIBLE_ROWS - 1 - y) * BLOCK_SIZE, colors[0]);
 }
 
 
@@ -115,21 +112,21 @@ void draw_color_playfield(MONSTRO_TGAME *game) {
     int color;
 
 #ifdef MONSTRO_TWANT_COLORS    
-    for (int y = 0; y < MONSTRO_TFIELD_SIZE - 4; y++)
-        for (int x = 0; x < 16; x++) {
+    for (int y = 0; y < VISIBLE_ROWS; y++)
+        for (int x = 0; x < MONSTRO_TFIELD_WIDTH; x++) {
             color = game->color_playfield[y][x];
             if (color != -1)
-                draw_block((15 - x) * BLOCK_SIZE, (19 - y) * BLOCK_SIZE, colors[color]);
+                draw_block((MONSTRO_TFIELD_WIDTH - 1 - x) * BLOCK_SIZE, (VISIBLE_ROWS - 1 - y) * BLOCK_SIZE, colors[color]);
         }
     
 // Use a dummy playfield to place and draw the current piece.
-    static uint16_t dummy[24] = {0};
+    static MONSTRO_TROW dummy[MONSTRO_TFIELD_SIZE] = {0};
     color = game->piece;
     poner_pieza(dummy, game->current_piece, game->x, game->y);
     for (int y = 0; y < MONSTRO_TFIELD_SIZE; y++)
-        for (int x = 0; x < 16; x++)
-            if (dummy[y] & (1 << x))
-                draw_block((15 - x) * BLOCK_SIZE, (19 - y) * BLOCK_SIZE, colors[color]);
+        for (int x = 0; x < MONSTRO_TFIELD_WIDTH; x++)
+            if (dummy[y] & ((MONSTRO_TROW)1 << x))
+                draw_block((MONSTRO_TFIELD_WIDTH - 1 - x) * BLOCK_SIZE, (VISIBLE_ROWS - 1 - y) * BLOCK_SIZE, colors[color]);
     borrar_pieza(dummy, game->current_piece, game->x, game->y);
 #endif
 }
@@ -142,7 +139,7 @@ void draw_color_playfield(MONSTRO_TGAME *game) {
  * @param game A \c MONSTRO_TGAME struct representing the current game.
  */
 static void draw_opengl(MONSTRO_TGAME *game) {
-    int width = 16 * BLOCK_SIZE, height = 20 * BLOCK_SIZE;
+    int width = MONSTRO_TFIELD_WIDTH * BLOCK_SIZE, height = VISIBLE_ROWS * BLOCK_SIZE;
 
 #ifdef MONSTRO_TWANT_OPENGL
     glEnable(GL_TEXTURE_2D);    
@@ -159,7 +156,7 @@ static void draw_opengl(MONSTRO_TGAME *game) {
     glPixelMapfv(GL_PIXEL_MAP_I_TO_B, 2, index);
     glPixelMapfv(GL_PIXEL_MAP_I_TO_A, 2, index);
 
-    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, 16, 24, 0, GL_COLOR_INDEX, GL_BITMAP, game->playfield);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, MONSTRO_TFIELD_WIDTH, MONSTRO_TFIELD_SIZE, 0, GL_COLOR_INDEX, GL_BITMAP, game->playfield);
 
     // glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
     // glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
@@ -197,20 +194,14 @@ void logic(MONSTRO_TGAME *game, ALLEGRO_EVENT *event) {
         }
         if (game->flags & MONSTRO_TACTION_CLEARED) {
         // Count cleared lines and increase speed every few lines
-            total_lines += (game->flags & MONSTRO_TACTION_CLEARED0) ? 1 : 0;
-            total_lines += (game->flags & MONSTRO_TACTION_CLEARED1) ? 1 : 0;
-            total_lines += (game->flags & MONSTRO_TACTION_CLEARED2) ? 1 : 0;
-            total_lines += (game->flags & MONSTRO_TACTION_CLEARED3) ? 1 : 0;
-            if (total_lines > 10) {
-                total_lines -= 10;
-                game->drop_default /= 2;
-                game->snap_default -= game->snap_default / 8;
-            }
+            level_up(game, &total_lines, __builtin_popcount(game->flags & MONSTRO_TACTION_CLEARED));
         }
         redraw = true;
     }
     else if (event->any.source == al_get_keyboard_event_source()) {
         if (event->type == ALLEGRO_EVENT_KEY_DOWN) {
+            if (event->keyboard.keycode == ALLEGRO_KEY_UP)
+                game->inputs |= MONSTRO_TINPUT_UP;
             if (event->keyboard.keycode == ALLEGRO_KEY_DOWN)
                 game->inputs |= MONSTRO_TINPUT_DOWN;
             if (event->keyboard.keycode == ALLEGRO_KEY_LEFT)
@@ -261,7 +252,7 @@ void initialization() {
     assert(al_install_keyboard());
     al_set_new_display_flags(ALLEGRO_WINDOWED);
     al_set_new_window_title("monstrominos by monstrochan");
-    display = al_create_display(16 * BLOCK_SIZE, 20 * BLOCK_SIZE);
+    display = al_create_display(MONSTRO_TFIELD_WIDTH * BLOCK_SIZE, VISIBLE_ROWS * BLOCK_SIZE);
     assert(display);
     assert(al_init_primitives_addon());
 
@@ -273,9 +264,10 @@ void initialization() {
     al_register_event_source(events, al_get_keyboard_event_source());
     al_register_event_source(events, al_get_timer_event_source(timer));
     
-    srand(time(NULL));
+    seed_game(&game, time(NULL));
     
 // Inicialización del tablero
+    init_playfield(&game);
     colors[0] = al_map_rgb(255, 0, 0);
     colors[7] = al_map_rgb(0, 128, 0);      // Playfield walls' color
 #ifdef MONSTRO_TWANT_COLORS
@@ -288,6 +280,12 @@ void initialization() {
     colors[6] = al_map_rgb(255,   0,   0);
     colors[7] = al_map_rgb(255, 128, 192);  // Playfield walls' color
     init_color_playfield(&game);
+#endif
+#ifdef MONSTRO_TWANT_COLUMNS
+    init_columns(&game);
+#endif
+#ifdef MONSTRO_TWANT_HASH
+    init_hash(&game);
 #endif
     spawn_piece(&game);
 }
@@ -0,0 +1,534 @@
+/**
+ * @file monstro-tarchive.c
+ * 
+ * @section LICENSE License
+ * 
+ * This is free and unencumbered software released into the public domain.
+ *
+ * Anyone is free to copy, modify, publish, use, compile, sell, or
+ * distribute this software, either in source code form or as a compiled
+ * binary, for any purpose, commercial or non-commercial, and by any
+ * means.
+ * 
+ * In jurisdictions that recognize copyright laws, the author or authors
+ * of this software dedicate any and all copyright interest in the
+ * software to the public domain. We make this dedication for the benefit
+ * of the public at large and to the detriment of our heirs and
+ * successors. We intend this dedication to be an overt act of
+ * relinquishment in perpetuity of all present and future rights to this
+ * software under copyright law.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+ * OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ * 
+ * For more information, please refer to <https://unlicense.org>
+ * 
+ * @section DESCRIPTION Description
+ * 
+ * This file contains an optional archive that stores many replays in a 
+ * single append-only file, available only when \c MONSTRO_TWANT_ARCHIVE 
+ * is defined. Along with each replay, the archive stores a keyframe 
+ * every few thousand ticks: a snapshot of the game plus the position 
+ * of the player within the replay. Readers map the whole archive in 
+ * memory, so replays can be read in place without copying them, and 
+ * seek_replay() gets to any tick of any replay by restoring the closest 
+ * keyframe and re-simulating only the ticks after it:
+ * 
+ *      open_archive_writer(&writer, "games.mta");
+ *      append_replay(&writer, recorder.data, size, MONSTRO_TARCHIVE_INTERVAL);
+ *      close_archive_writer(&writer);
+ * 
+ *      ...
+ *      open_archive(&archive, "games.mta");
+ *      // The state of the game after the first 100000 ticks of replay i
+ *      if (seek_replay(&archive, i, 100000, &game, &cursor, &result) == MONSTRO_TREPLAY_PAUSED)
+ *          ...
+ *      close_archive(&archive);
+ * 
+ * @section FORMAT Archive format
+ * 
+ * Every value is stored in little endian order and every section starts 
+ * at a multiple of 8 bytes. The archive starts with a 16 byte header: 
+ * the characters \c MTRA, the format version, the playfield size, width 
+ * and well width, and the size of the keyframes as a 32 bit value.
+ * Entries follow, one per replay:
+ * 
+ *      Offset  Size  Contents
+ *      0       4     The characters MTRE
+ *      4       4     Number of keyframes, K
+ *      8       8     Size of the replay, R
+ *      16      8     Number of ticks of the replay
+ *      24      8     Seed of the replay
+ *      32      R     The replay, padded to a multiple of 8 bytes
+ *      ...     K*F   The keyframes, sorted by tick
+ * 
+ * A keyframe holds the tick, the offset of the next record within the 
+ * replay, the ticks left in the current run and the pieces, lines and 
+ * checkpoints counted so far, as 64 bit values, followed by the inputs 
+ * of the current run and the game over flag, one byte each, and by 
+ * \c MONSTRO_TSNAPSHOT_SIZE bytes of save_snapshot(), padded to 8 bytes.
+ * 
+ * The offsets of the entries are kept in a separate index file, with 
+ * the same name plus \c .idx, as an array of 64 bit values. Both files 
+ * are only ever appended to, the archive first, so the index may miss 
+ * the last entries if the writer was interrupted; open_archive() finds 
+ * them by walking the archive from the last indexed entry and updates 
+ * the index, and open_archive_writer() also drops a partially written 
+ * entry at the end of the archive.
+ */
+
+#define _FILE_OFFSET_BITS 64
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "monstro-tarchive.h"
+#include "monstro-tbytes.h"
+
+#define HEADER_SIZE         16
+#define ENTRY_SIZE          32      // Size of the header of an entry
+#define KEYFRAME_HEADER     56      // Size of a keyframe before its snapshot
+#define KEYFRAME_SIZE       PADDED(KEYFRAME_HEADER + MONSTRO_TSNAPSHOT_SIZE)
+#define PADDED(n)           (((n) + 7) & ~(uint64_t)7)
+
+static const uint8_t magic[4] = {'M', 'T', 'R', 'A'};
+static const uint8_t entry_magic[4] = {'M', 'T', 'R', 'E'};
+
+
+
+static void archive_header(uint8_t *header) {
+    memset(header, 0, HEADER_SIZE);
+    memcpy(header, magic, sizeof(magic));
+    header[4] = MONSTRO_TARCHIVE_VERSION;
+    header[5] = MONSTRO_TFIELD_SIZE;
+    header[6] = MONSTRO_TFIELD_WIDTH;
+    header[7] = MONSTRO_TWELL_WIDTH;
+    put_le(header + 8, KEYFRAME_SIZE, 4);
+}
+
+
+
+/**
+ * Returns the size of the entry at \c offset, or \c 0 if there's no 
+ * complete entry there.
+ */
+static uint64_t entry_size(const uint8_t *data, uint64_t size, uint64_t offset) {
+    if (offset < HEADER_SIZE || offset % 8 != 0 || offset > size || size - offset < ENTRY_SIZE || 
+        memcmp(data + offset, entry_magic, sizeof(entry_magic)) != 0)
+        return 0;
+    uint64_t keyframes = get_le(data + offset + 4, 4);
+    uint64_t replay = get_le(data + offset + 8, 8);
+    if (replay > size)
+        return 0;
+    uint64_t total = ENTRY_SIZE + PADDED(replay) + keyframes * KEYFRAME_SIZE;
+    return (total <= size - offset) ? total : 0;
+}
+
+
+
+static int write_at(int file, const uint8_t *data, uint64_t size, uint64_t offset) {
+    while (size > 0) {
+        ssize_t written = pwrite(file, data, size, offset);
+        if (written <= 0)
+            return false;
+        data += written;
+        size -= written;
+        offset += written;
+    }
+    return true;
+}
+
+
+
+/**
+ * Opens an archive for reading, mapping it in memory.
+ * 
+ * If the index is missing entries at its end, they are found by walking 
+ * the archive and the index is updated, or rebuilt in memory if its file 
+ * can't be written.
+ * 
+ * @param archive   A \c MONSTRO_TARCHIVE struct to initialize.
+ * @param path      The path of the archive.
+ * @return          \c true if the archive was opened, \c false if it 
+ *                  couldn't be read or mapped, or if it was created by 
+ *                  a build with different playfield dimensions or 
+ *                  snapshot sections.
+ */
+int open_archive(MONSTRO_TARCHIVE *archive, const char *path) {
+    size_t length = strlen(path);
+    char *index_path = malloc(length + 5);
+    struct stat info;
+    uint64_t index_size;
+    int file, index = -1, writable;
+    
+    memset(archive, 0, sizeof(*archive));
+    if (!index_path)
+        return false;
+    memcpy(index_path, path, length);
+    memcpy(index_path + length, ".idx", 5);
+    
+    file = open(path, O_RDONLY);
+    if (file < 0 || fstat(file, &info) != 0 || info.st_size < HEADER_SIZE)
+        goto fail;
+    void *data = mmap(NULL, info.st_size, PROT_READ, MAP_SHARED, file, 0);
+    if (data == MAP_FAILED)
+        goto fail;
+    archive->data = data;
+    archive->size = info.st_size;
+    close(file);
+    file = -1;
+    
+    uint8_t header[HEADER_SIZE];
+    archive_header(header);
+    if (memcmp(archive->data, header, HEADER_SIZE) != 0)
+        goto fail;
+    
+    index = open(index_path, O_RDWR | O_CREAT, 0644);
+    if (index < 0)
+        index = open(index_path, O_RDONLY);
+    if (index < 0 || fstat(index, &info) != 0)
+        info.st_size = 0;
+    writable = index >= 0 && (fcntl(index, F_GETFL) & O_ACCMODE) == O_RDWR;
+    index_size = info.st_size;
+    archive->count = index_size / 8;
+    if (archive->count > 0) {
+        void *mapped = mmap(NULL, archive->count * 8, PROT_READ, MAP_SHARED, index, 0);
+        if (mapped == MAP_FAILED)
+            goto fail;
+        archive->index = mapped;
+        archive->index_mapping = archive->count * 8;
+    }
+    
+// Only the last indexed entry is checked, the archive is append-only
+    archive->end = HEADER_SIZE;
+    while (archive->count > 0) {
+        uint64_t offset = get_le(archive->index + (archive->count - 1) * 8, 8);
+        uint64_t size = entry_size(archive->data, archive->size, offset);
+        if (size > 0) {
+            archive->end = offset + size;
+            break;
+        }
+        archive->count--;
+    }
+    
+    uint64_t indexed = archive->count, found = 0;
+    for (uint64_t offset = archive->end, size; (size = entry_size(archive->data, archive->size, offset)) > 0; offset += size)
+        found++;
+    if (found == 0 && (!writable || archive->count * 8 == index_size))
+        goto done;
+    
+    uint8_t *offsets = malloc((indexed + found) * 8 + 1);
+    if (!offsets)
+        goto fail;
+    if (indexed > 0)
+        memcpy(offsets, archive->index, indexed * 8);
+    for (uint64_t offset = archive->end, size; (size = entry_size(archive->data, archive->size, offset)) > 0; offset += size) {
+        put_le(offsets + archive->count++ * 8, offset, 8);
+        archive->end = offset + size;
+    }
+    if (archive->index_mapping > 0)
+        munmap((void *)archive->index, archive->index_mapping);
+    archive->index_mapping = 0;
+    archive->index = offsets;
+    archive->index_copy = offsets;
+    
+// Bring the index file up to date; if it can't be written, the copy 
+// in memory is used instead
+    if (writable && ftruncate(index, indexed * 8) == 0 && 
+        write_at(index, offsets + indexed * 8, found * 8, indexed * 8)) {
+        archive->index = NULL;
+        archive->index_copy = NULL;
+        free(offsets);
+        if (archive->count > 0) {
+            void *mapped = mmap(NULL, archive->count * 8, PROT_READ, MAP_SHARED, index, 0);
+            if (mapped == MAP_FAILED)
+                goto fail;
+            archive->index = mapped;
+            archive->index_mapping = archive->count * 8;
+        }
+    }
+    
+done:
+    if (index >= 0)
+        close(index);
+    free(index_path);
+    return true;
+    
+fail:
+    if (file >= 0)
+        close(file);
+    if (index >= 0)
+        close(index);
+    free(index_path);
+    close_archive(archive);
+    return false;
+}
+
+
+
+/**
+ * Closes an archive opened with open_archive().
+ * 
+ * @param archive   A \c MONSTRO_TARCHIVE struct representing the archive.
+ */
+void close_archive(MONSTRO_TARCHIVE *archive) {
+    if (archive->index_copy)
+        free(archive->index_copy);
+    else if (archive->index_mapping > 0)
+        munmap((void *)archive->index, archive->index_mapping);
+    if (archive->data)
+        munmap((void *)archive->data, archive->size);
+    memset(archive, 0, sizeof(*archive));
+}
+
+
+
+/**
+ * Gets a replay from an archive, without copying it.
+ * 
+ * @param archive   A \c MONSTRO_TARCHIVE struct representing the archive.
+ * @param i         The index of the replay, from \c 0 to \c archive->count - 1.
+ * @param replay    Where to store the address of the replay, which stays 
+ *                  valid until the archive is closed.
+ * @param size      Where to store the size of the replay.
+ * @return          \c true if the replay exists.
+ */
+int archive_replay(const MONSTRO_TARCHIVE *archive, uint64_t i, const uint8_t **replay, size_t *size) {
+    if (i >= archive->count)
+        return false;
+    uint64_t offset = get_le(archive->index + i * 8, 8);
+    if (entry_size(archive->data, archive->size, offset) == 0)
+        return false;
+    *replay = archive->data + offset + ENTRY_SIZE;
+    *size = get_le(archive->data + offset + 8, 8);
+    return true;
+}
+
+
+
+/**
+ * Plays a replay of an archive up to a given tick, starting from the 
+ * last keyframe before it.
+ * 
+ * The outcome is the same as calling start_replay() and then 
+ * continue_replay() up to \c tick, so the replay can be resumed from 
+ * there by calling continue_replay() with the same \c cursor and 
+ * \c result, using the replay returned by archive_replay().
+ * 
+ * @param archive   A \c MONSTRO_TARCHIVE struct representing the archive.
+ * @param i         The index of the replay.
+ * @param tick      The tick to seek.
+ * @param game      A \c MONSTRO_TGAME struct where the game will be played.
+ * @param cursor    A \c MONSTRO_TREPLAY_CURSOR struct where the position 
+ *                  within the replay will be stored.
+ * @param result    A \c MONSTRO_TREPLAY_RESULT struct where the outcome 
+ *                  of the replay will be stored.
+ * @return          \c MONSTRO_TREPLAY_PAUSED if the game is at \c tick, 
+ *                  \c MONSTRO_TREPLAY_OK if the replay ends before it, 
+ *                  or any other result of continue_replay() on error.
+ */
+int seek_replay(const MONSTRO_TARCHIVE *archive, uint64_t i, uint64_t tick, MONSTRO_TGAME *game, 
+                MONSTRO_TREPLAY_CURSOR *cursor, MONSTRO_TREPLAY_RESULT *result) {
+    const uint8_t *replay;
+    size_t size;
+    
+    if (!archive_replay(archive, i, &replay, &size))
+        return MONSTRO_TREPLAY_CORRUPT;
+    int outcome = start_replay(replay, size, game, cursor, result);
+    if (outcome != MONSTRO_TREPLAY_PAUSED)
+        return outcome;
+    
+// Binary search for the last keyframe at or before the tick
+    const uint8_t *keyframes = replay + PADDED(size);
+    uint64_t low = 0, high = get_le(replay - ENTRY_SIZE + 4, 4);
+    while (low < high) {
+        uint64_t middle = low + (high - low) / 2;
+        if (get_le(keyframes + middle * KEYFRAME_SIZE, 8) <= tick)
+            low = middle + 1;
+        else
+            high = middle;
+    }
+    if (low > 0) {
+        const uint8_t *keyframe = keyframes + (low - 1) * KEYFRAME_SIZE;
+        if (!restore_snapshot(game, keyframe + KEYFRAME_HEADER, MONSTRO_TSNAPSHOT_SIZE))
+            return MONSTRO_TREPLAY_CORRUPT;
+        result->ticks = get_le(keyframe, 8);
+        cursor->offset = get_le(keyframe + 8, 8);
+        cursor->run = get_le(keyframe + 16, 8);
+        result->pieces = get_le(keyframe + 24, 8);
+        result->lines = get_le(keyframe + 32, 8);
+        result->checkpoints = get_le(keyframe + 40, 8);
+        cursor->inputs = keyframe[48];
+        result->game_over = keyframe[49];
+        cursor->spawn = false;
+    }
+    
+    return continue_replay(replay, size, game, cursor, result, tick);
+}
+
+
+
+/**
+ * Opens an archive for appending replays, creating it if it doesn't 
+ * exist.
+ * 
+ * @param writer    A \c MONSTRO_TARCHIVE_WRITER struct to initialize.
+ * @param path      The path of the archive.
+ * @return          \c true if the archive was opened, \c false if it 
+ *                  couldn't be created or it isn't a valid archive for 
+ *                  this build.
+ */
+int open_archive_writer(MONSTRO_TARCHIVE_WRITER *writer, const char *path) {
+    size_t length = strlen(path);
+    char *index_path = malloc(length + 5);
+    struct stat info;
+    
+    writer->file = writer->index = -1;
+    if (!index_path)
+        return false;
+    memcpy(index_path, path, length);
+    memcpy(index_path + length, ".idx", 5);
+    
+    writer->file = open(path, O_RDWR | O_CREAT, 0644);
+    if (writer->file < 0 || fstat(writer->file, &info) != 0)
+        goto fail;
+    if (info.st_size == 0) {
+        uint8_t header[HEADER_SIZE];
+        archive_header(header);
+        if (!write_at(writer->file, header, HEADER_SIZE, 0))
+            goto fail;
+        writer->size = HEADER_SIZE;
+        writer->count = 0;
+    }
+    else {
+    // Let the reader validate the archive and update its index, then 
+    // drop anything after the last complete entry
+        MONSTRO_TARCHIVE archive;
+        if (!open_archive(&archive, path) || archive.index_copy) {
+            close_archive(&archive);
+            goto fail;
+        }
+        writer->size = archive.end;
+        writer->count = archive.count;
+        close_archive(&archive);
+        if (ftruncate(writer->file, writer->size) != 0)
+            goto fail;
+    }
+    
+    writer->index = open(index_path, O_WRONLY | O_CREAT, 0644);
+    if (writer->index < 0 || ftruncate(writer->index, writer->count * 8) != 0)
+        goto fail;
+    free(index_path);
+    return true;
+    
+fail:
+    free(index_path);
+    close_archive_writer(writer);
+    return false;
+}
+
+
+
+/**
+ * Appends a replay to an archive, along with its keyframes.
+ * 
+ * The replay is played back to take the keyframes, so only replays that 
+ * play to the end without desyncs are appended.
+ * 
+ * @param writer    A \c MONSTRO_TARCHIVE_WRITER struct representing the archive.
+ * @param replay    The replay.
+ * @param size      The size of the replay, in bytes.
+ * @param interval  The number of ticks between keyframes, 0 for none.
+ * @return          \c true if the replay was appended, \c false if it 
+ *                  didn't play back or it couldn't be written.
+ */
+int append_replay(MONSTRO_TARCHIVE_WRITER *writer, const uint8_t *replay, size_t size, uint64_t interval) {
+    MONSTRO_TGAME game;
+    MONSTRO_TREPLAY_CURSOR cursor;
+    MONSTRO_TREPLAY_RESULT result;
+    uint64_t keyframes = 0, capacity = 16;
+    uint8_t *entry = malloc(ENTRY_SIZE + PADDED(size) + capacity * KEYFRAME_SIZE);
+    int outcome, written = false;
+    
+    if (!entry)
+        return false;
+    outcome = start_replay(replay, size, &game, &cursor, &result);
+    while (outcome == MONSTRO_TREPLAY_PAUSED) {
+        outcome = continue_replay(replay, size, &game, &cursor, &result, 
+                                  (interval > 0) ? result.ticks + interval : UINT64_MAX);
+        if (outcome != MONSTRO_TREPLAY_PAUSED)
+            break;
+        
+        if (keyframes == capacity) {
+            uint8_t *grown = realloc(entry, ENTRY_SIZE + PADDED(size) + capacity * 2 * KEYFRAME_SIZE);
+            if (!grown)
+                goto done;
+            entry = grown;
+            capacity *= 2;
+        }
+    // Pausing spawns the pending piece, so cursor.spawn is always clear here
+        uint8_t *keyframe = entry + ENTRY_SIZE + PADDED(size) + keyframes * KEYFRAME_SIZE;
+        memset(keyframe, 0, KEYFRAME_SIZE);
+        if (save_snapshot(&game, keyframe + KEYFRAME_HEADER) == 0)
+            continue;
+        put_le(keyframe, result.ticks, 8);
+        put_le(keyframe + 8, cursor.offset, 8);
+        put_le(keyframe + 16, cursor.run, 8);
+        put_le(keyframe + 24, result.pieces, 8);
+        put_le(keyframe + 32, result.lines, 8);
+        put_le(keyframe + 40, result.checkpoints, 8);
+        keyframe[48] = cursor.inputs;
+        keyframe[49] = result.game_over;
+        keyframes++;
+    }
+    if (outcome != MONSTRO_TREPLAY_OK || keyframes > UINT32_MAX)
+        goto done;
+    
+    memcpy(entry, entry_magic, sizeof(entry_magic));
+    put_le(entry + 4, keyframes, 4);
+    put_le(entry + 8, size, 8);
+    put_le(entry + 16, result.ticks, 8);
+    put_le(entry + 24, result.seed, 8);
+    memcpy(entry + ENTRY_SIZE, replay, size);
+    memset(entry + ENTRY_SIZE + size, 0, PADDED(size) - size);
+    
+// The archive is written first, so an interrupted append leaves at most 
+// an unindexed entry that the next open_archive() will find
+    uint64_t total = ENTRY_SIZE + PADDED(size) + keyframes * KEYFRAME_SIZE;
+    uint8_t offset[8];
+    put_le(offset, writer->size, 8);
+    if (!write_at(writer->file, entry, total, writer->size))
+        goto done;
+    written = write_at(writer->index, offset, 8, writer->count * 8);
+    writer->size += total;
+    writer->count++;
+    
+done:
+    free(entry);
+    return written;
+}
+
+
+
+/**
+ * Closes an archive opened with open_archive_writer().
+ * 
+ * @param writer    A \c MONSTRO_TARCHIVE_WRITER struct representing the archive.
+ */
+void close_archive_writer(MONSTRO_TARCHIVE_WRITER *writer) {
+    if (writer->file >= 0)
+        close(writer->file);
+    if (writer->index >= 0)
+        close(writer->index);
+    writer->file = writer->index = -1;
+}
@@ -0,0 +1,467 @@
+/**
+ * @file monstro-tbatch.c
+ * 
+ * @section LICENSE License
+ * 
+ * This is free and unencumbered software released into the public domain.
+ *
+ * Anyone is free to copy, modify, publish, use, compile, sell, or
+ * distribute this software, either in source code form or as a compiled
+ * binary, for any purpose, commercial or non-commercial, and by any
+ * means.
+ * 
+ * In jurisdictions that recognize copyright laws, the author or authors
+ * of this software dedicate any and all copyright interest in the
+ * software to the public domain. We make this dedication for the benefit
+ * of the public at large and to the detriment of our heirs and
+ * successors. We intend this dedication to be an overt act of
+ * relinquishment in perpetuity of all present and future rights to this
+ * software under copyright law.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+ * OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ * 
+ * For more information, please refer to <https://unlicense.org>
+ * 
+ * @section DESCRIPTION Description
+ * 
+ * This file contains an optional batch engine, available only when 
+ * \c MONSTRO_TWANT_BATCH is defined, that advances many games by one 
+ * tick per call, meant for programs such as reinforcement learning 
+ * environments that step thousands of games in lockstep.
+ * 
+ * The games in a \c MONSTRO_TBATCH are stored as parallel arrays, one 
+ * per field of \c MONSTRO_TGAME, so mover_piezas() can run the input 
+ * handling, horizontal movement and vertical movement of several games 
+ * at once, 4 with SSE2 or 8 with AVX2, using GCC vector extensions: 
+ * every branch of handle_inputs(), horizontal_movement() and 
+ * vertical_movement() in monstro-tlogic.c becomes a comparison that 
+ * produces a lane mask and a blend between both outcomes. Then, for 
+ * each game, the candidate position is verified against its playfield, 
+ * which is the only part that needs the core functions. Each playfield 
+ * has \c MONSTRO_TBATCH_GUARD spare rows below and above it, so this 
+ * step can read the rows around the piece without bounds checks.
+ * 
+ * Games whose inputs include a hard drop or a rotation, or that play 
+ * with 20G gravity (\c drop_default equal to \c 0), take the slow path 
+ * instead: they are copied into a \c MONSTRO_TGAME and handed to 
+ * mover_pieza(). Either way, the gameplay is exactly the same as 
+ * calling mover_pieza() on each game.
+ * 
+ * A batch is used as follows:
+ * 
+ *      MONSTRO_TBATCH batch;
+ *      init_batch(&batch, count);
+ *      for (int i = 0; i < count; i++) {
+ *          // Set up each game as usual and copy it into the batch
+ *          init_playfield(&game);
+ *          seed_game(&game, seed + i);
+ *          spawn_piece(&game);
+ *          set_game(&batch, i, &game);
+ *      }
+ * 
+ *      ...
+ *      // At each tick, set the inputs of every game and step them all
+ *      for (int i = 0; i < count; i++)
+ *          batch.inputs[i] = inputs_for_game(i);
+ *      mover_piezas(&batch);
+ *      for (int i = 0; i < count; i++)
+ *          if (batch.flags[i] & MONSTRO_TACTION_SPAWN)
+ *              spawn_piece_batch(&batch, i);
+ * 
+ *      ...
+ *      free_batch(&batch);
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include "monstro-tbatch.h"
+#include "monstro-tpieces.h"
+
+#if defined(__AVX2__)
+#define LANES           8       // Games per vector; MONSTRO_TBATCH_LANES must be a multiple of it
+#else
+#define LANES           4
+#endif
+#define BLOCK           256     // Games per pass of mover_piezas(), small enough for its buffers to stay in the L1 cache
+#define ALIGNMENT       64
+#define ARRAY_SIZE(n)   (((n) + ALIGNMENT - 1) & ~(size_t)(ALIGNMENT - 1))
+
+typedef int32_t LANE_VECTOR __attribute__((vector_size(LANES * sizeof(int32_t))));
+
+// Vector comparisons give -1 for the lanes where they're true and 0 
+// elsewhere, so this picks a where the mask is set and b where it isn't
+#define BLEND(mask, a, b)   (((mask) & (a)) | (~(mask) & (b)))
+
+
+
+/**
+ * Loads \c LANES consecutive values of an array into a vector.
+ */
+static inline LANE_VECTOR load_lanes(const int32_t *array) {
+    LANE_VECTOR v;
+    memcpy(&v, array, sizeof(v));
+    return v;
+}
+
+
+
+/**
+ * Stores a vector into \c LANES consecutive values of an array.
+ */
+static inline void store_lanes(int32_t *array, LANE_VECTOR v) {
+    memcpy(array, &v, sizeof(v));
+}
+
+
+
+/**
+ * Returns the playfield of a game in the batch.
+ */
+static inline MONSTRO_TROW *batch_playfield(const MONSTRO_TBATCH *batch, int i) {
+    return batch->playfields + (size_t)i * MONSTRO_TBATCH_STRIDE;
+}
+
+
+
+/**
+ * Allocates a batch of games.
+ * 
+ * Every array of the batch is allocated in a single block, aligned to 
+ * a cache line and zeroed; each game must then be set up with 
+ * set_game() before the first call to mover_piezas().
+ * 
+ * @param batch A \c MONSTRO_TBATCH struct to initialize.
+ * @param count The number of games in the batch.
+ * @return      \c true if the batch was allocated, otherwise \c false.
+ */
+int init_batch(MONSTRO_TBATCH *batch, int count) {
+    int capacity = (count + MONSTRO_TBATCH_LANES - 1) / MONSTRO_TBATCH_LANES * MONSTRO_TBATCH_LANES;
+    size_t playfields = ARRAY_SIZE((size_t)capacity * MONSTRO_TBATCH_STRIDE * sizeof(MONSTRO_TROW));
+    size_t counters = ARRAY_SIZE((size_t)capacity * sizeof(int32_t));
+    size_t states = ARRAY_SIZE((size_t)capacity * sizeof(uint64_t));
+    size_t size = playfields + 13 * counters + states;
+    uint8_t *memory;
+    
+    if (count <= 0 || posix_memalign((void **)&memory, ALIGNMENT, size) != 0)
+        return false;
+    memset(memory, 0, size);
+    
+    batch->count = count;
+    batch->capacity = capacity;
+    batch->memory = memory;
+    batch->playfields = (MONSTRO_TROW *)memory + MONSTRO_TBATCH_GUARD;
+    memory += playfields;
+    int32_t **arrays[] = {
+        &batch->piece, &batch->rotation, &batch->x, &batch->y, &batch->inputs, &batch->flags, 
+        &batch->snap_default, &batch->snap_count, &batch->drop_default, &batch->drop_count, 
+        &batch->move_default, &batch->move_count, &batch->move_index
+    };
+    for (size_t a = 0; a < sizeof(arrays) / sizeof(arrays[0]); a++) {
+        *arrays[a] = (int32_t *)memory;
+        memory += counters;
+    }
+    batch->random_state = (uint64_t *)memory;
+    
+    return true;
+}
+
+
+
+/**
+ * Frees a batch of games allocated with init_batch().
+ * 
+ * @param batch A \c MONSTRO_TBATCH struct representing the batch.
+ */
+void free_batch(MONSTRO_TBATCH *batch) {
+    free(batch->memory);
+    batch->memory = NULL;
+    batch->count = batch->capacity = 0;
+}
+
+
+
+/**
+ * Copies a game into the batch.
+ * 
+ * @param batch A \c MONSTRO_TBATCH struct representing the batch.
+ * @param i     The index of the game in the batch.
+ * @param game  A \c MONSTRO_TGAME struct representing the game to copy.
+ */
+void set_game(MONSTRO_TBATCH *batch, int i, const MONSTRO_TGAME *game) {
+    memcpy(batch_playfield(batch, i), game->playfield, sizeof(game->playfield));
+    batch->piece[i] = game->piece;
+    batch->rotation[i] = game->rotation;
+    batch->x[i] = game->x;
+    batch->y[i] = game->y;
+    batch->inputs[i] = game->inputs;
+    batch->flags[i] = game->flags;
+    batch->snap_default[i] = game->snap_default;
+    batch->snap_count[i] = game->snap_count;
+    batch->drop_default[i] = game->drop_default;
+    batch->drop_count[i] = game->drop_count;
+    batch->move_default[i] = game->move_default;
+    batch->move_count[i] = game->move_count;
+    batch->move_index[i] = game->move_index;
+    batch->random_state[i] = game->random_state;
+}
+
+
+
+/**
+ * Copies a game out of the batch.
+ * 
+ * \c snap_index and \c drop_index are set to \c 1, the values they 
+ * have at the beginning of every call to mover_pieza().
+ * 
+ * @param batch A \c MONSTRO_TBATCH struct representing the batch.
+ * @param i     The index of the game in the batch.
+ * @param game  A \c MONSTRO_TGAME struct where the game will be copied.
+ */
+void get_game(const MONSTRO_TBATCH *batch, int i, MONSTRO_TGAME *game) {
+    memset(game->guard, 0, sizeof(game->guard));
+    memcpy(game->playfield, batch_playfield(batch, i), sizeof(game->playfield));
+    game->piece = batch->piece[i];
+    game->rotation = batch->rotation[i];
+    game->x = batch->x[i];
+    game->y = batch->y[i];
+    game->inputs = batch->inputs[i];
+    game->flags = batch->flags[i];
+    game->snap_default = batch->snap_default[i];
+    game->snap_count = batch->snap_count[i];
+    game->snap_index = 1;
+    game->drop_default = batch->drop_default[i];
+    game->drop_count = batch->drop_count[i];
+    game->drop_index = 1;
+    game->move_default = batch->move_default[i];
+    game->move_count = batch->move_count[i];
+    game->move_index = batch->move_index[i];
+    game->random_state = batch->random_state[i];
+}
+
+
+
+/**
+ * Performs the game logic for a game of the batch through mover_pieza().
+ * 
+ * @param batch A \c MONSTRO_TBATCH struct representing the batch.
+ * @param i     The index of the game in the batch.
+ */
+static void slow_step(MONSTRO_TBATCH *batch, int i) {
+    MONSTRO_TGAME copy;
+    
+    get_game(batch, i, &copy);
+    mover_pieza(&copy);
+    set_game(batch, i, &copy);
+}
+
+
+
+/**
+ * Moves the current piece of a game of the batch to the first valid 
+ * position out of its candidate positions.
+ * 
+ * The piece first tries to move horizontally to \c candidate_x and then 
+ * vertically to \c candidate_y, just like horizontal_movement() and 
+ * vertical_movement() followed by the final check in mover_pieza().
+ * 
+ * @param playfield     The playfield of the game.
+ * @param piece         The \c uint64_t representation of the piece.
+ * @param x             The current \c x position of the piece.
+ * @param y             The current \c y position of the piece.
+ * @param candidate_x   The \c x position the piece tries to move to.
+ * @param candidate_y   The \c y position the piece tries to fall to, 
+ *                      either \c y or <tt>y - 1</tt>.
+ * @param new_x         Where to store the new \c x position.
+ * @return              The new \c y position, or \c y + 1 if the piece 
+ *                      couldn't be placed at \c candidate_y, in which 
+ *                      case it is at \c y and its snap counter must increase.
+ */
+static inline int move_piece(MONSTRO_TROW *playfield, uint64_t piece, int x, int y, 
+                             int candidate_x, int candidate_y, int *new_x) {
+#if MONSTRO_TFIELD_WIDTH == 16
+// The rows from y - 1 to y + 3 cover every position the piece can move 
+// to, so they are read once and the checks are done on the registers
+    uint64_t rows;
+    memcpy(&rows, &playfield[y], sizeof(rows));
+    uint64_t below = playfield[y - 1];
+    rows ^= piece << x;
+    
+    int nx = (rows & (piece << candidate_x)) ? x : candidate_x;
+    int fall = candidate_y != y;
+    uint64_t shifted = (rows << 16) | below;
+    uint64_t placed = piece << nx;
+    int blocked = ((fall ? shifted : rows) & placed) != 0;
+    fall &= !blocked;
+    
+    below |= placed & -(uint64_t)fall & 0xFFFF;
+    rows |= placed >> (fall * 16);
+    playfield[y - 1] = below;
+    memcpy(&playfield[y], &rows, sizeof(rows));
+    *new_x = nx;
+    return blocked ? y + 1 : y - fall;
+#else
+    int nx = x, ny = candidate_y, blocked = 0;
+    
+    borrar_pieza(playfield, piece, x, y);
+    if (candidate_x != x && puede_mover(playfield, piece, candidate_x, y))
+        nx = candidate_x;
+    if (!puede_mover(playfield, piece, nx, ny)) {
+        ny = y;
+        blocked = 1;
+    }
+    poner_pieza(playfield, piece, nx, ny);
+    *new_x = nx;
+    return ny + blocked;
+#endif
+}
+
+
+
+/**
+ * Performs the game logic for every game in the batch; this is the 
+ * batch equivalent of calling mover_pieza() on each game.
+ * 
+ * The game action flags for each game are left in \c batch->flags. 
+ * Just like with mover_pieza(), the caller must call 
+ * spawn_piece_batch() for the games flagged with \c MONSTRO_TACTION_SPAWN.
+ * 
+ * @param batch A \c MONSTRO_TBATCH struct representing the batch.
+ */
+void mover_piezas(MONSTRO_TBATCH *batch) {
+    const LANE_VECTOR zero = {0}, one = zero + 1;
+    int32_t candidate_x[BLOCK], candidate_y[BLOCK], snap_index[BLOCK], slow[BLOCK], locked[BLOCK];
+    
+    for (int start = 0; start < batch->count; start += BLOCK) {
+        int lanes = (batch->capacity - start < BLOCK) ? batch->capacity - start : BLOCK;
+        int games = (batch->count - start < BLOCK) ? batch->count - start : BLOCK;
+        
+    // Everything that doesn't depend on the playfield, LANES games at a time
+        for (int j = 0; j < lanes; j += LANES) {
+            int i = start + j;
+            LANE_VECTOR inputs = load_lanes(&batch->inputs[i]);
+            LANE_VECTOR drop_default = load_lanes(&batch->drop_default[i]);
+            LANE_VECTOR move_default = load_lanes(&batch->move_default[i]);
+            LANE_VECTOR drop_count = load_lanes(&batch->drop_count[i]);
+            LANE_VECTOR move_count = load_lanes(&batch->move_count[i]);
+            LANE_VECTOR move_index = load_lanes(&batch->move_index[i]);
+            LANE_VECTOR x = load_lanes(&batch->x[i]);
+            
+        // Hard drops, rotations and 20G gravity are left to mover_pieza()
+            LANE_VECTOR slow_lanes = ((inputs & (MONSTRO_TINPUT_UP | MONSTRO_TINPUT_ROTATE_LEFT | MONSTRO_TINPUT_ROTATE_RIGHT)) != 0) | 
+                                     (drop_default == 0);
+            
+        // handle_inputs()
+            LANE_VECTOR down = ((inputs & MONSTRO_TINPUT_DOWN) != 0) & (drop_default > 0);
+            LANE_VECTOR drop_index = BLEND(down, drop_default, one);
+            LANE_VECTOR sideways = (inputs & (MONSTRO_TINPUT_LEFT | MONSTRO_TINPUT_RIGHT)) != 0;
+            LANE_VECTOR new_move_index = BLEND(sideways, BLEND(move_index == 0, zero + 4, move_index), zero);
+            LANE_VECTOR new_move_count = BLEND(sideways, move_count, move_default) + new_move_index;
+            
+        // horizontal_movement(), up to the point where the new position is verified; 
+        // the index is never negative, so (index * 5) >> 1 is the same as index * 2.5
+            LANE_VECTOR step = new_move_count > move_default;
+            LANE_VECTOR direction = BLEND((inputs & MONSTRO_TINPUT_LEFT) != 0, one, -one);
+            LANE_VECTOR faster = step & (new_move_index < 32);
+            new_move_index = BLEND(faster, (new_move_index + (new_move_index << 2)) >> 1, new_move_index);
+            new_move_count = BLEND(step, zero, new_move_count);
+            
+        // vertical_movement(); the comparison is -1 where the piece falls one row
+            LANE_VECTOR new_drop_count = drop_count + drop_index;
+            
+            store_lanes(&candidate_x[j], x + (step & direction));
+            store_lanes(&candidate_y[j], load_lanes(&batch->y[i]) + (new_drop_count > drop_default));
+            store_lanes(&snap_index[j], BLEND(down, load_lanes(&batch->snap_default[i]), one));
+            store_lanes(&slow[j], slow_lanes);
+            store_lanes(&batch->drop_count[i], BLEND(slow_lanes, drop_count, new_drop_count));
+            store_lanes(&batch->move_count[i], BLEND(slow_lanes, move_count, new_move_count));
+            store_lanes(&batch->move_index[i], BLEND(slow_lanes, move_index, new_move_index));
+        }
+        
+    // The only part of the logic that depends on each playfield; the 
+    // candidate positions are replaced by the actual new positions
+        const int32_t *piece = &batch->piece[start], *rotation = &batch->rotation[start];
+        const int32_t *x = &batch->x[start], *y = &batch->y[start];
+        MONSTRO_TROW *playfield = batch_playfield(batch, start);
+        for (int j = 0; j < games; j++, playfield += MONSTRO_TBATCH_STRIDE) {
+            int new_x;
+            if (slow[j]) {
+                candidate_x[j] = x[j];
+                candidate_y[j] = y[j];
+                continue;
+            }
+            candidate_y[j] = move_piece(playfield, piezas[piece[j]][rotation[j]], x[j], y[j], 
+                                        candidate_x[j], candidate_y[j], &new_x);
+            candidate_x[j] = new_x;
+        }
+        
+    // The rest of mover_pieza(); a piece that couldn't fall comes back 
+    // one row above its position, see move_piece()
+        for (int j = 0; j < lanes; j += LANES) {
+            int i = start + j;
+            LANE_VECTOR slow_lanes = load_lanes(&slow[j]);
+            LANE_VECTOR x = load_lanes(&batch->x[i]);
+            LANE_VECTOR y = load_lanes(&batch->y[i]);
+            LANE_VECTOR new_x = load_lanes(&candidate_x[j]);
+            LANE_VECTOR new_y = load_lanes(&candidate_y[j]);
+            LANE_VECTOR snap_count = load_lanes(&batch->snap_count[i]);
+            LANE_VECTOR drop_count = load_lanes(&batch->drop_count[i]);
+            LANE_VECTOR move_count = load_lanes(&batch->move_count[i]);
+            
+            LANE_VECTOR blocked = new_y > y;
+            new_y += blocked;
+            LANE_VECTOR dropped = new_y != y;
+            LANE_VECTOR moved = new_x != x;
+            LANE_VECTOR new_snap_count = BLEND(dropped, zero, snap_count + (blocked & load_lanes(&snap_index[j])));
+            LANE_VECTOR locked_lanes = ~slow_lanes & (new_snap_count > load_lanes(&batch->snap_default[i]));
+            LANE_VECTOR flags = (dropped & MONSTRO_TACTION_DROP) | (moved & MONSTRO_TACTION_MOVE) | 
+                                (locked_lanes & (MONSTRO_TACTION_SNAP | MONSTRO_TACTION_SPAWN));
+            
+            store_lanes(&locked[j], locked_lanes);
+            store_lanes(&batch->y[i], new_y);
+            store_lanes(&batch->x[i], new_x);
+            store_lanes(&batch->snap_count[i], BLEND(slow_lanes, snap_count, new_snap_count));
+            store_lanes(&batch->drop_count[i], BLEND(dropped, zero, drop_count));
+            store_lanes(&batch->move_count[i], BLEND(moved, zero, move_count));
+            store_lanes(&batch->flags[i], BLEND(slow_lanes, load_lanes(&batch->flags[i]), flags));
+        }
+        
+    // Clear the completed lines of the games whose piece locked and let 
+    // mover_pieza() handle the games left for the slow path
+        for (int j = 0; j < games; j++) {
+            int i = start + j;
+            if (slow[j])
+                slow_step(batch, i);
+            else if (locked[j])
+                batch->flags[i] |= borrar_completas(batch_playfield(batch, i), batch->y[i]) << 8;
+        }
+    }
+}
+
+
+
+/**
+ * Spawns a new piece into a game of the batch; this is the batch 
+ * equivalent of spawn_piece().
+ * 
+ * @param batch A \c MONSTRO_TBATCH struct representing the batch.
+ * @param i     The index of the game in the batch.
+ * @return      \c true if the piece could be placed on the playfield.
+ */
+int spawn_piece_batch(MONSTRO_TBATCH *batch, int i) {
+    MONSTRO_TGAME copy;
+    int spawned;
+    
+    get_game(batch, i, &copy);
+    spawned = spawn_piece(&copy);
+    set_game(batch, i, &copy);
+    
+    return spawned;
+}
@@ -0,0 +1,219 @@
+/**
+ * @file monstro-tbattle.c
+ * 
+ * @section LICENSE License
+ * 
+ * This is free and unencumbered software released into the public domain.
+ *
+ * Anyone is free to copy, modify, publish, use, compile, sell, or
+ * distribute this software, either in source code form or as a compiled
+ * binary, for any purpose, commercial or non-commercial, and by any
+ * means.
+ * 
+ * In jurisdictions that recognize copyright laws, the author or authors
+ * of this software dedicate any and all copyright interest in the
+ * software to the public domain. We make this dedication for the benefit
+ * of the public at large and to the detriment of our heirs and
+ * successors. We intend this dedication to be an overt act of
+ * relinquishment in perpetuity of all present and future rights to this
+ * software under copyright law.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+ * OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ * 
+ * For more information, please refer to <https://unlicense.org>
+ * 
+ * @section DESCRIPTION Description
+ * 
+ * Test bench for the battle room in monstro-troom.c. It plays a room of 
+ * boards at the fixed rate of the room, each one with a simple bot that 
+ * drops every piece where it leaves the fewest holes, until one board 
+ * is left or the tick limit is reached, and reports the garbage sent 
+ * and the time spent on each tick along with the lateness of the 
+ * scheduler. Usage:
+ * 
+ *      battle-main [-f] [-n boards] [-t ticks] [-s seed]
+ * 
+ * \c -f plays the ticks back to back, without waiting for their 
+ * deadlines, which measures how many ticks per second a single core 
+ * can play. The exit status is \c 1 if any tick was late.
+ */
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <time.h>
+#include "monstro-troom.h"
+#include "monstro-tpieces.h"
+
+typedef struct {
+    uint32_t random;
+    int rotation, x;    /* Planned place of the current piece */
+    int ticks;          /* Ticks since the current piece spawned */
+} BOT;
+
+MONSTRO_TROOM room;
+BOT bots[MONSTRO_TROOM_BOARDS];
+
+
+
+double now(void) {
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return t.tv_sec + t.tv_nsec * 1e-9;
+}
+
+
+
+uint32_t next_random(uint32_t *state) {
+    *state = *state * 1103515245 + 12345;
+    return *state >> 16;
+}
+
+
+
+/*
+ * Scores the playfield after placing a piece: cleared lines are good, 
+ * holes and height are bad.
+ */
+int score_playfield(const MONSTRO_TROW *playfield) {
+    MONSTRO_TROW cover = 0;
+    int lines = 0, holes = 0, height = 0;
+    
+    for (int y = MONSTRO_TFIELD_SIZE - 1; y > 0; y--) {
+        MONSTRO_TROW row = playfield[y];
+        if (row == MONSTRO_TFULL_ROW) {
+            lines++;
+            continue;
+        }
+        if (row != MONSTRO_TWALLS && height == 0)
+            height = y;
+        holes += __builtin_popcount((MONSTRO_TROW)(cover & ~row));
+        cover |= row & ~MONSTRO_TWALLS;
+    }
+    return lines * 6 - holes * 8 - height * 2;
+}
+
+
+
+/*
+ * Picks the rotation and column of the new piece of a board by trying 
+ * every one of them, dropped straight down from where it spawned.
+ */
+void plan_piece(BOT *bot, const MONSTRO_TGAME *game) {
+    MONSTRO_TROW playfield[MONSTRO_TFIELD_SIZE + 4] = {0};
+    MONSTRO_TROW *field = playfield + 4;
+    int best = INT32_MIN;
+    
+    memcpy(field, game->playfield, sizeof(game->playfield));
+    borrar_pieza(field, piezas[game->piece][game->rotation], game->x, game->y);
+    for (int rotation = 0; rotation < 4; rotation++) {
+        uint64_t piece = piezas[game->piece][rotation];
+        for (int x = 0; x <= MONSTRO_TFIELD_WIDTH - 4; x++) {
+            int y = game->y;
+            if (!puede_mover(field, piece, x, y))
+                continue;
+            while (puede_mover(field, piece, x, y - 1))
+                y--;
+            poner_pieza(field, piece, x, y);
+            int score = score_playfield(field) - (int)(next_random(&bot->random) & 3);
+            borrar_pieza(field, piece, x, y);
+            if (score > best) {
+                best = score;
+                bot->rotation = rotation;
+                bot->x = x;
+            }
+        }
+    }
+    bot->ticks = 0;
+}
+
+
+
+/*
+ * Rotates and moves the piece towards its planned place, releasing the 
+ * keys every other tick, and hard drops it once it gets there.
+ */
+int next_inputs(BOT *bot, const MONSTRO_TGAME *game) {
+    if (++bot->ticks & 1)
+        return 0;
+    if (game->rotation != bot->rotation && bot->ticks < 16)
+        return MONSTRO_TINPUT_ROTATE_RIGHT;
+    if (game->x != bot->x && bot->ticks < 48)
+        return (game->x < bot->x) ? MONSTRO_TINPUT_LEFT : MONSTRO_TINPUT_RIGHT;
+    return MONSTRO_TINPUT_UP;
+}
+
+
+
+int main(int argc, char **argv) {
+    long ticks = 36000;
+    uint64_t seed = 1;
+    int count = 100, free_run = false, option;
+    uint8_t inputs[MONSTRO_TROOM_BOARDS];
+    
+    while ((option = getopt(argc, argv, "fn:t:s:")) != -1)
+        switch (option) {
+            case 'f': free_run = true; break;
+            case 'n': count = atoi(optarg); break;
+            case 't': ticks = atol(optarg); break;
+            case 's': seed = strtoull(optarg, NULL, 10); break;
+            default:
+                fprintf(stderr, "usage: %s [-f] [-n boards] [-t ticks] [-s seed]\n", argv[0]);
+                return 2;
+        }
+    
+    if (!init_room(&room, seed, count)) {
+        fprintf(stderr, "invalid number of boards, it must be from 2 to %d\n", MONSTRO_TROOM_BOARDS);
+        return 2;
+    }
+    for (int i = 0; i < count; i++) {
+        bots[i].random = seed * MONSTRO_TROOM_BOARDS + i;
+        plan_piece(&bots[i], &room.boards[i].game);
+    }
+    
+    double start = now();
+    while (room.alive > 1 && room.tick < (uint64_t)ticks) {
+        if (!free_run)
+            wait_room(&room);
+        for (int i = 0; i < count; i++)
+            inputs[i] = next_inputs(&bots[i], &room.boards[i].game);
+        advance_room(&room, inputs);
+        for (int i = 0; i < count; i++)
+            if (room.boards[i].game.flags & MONSTRO_TACTION_SPAWN && !room.boards[i].game_over)
+                plan_piece(&bots[i], &room.boards[i].game);
+    }
+    double seconds = now() - start;
+    
+    uint64_t lines = 0, sent = 0, cancelled = 0, received = 0;
+    for (int i = 0; i < count; i++) {
+        const MONSTRO_TROOM_BOARD *board = &room.boards[i];
+        lines += board->lines;
+        sent += board->sent;
+        cancelled += board->cancelled;
+        received += board->received;
+        if (board->place == 1)
+            printf("winner: board %d lines=%llu sent=%llu knockouts=%llu\n", i, (unsigned long long)board->lines, 
+                   (unsigned long long)board->sent, (unsigned long long)board->knockouts);
+    }
+    printf("boards: count=%d alive=%d lines=%llu sent=%llu cancelled=%llu received=%llu\n", count, room.alive, 
+           (unsigned long long)lines, (unsigned long long)sent, (unsigned long long)cancelled, 
+           (unsigned long long)received);
+    double average = room.tick ? (double)room.busy / room.tick : 0.0;
+    printf("ticks: count=%llu average=%.1fus worst=%.1fus headroom=%.2f%%\n", (unsigned long long)room.tick, 
+           average * 1e-3, room.worst_busy * 1e-3, 100.0 * (1.0 - average / room.period));
+    if (!free_run)
+        printf("scheduler: late=%llu dropped=%llu worst_lag=%.1fus\n", (unsigned long long)room.late, 
+               (unsigned long long)room.dropped, room.worst_lag * 1e-3);
+    printf("total: seconds=%.3f ticks_per_second=%.0f\n", seconds, room.tick / seconds);
+    
+    return room.late != 0;
+}
@@ -0,0 +1,172 @@
+/**
+ * @file monstro-tchecksum.c
+ * 
+ * @section LICENSE License
+ * 
+ * This is free and unencumbered software released into the public domain.
+ *
+ * Anyone is free to copy, modify, publish, use, compile, sell, or
+ * distribute this software, either in source code form or as a compiled
+ * binary, for any purpose, commercial or non-commercial, and by any
+ * means.
+ * 
+ * In jurisdictions that recognize copyright laws, the author or authors
+ * of this software dedicate any and all copyright interest in the
+ * software to the public domain. We make this dedication for the benefit
+ * of the public at large and to the detriment of our heirs and
+ * successors. We intend this dedication to be an overt act of
+ * relinquishment in perpetuity of all present and future rights to this
+ * software under copyright law.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+ * OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ * 
+ * For more information, please refer to <https://unlicense.org>
+ * 
+ * @section DESCRIPTION Description
+ * 
+ * This file contains a fast checksum of the state of a game, meant to 
+ * be computed every tick to detect the tick where two simulations that 
+ * should be identical, such as the two peers of a lockstep or rollback 
+ * match, diverge. It's a CRC32C of the playfield, the current piece and 
+ * its position, the inputs and flags, the counters and the random state, 
+ * so it doesn't depend on the build options or on the padding of 
+ * \c MONSTRO_TGAME. The column index, the hash and the colors are left 
+ * out, since they only follow the playfield.
+ * 
+ * The checksum of each tick can be chained to the one of the previous 
+ * tick, so a single value covers the whole history of a game:
+ * 
+ *      checksum = game_checksum(&game, checksum);
+ * 
+ * When built for a CPU with SSE 4.2 (see \c WANT_NATIVE) or the ARMv8 
+ * CRC32 extension, the CRC instructions are used; otherwise tables 
+ * for 8 bytes at a time, built on the first call, which may happen on 
+ * several threads at once.
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include "monstro-tlogic.h"
+#if defined(__SSE4_2__)
+#include <nmmintrin.h>
+#elif defined(__ARM_FEATURE_CRC32)
+#include <arm_acle.h>
+#endif
+
+
+
+#if !defined(__SSE4_2__) && !defined(__ARM_FEATURE_CRC32)
+enum {TABLES_EMPTY, TABLES_BUILDING, TABLES_READY};
+
+// CRC32C (Castagnoli) tables for 8 bytes at a time, reflected polynomial 
+// 0x82F63B78; crc_tables[k][i] is the CRC of byte i followed by k zeros
+static uint32_t crc_tables[8][256];
+static int crc_tables_state = TABLES_EMPTY;
+
+
+
+static void build_crc_tables(void) {
+    for (int i = 0; i < 256; i++) {
+        uint32_t crc = i;
+        for (int bit = 0; bit < 8; bit++)
+            crc = (crc >> 1) ^ ((crc & 1) ? 0x82F63B78 : 0);
+        crc_tables[0][i] = crc;
+    }
+    for (int k = 1; k < 8; k++)
+        for (int i = 0; i < 256; i++)
+            crc_tables[k][i] = (crc_tables[k - 1][i] >> 8) ^ crc_tables[0][crc_tables[k - 1][i] & 0xFF];
+}
+
+
+
+/**
+ * Builds the tables if they aren't ready yet. Only the first thread to 
+ * get here builds them; any other one waits until they are published.
+ */
+static inline void init_crc_tables(void) {
+    int state = TABLES_EMPTY;
+    
+    if (__atomic_load_n(&crc_tables_state, __ATOMIC_ACQUIRE) == TABLES_READY)
+        return;
+    if (__atomic_compare_exchange_n(&crc_tables_state, &state, TABLES_BUILDING, false, 
+                                    __ATOMIC_ACQUIRE, __ATOMIC_ACQUIRE)) {
+        build_crc_tables();
+        __atomic_store_n(&crc_tables_state, TABLES_READY, __ATOMIC_RELEASE);
+    }
+    else
+        while (__atomic_load_n(&crc_tables_state, __ATOMIC_ACQUIRE) != TABLES_READY)
+            ;
+}
+#endif
+
+
+
+/**
+ * Updates a CRC32C with the 8 bytes of a value, least significant first.
+ */
+static inline uint32_t crc_update(uint32_t crc, uint64_t value) {
+#if defined(__SSE4_2__) && defined(__x86_64__)
+    return _mm_crc32_u64(crc, value);
+#elif defined(__SSE4_2__)
+    crc = _mm_crc32_u32(crc, value);
+    return _mm_crc32_u32(crc, value >> 32);
+#elif defined(__ARM_FEATURE_CRC32)
+    return __crc32cd(crc, value);
+#else
+    value ^= crc;
+    return crc_tables[7][value & 0xFF] ^ crc_tables[6][(value >> 8) & 0xFF] ^ 
+           crc_tables[5][(value >> 16) & 0xFF] ^ crc_tables[4][(value >> 24) & 0xFF] ^ 
+           crc_tables[3][(value >> 32) & 0xFF] ^ crc_tables[2][(value >> 40) & 0xFF] ^ 
+           crc_tables[1][(value >> 48) & 0xFF] ^ crc_tables[0][value >> 56];
+#endif
+}
+
+
+
+/**
+ * Returns the checksum of the state of a game.
+ * 
+ * @param game      A \c MONSTRO_TGAME struct representing the game.
+ * @param checksum  The checksum to chain to, such as the one of the 
+ *                  previous tick, or \c 0.
+ * @return          The checksum.
+ */
+uint32_t game_checksum(const MONSTRO_TGAME *game, uint32_t checksum) {
+    uint32_t crc = ~checksum;
+    
+#if !defined(__SSE4_2__) && !defined(__ARM_FEATURE_CRC32)
+    init_crc_tables();
+#endif
+// The playfield, 8 bytes at a time in little endian order
+    for (size_t i = 0; i < sizeof(game->playfield); i += 8) {
+        uint64_t rows = 0;
+#if __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+        memcpy(&rows, (const uint8_t *)game->playfield + i, 
+               (sizeof(game->playfield) - i < 8) ? sizeof(game->playfield) - i : 8);
+#else
+        for (size_t j = 0; j < 8 && i + j < sizeof(game->playfield); j++)
+            rows |= (uint64_t)((game->playfield[(i + j) / sizeof(MONSTRO_TROW)] >> 
+                                ((i + j) % sizeof(MONSTRO_TROW) * 8)) & 0xFF) << (j * 8);
+#endif
+        crc = crc_update(crc, rows);
+    }
+    
+    crc = crc_update(crc, (uint64_t)(game->piece & 0xFF) | (uint64_t)(game->rotation & 0xFF) << 8 | 
+                          (uint64_t)(game->x & 0xFF) << 16 | (uint64_t)(game->y & 0xFF) << 24 | 
+                          (uint64_t)(game->inputs & 0xFF) << 32 | (uint64_t)(game->flags & 0xFFFF) << 40);
+    crc = crc_update(crc, (uint32_t)game->snap_default | (uint64_t)(uint32_t)game->snap_count << 32);
+    crc = crc_update(crc, (uint32_t)game->snap_index | (uint64_t)(uint32_t)game->drop_default << 32);
+    crc = crc_update(crc, (uint32_t)game->drop_count | (uint64_t)(uint32_t)game->drop_index << 32);
+    crc = crc_update(crc, (uint32_t)game->move_default | (uint64_t)(uint32_t)game->move_count << 32);
+    crc = crc_update(crc, (uint32_t)game->move_index);
+    crc = crc_update(crc, game->random_state);
+    
+    return ~crc;
+}
@@ -0,0 +1,506 @@
+/**
+ * @file monstro-tclient.c
+ * 
+ * @section LICENSE License
+ * 
+ * This is free and unencumbered software released into the public domain.
+ *
+ * Anyone is free to copy, modify, publish, use, compile, sell, or
+ * distribute this software, either in source code form or as a compiled
+ * binary, for any purpose, commercial or non-commercial, and by any
+ * means.
+ * 
+ * In jurisdictions that recognize copyright laws, the author or authors
+ * of this software dedicate any and all copyright interest in the
+ * software to the public domain. We make this dedication for the benefit
+ * of the public at large and to the detriment of our heirs and
+ * successors. We intend this dedication to be an overt act of
+ * relinquishment in perpetuity of all present and future rights to this
+ * software under copyright law.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+ * OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ * 
+ * For more information, please refer to <https://unlicense.org>
+ * 
+ * @section DESCRIPTION Description
+ * 
+ * Scripted client for the game server in monstro-tserver.c. It opens 
+ * many connections to the server, plays a game on each one of the 
+ * active ones, sending its inputs in batches, and keeps the rest idle. 
+ * Usage:
+ * 
+ *      client-main [-p port] [-a address] [-u path] [-n active] [-i idle] 
+ *                  [-t ticks] [-b batch] [-s seed] [script]
+ * 
+ * Each active connection plays with random inputs, or with the inputs 
+ * of the given script, in the format read by headless-main, until the 
+ * script ends, and plays the same game locally as well. The playfield is rebuilt from the 
+ * deltas sent by the server and, once every game is over or has played 
+ * the given number of ticks, it's compared with the local game, along 
+ * with the lines cleared and the game_checksum() reported by the 
+ * server. The exit status is \c 1 if any game differs.
+ */
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <time.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <sys/resource.h>
+#include <sys/un.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include "monstro-tserver.h"
+#include "monstro-tbytes.h"
+
+#define WINDOW          4       /* Largest number of batches waiting for their delta */
+#define READ_SIZE       4096
+#define WRITE_SIZE      (WINDOW * MONSTRO_TSERVER_INPUTS_SIZE + 16)
+
+typedef struct {
+    MONSTRO_TGAME game;     /* Local copy of the game */
+    uint64_t ticks, lines;
+    int level_lines, game_over;
+    MONSTRO_TROW mirror[MONSTRO_TFIELD_SIZE];       /* Playfield rebuilt from the deltas */
+    int piece, rotation, x, y, remote_over;         /* Rest of the last delta */
+    int active;
+    int socket;
+    int events;
+    int waiting;            /* Messages sent without their reply yet */
+    int queried, checked;
+    uint32_t random;
+    int inputs, hold;
+    long script_position;
+    size_t read_size, write_size;
+    uint8_t read_buffer[READ_SIZE];
+    uint8_t write_buffer[WRITE_SIZE];
+} CONNECTION;
+
+CONNECTION *connections;
+int count, epoll_fd;
+long ticks = 3600;
+int batch = 8;
+uint8_t *script = NULL;
+long script_size = 0;
+uint64_t script_seed = 0;
+int mismatches = 0, finished = 0;
+uint64_t bytes_read = 0, bytes_written = 0;
+
+
+
+double now(void) {
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return t.tv_sec + t.tv_nsec * 1e-9;
+}
+
+
+
+uint32_t next_random(uint32_t *state) {
+    *state = *state * 1103515245 + 12345;
+    return *state >> 16;
+}
+
+
+
+/*
+ * Random inputs, held for a few frames like a human player would.
+ */
+int random_inputs(CONNECTION *connection) {
+    if (--connection->hold > 0)
+        return connection->inputs;
+    uint32_t r = next_random(&connection->random);
+    int x = r & 31;
+    connection->inputs = (x < 14) ? 0 : (x < 18) ? MONSTRO_TINPUT_DOWN : (x < 22) ? MONSTRO_TINPUT_LEFT : 
+                         (x < 26) ? MONSTRO_TINPUT_RIGHT : (x < 28) ? MONSTRO_TINPUT_ROTATE_LEFT : 
+                         (x < 30) ? MONSTRO_TINPUT_ROTATE_RIGHT : MONSTRO_TINPUT_UP;
+    connection->hold = (connection->inputs & (MONSTRO_TINPUT_UP | MONSTRO_TINPUT_ROTATE_LEFT | MONSTRO_TINPUT_ROTATE_RIGHT)) ? 
+                       1 : 2 + ((r >> 5) & 15);
+    return connection->inputs;
+}
+
+
+
+/*
+ * Converts a string of input letters into input flags, the same as 
+ * headless-main; returns -1 if the string has an unknown letter.
+ */
+int parse_inputs(const char *text) {
+    int inputs = 0;
+    
+    for (; *text; text++)
+        switch (*text) {
+            case 'U': inputs |= MONSTRO_TINPUT_UP; break;
+            case 'D': inputs |= MONSTRO_TINPUT_DOWN; break;
+            case 'L': inputs |= MONSTRO_TINPUT_LEFT; break;
+            case 'R': inputs |= MONSTRO_TINPUT_RIGHT; break;
+            case 'A': inputs |= MONSTRO_TINPUT_ROTATE_LEFT; break;
+            case 'B': inputs |= MONSTRO_TINPUT_ROTATE_RIGHT; break;
+            case '-': break;
+            default: return -1;
+        }
+    return inputs;
+}
+
+
+
+/*
+ * Reads a script into one input per tick.
+ */
+int read_script(const char *path) {
+    FILE *file = strcmp(path, "-") ? fopen(path, "r") : stdin;
+    char line[256], text[64];
+    long repeat, capacity = 0;
+    
+    if (!file)
+        return false;
+    while (fgets(line, sizeof(line), file)) {
+        char *comment = strchr(line, '#');
+        unsigned long long seed;
+        if (comment)
+            *comment = '\0';
+        if (sscanf(line, " seed %llu", &seed) == 1) {
+            script_seed = seed;
+            continue;
+        }
+        if (sscanf(line, "%ld %63s", &repeat, text) != 2)
+            continue;
+        int inputs = parse_inputs(text);
+        if (inputs < 0 || repeat < 0)
+            return false;
+        if (script_size + repeat > capacity) {
+            capacity = (script_size + repeat) * 2;
+            script = realloc(script, capacity);
+        }
+        memset(script + script_size, inputs, repeat);
+        script_size += repeat;
+    }
+    if (file != stdin)
+        fclose(file);
+    return true;
+}
+
+
+
+/*
+ * Game initialization and ticks, the same as in the server.
+ */
+void new_game(CONNECTION *connection, uint64_t seed) {
+    MONSTRO_TGAME *game = &connection->game;
+    
+    start_game(game, seed);
+    connection->game_over = !spawn_piece(game);
+}
+
+
+
+void step_game(CONNECTION *connection, int inputs) {
+    MONSTRO_TGAME *game = &connection->game;
+    
+    game->inputs = inputs;
+    mover_pieza(game);
+    connection->ticks++;
+    if (game->flags & MONSTRO_TACTION_SPAWN)
+        connection->game_over = !spawn_piece(game);
+    if (game->flags & MONSTRO_TACTION_CLEARED) {
+        int lines = __builtin_popcount(game->flags & MONSTRO_TACTION_CLEARED);
+        connection->lines += lines;
+        level_up(game, &connection->level_lines, lines);
+    }
+}
+
+
+
+/*
+ * Writes as much of the write buffer as the socket takes, and watches 
+ * the socket for writing while anything is left.
+ */
+void flush_connection(CONNECTION *connection) {
+    if (connection->write_size > 0) {
+        ssize_t written = send(connection->socket, connection->write_buffer, connection->write_size, MSG_NOSIGNAL);
+        if (written > 0) {
+            bytes_written += written;
+            memmove(connection->write_buffer, connection->write_buffer + written, connection->write_size - written);
+            connection->write_size -= written;
+        }
+    }
+    int events = EPOLLIN | (connection->write_size ? EPOLLOUT : 0);
+    if (events != connection->events) {
+        struct epoll_event event = { .events = events, .data.ptr = connection };
+        epoll_ctl(epoll_fd, EPOLL_CTL_MOD, connection->socket, &event);
+        connection->events = events;
+    }
+}
+
+
+
+/*
+ * Queues the next batches of inputs of an active connection, playing 
+ * them on the local game, or the final query once the game is done.
+ */
+void send_inputs(CONNECTION *connection) {
+    while (connection->active && connection->waiting < WINDOW && !connection->game_over && 
+           connection->ticks < (uint64_t)ticks) {
+        uint8_t *message = connection->write_buffer + connection->write_size;
+        int size = 0;
+        while (size < batch && !connection->game_over && connection->ticks < (uint64_t)ticks) {
+            int inputs;
+            if (script)
+                inputs = script[connection->script_position++];
+            else
+                inputs = random_inputs(connection);
+            step_game(connection, inputs);
+            message[2 + size++] = inputs;
+        }
+        message[0] = MONSTRO_TSERVER_INPUTS;
+        message[1] = size;
+        connection->write_size += 2 + size;
+        connection->waiting++;
+    }
+}
+
+
+
+void send_query(CONNECTION *connection) {
+    connection->write_buffer[connection->write_size++] = MONSTRO_TSERVER_QUERY;
+    connection->waiting++;
+    connection->queried = true;
+}
+
+
+
+/*
+ * Compares the state reported by the server with the local game.
+ */
+void check_connection(CONNECTION *connection, const uint8_t *message) {
+    const MONSTRO_TGAME *game = &connection->game;
+    int same = get_le(message + 1, 8) == connection->ticks && get_le(message + 9, 8) == connection->lines && 
+               get_le(message + 17, 4) == game_checksum(game, 0) && message[21] == connection->game_over && 
+               memcmp(connection->mirror, game->playfield, sizeof(connection->mirror)) == 0 && 
+               connection->piece == game->piece && connection->rotation == game->rotation && 
+               connection->x == game->x && connection->y == game->y && 
+               connection->remote_over == connection->game_over;
+    
+    if (!same) {
+        fprintf(stderr, "connection %ld: the game differs from the server\n", (long)(connection - connections));
+        mismatches++;
+    }
+    connection->checked = true;
+    finished++;
+}
+
+
+
+/*
+ * Handles every complete message from the server.
+ * 
+ * @return  \c false if the server sent an invalid message.
+ */
+int handle_messages(CONNECTION *connection) {
+    size_t start = 0;
+    
+    while (start < connection->read_size) {
+        const uint8_t *message = connection->read_buffer + start;
+        size_t size = connection->read_size - start;
+        size_t length;
+        
+        if (message[0] == MONSTRO_TSERVER_DELTA) {
+            if (size < MONSTRO_TSERVER_DELTA_HEADER)
+                break;
+            int rows = 0;
+            for (int i = 0; i < MONSTRO_TSERVER_MASK_SIZE; i++)
+                rows += __builtin_popcount(message[12 + i]);
+            length = MONSTRO_TSERVER_DELTA_HEADER + rows * sizeof(MONSTRO_TROW);
+            if (size < length)
+                break;
+            const uint8_t *row = message + MONSTRO_TSERVER_DELTA_HEADER;
+            for (int y = 0; y < MONSTRO_TFIELD_SIZE; y++)
+                if (message[12 + y / 8] & (1 << (y % 8))) {
+                    connection->mirror[y] = get_le(row, sizeof(MONSTRO_TROW));
+                    row += sizeof(MONSTRO_TROW);
+                }
+            connection->piece = message[7];
+            connection->rotation = message[8];
+            connection->x = message[9];
+            connection->y = (int8_t)message[10];
+            connection->remote_over = message[11];
+        }
+        else if (message[0] == MONSTRO_TSERVER_CHECKSUM) {
+            length = MONSTRO_TSERVER_CHECKSUM_SIZE;
+            if (size < length)
+                break;
+            check_connection(connection, message);
+        }
+        else
+            return false;
+        connection->waiting--;
+        start += length;
+    }
+    
+    memmove(connection->read_buffer, connection->read_buffer + start, connection->read_size - start);
+    connection->read_size -= start;
+    return true;
+}
+
+
+
+int open_connection(CONNECTION *connection, const char *address, int port, const char *path) {
+    if (path) {
+        struct sockaddr_un remote = { .sun_family = AF_UNIX };
+        strncpy(remote.sun_path, path, sizeof(remote.sun_path) - 1);
+        connection->socket = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+        if (connection->socket < 0 || connect(connection->socket, (struct sockaddr *)&remote, sizeof(remote)) != 0)
+            return false;
+    }
+    else {
+        struct sockaddr_in remote = { .sin_family = AF_INET, .sin_port = htons(port) };
+        if (inet_pton(AF_INET, address, &remote.sin_addr) != 1)
+            return false;
+        connection->socket = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+        if (connection->socket < 0 || connect(connection->socket, (struct sockaddr *)&remote, sizeof(remote)) != 0)
+            return false;
+    }
+    fcntl(connection->socket, F_SETFL, O_NONBLOCK);
+    connection->events = EPOLLIN;
+    struct epoll_event event = { .events = connection->events, .data.ptr = connection };
+    return epoll_ctl(epoll_fd, EPOLL_CTL_ADD, connection->socket, &event) == 0;
+}
+
+
+
+int main(int argc, char **argv) {
+    const char *address = "127.0.0.1", *path = NULL;
+    int port = MONSTRO_TSERVER_PORT, active = 100, idle = 0, option;
+    uint64_t seed = 1;
+    
+    while ((option = getopt(argc, argv, "p:a:u:n:i:t:b:s:")) != -1)
+        switch (option) {
+            case 'p': port = atoi(optarg); break;
+            case 'a': address = optarg; break;
+            case 'u': path = optarg; break;
+            case 'n': active = atoi(optarg); break;
+            case 'i': idle = atoi(optarg); break;
+            case 't': ticks = atol(optarg); break;
+            case 'b': batch = atoi(optarg); break;
+            case 's': seed = strtoull(optarg, NULL, 10); break;
+            default:
+                fprintf(stderr, "usage: %s [-p port] [-a address] [-u path] [-n active] [-i idle] "
+                                "[-t ticks] [-b batch] [-s seed] [script]\n", argv[0]);
+                return 2;
+        }
+    if (batch < 1 || batch > 255 || active < 0 || idle < 0 || active + idle < 1) {
+        fprintf(stderr, "invalid settings, the batch must be from 1 to 255 and there must be a connection\n");
+        return 2;
+    }
+    if (optind < argc) {
+        if (!read_script(argv[optind])) {
+            fprintf(stderr, "invalid script %s\n", argv[optind]);
+            return 2;
+        }
+        seed = script_seed;
+        ticks = script_size;
+    }
+    
+    struct rlimit limit;
+    if (getrlimit(RLIMIT_NOFILE, &limit) == 0) {
+        limit.rlim_cur = limit.rlim_max;
+        setrlimit(RLIMIT_NOFILE, &limit);
+    }
+    count = active + idle;
+    connections = calloc(count, sizeof(CONNECTION));
+    epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+    if (!connections || epoll_fd < 0) {
+        perror("client");
+        return 1;
+    }
+    
+// Every game starts right after its connection opens; only the active 
+// ones play, and the idle ones are only checked at the end
+    double start = now();
+    for (int i = 0; i < count; i++) {
+        CONNECTION *connection = &connections[i];
+        uint64_t game_seed = script ? seed : seed + i;
+        if (!open_connection(connection, address, port, path)) {
+            fprintf(stderr, "connection %d: %s\n", i, strerror(errno));
+            return 1;
+        }
+        connection->active = i < active;
+        connection->random = game_seed;
+        new_game(connection, game_seed);
+        connection->write_buffer[0] = MONSTRO_TSERVER_START;
+        put_le(connection->write_buffer + 1, game_seed, 8);
+        connection->write_size = 9;
+        connection->waiting = 1;
+        send_inputs(connection);
+        flush_connection(connection);
+    }
+    double connected = now();
+    
+    struct epoll_event events[256];
+    while (finished < count) {
+        int ready = epoll_wait(epoll_fd, events, 256, 5000);
+        if (ready <= 0) {
+            fprintf(stderr, "timed out waiting for the server\n");
+            return 1;
+        }
+        for (int i = 0; i < ready; i++) {
+            CONNECTION *connection = events[i].data.ptr;
+            if (events[i].events & EPOLLIN) {
+                ssize_t size = recv(connection->socket, connection->read_buffer + connection->read_size, 
+                                    READ_SIZE - connection->read_size, 0);
+                if (size == 0 || (size < 0 && errno != EAGAIN && errno != EINTR)) {
+                    fprintf(stderr, "connection %ld: closed by the server\n", (long)(connection - connections));
+                    return 1;
+                }
+                if (size > 0) {
+                    bytes_read += size;
+                    connection->read_size += size;
+                }
+                if (!handle_messages(connection)) {
+                    fprintf(stderr, "connection %ld: invalid message\n", (long)(connection - connections));
+                    return 1;
+                }
+                send_inputs(connection);
+                if (connection->active && connection->waiting == 0 && !connection->queried)
+                    send_query(connection);
+            }
+            flush_connection(connection);
+        }
+        
+    // Idle connections are queried once every active one is done
+        if (finished == active)
+            for (int i = active; i < count; i++)
+                if (!connections[i].queried && connections[i].waiting == 0) {
+                    send_query(&connections[i]);
+                    flush_connection(&connections[i]);
+                }
+    }
+    double end = now();
+    
+    uint64_t total_ticks = 0, total_lines = 0;
+    for (int i = 0; i < count; i++) {
+        total_ticks += connections[i].ticks;
+        total_lines += connections[i].lines;
+        close(connections[i].socket);
+    }
+    printf("connections: active=%d idle=%d connect=%.3fs\n", active, idle, connected - start);
+    printf("games: ticks=%llu lines=%llu ticks_per_second=%.0f\n", (unsigned long long)total_ticks, 
+           (unsigned long long)total_lines, total_ticks / (end - connected));
+    printf("bytes: sent=%llu received=%llu (%.1f per tick)\n", (unsigned long long)bytes_written, 
+           (unsigned long long)bytes_read, total_ticks ? (double)bytes_read / total_ticks : 0.0);
+    printf("total: seconds=%.3f %s\n", end - start, mismatches ? "MISMATCH" : "all games match");
+    
+    return mismatches != 0;
+}
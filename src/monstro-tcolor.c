@@ -54,14 +54,14 @@
  * playfield walls for this particular implementation are initialized 
  * with index value 7 (indices 0 through 6 corresponding to game pieces' colors).
  * 
- * TODO: Replace hardcoded values ???
- * TODO: Also, hardcoded initialization is for a 10-cell width playfield, 
- *       should allow for other possible initialization values ???
+ * The well is \c MONSTRO_TWELL_WIDTH cells wide and starts 
+ * \c MONSTRO_TWALL_SIZE cells from the right, the same as the walls set 
+ * by init_playfield().
  */
 void init_color_playfield(MONSTRO_TGAME *game) {
-    memset(game->color_playfield, 7, MONSTRO_TFIELD_SIZE * 16);
-    for (int y = 1; y < 24; y++)
-        memset(game->color_playfield[y] + 3, -1, 10);
+    memset(game->color_playfield, 7, sizeof(game->color_playfield));
+    for (int y = 1; y < MONSTRO_TFIELD_SIZE; y++)
+        memset(game->color_playfield[y] + MONSTRO_TWALL_SIZE, -1, MONSTRO_TWELL_WIDTH);
 }
 
 
@@ -83,20 +83,44 @@ void init_color_playfield(MONSTRO_TGAME *game) {
  * @param game  A \c MONSTRO_TGAME struct representing the current game.
  */
 void update_color_playfield(MONSTRO_TGAME *game) {
-    uint64_t t = game->current_piece << game->x;
+    uint64_t t = game->current_piece;
     
 // This places the piece permanently in the color playfield
     if (game->flags & MONSTRO_TACTION_SNAP)
         for (int i = 0; i < 64; i++)
             if (t & ((uint64_t)1 << i))
-                game->color_playfield[game->y + i / 16][i % 16] = game->piece;
+                game->color_playfield[game->y + i / 16][game->x + i % 16] = game->piece;
 
 // This clears completed lines from the color playfield
     if ((game->flags & MONSTRO_TACTION_SNAP) && (game->flags & MONSTRO_TACTION_CLEARED)) {
         int y = game->y;
         for (int i = 0; i < 4; i++)
             if (!(game->flags & (MONSTRO_TACTION_CLEARED0 << i)))
-                memmove(game->color_playfield[y++], game->color_playfield[game->y + i], sizeof(char) * 16);
-        memmove(game->color_playfield[y], game->color_playfield[game->y + 4], sizeof(char) * 16 * (20 - y));
+                memmove(game->color_playfield[y++], game->color_playfield[game->y + i], sizeof(char) * MONSTRO_TFIELD_WIDTH);
+        memmove(game->color_playfield[y], game->color_playfield[game->y + 4], sizeof(char) * MONSTRO_TFIELD_WIDTH * (MONSTRO_TFIELD_SIZE - 4 - y));
     }
 }
+
+
+
+/**
+ * Inserts garbage rows into the color playfield.
+ * 
+ * This function must be called *only if* \c MONSTRO_TWANT_COLORS is defined, 
+ * with the same rows passed to subir_basura(); add_garbage() already does it. 
+ * The rows above the floor are moved up with a single memmove() and the 
+ * blocks of the garbage rows take the same color index as the walls.
+ * 
+ * @param game  A \c MONSTRO_TGAME struct representing the current game.
+ * @param rows  An array of \c count garbage rows, the first one being the 
+ *              bottom row.
+ * @param count The number of rows to insert.
+ */
+void add_color_garbage(MONSTRO_TGAME *game, const MONSTRO_TROW *rows, int count) {
+    if (count <= 0)
+        return;
+    memmove(game->color_playfield[1 + count], game->color_playfield[1], sizeof(char) * MONSTRO_TFIELD_WIDTH * (MONSTRO_TFIELD_SIZE - 1 - count));
+    for (int i = 0; i < count; i++)
+        for (int x = 0; x < MONSTRO_TFIELD_WIDTH; x++)
+            game->color_playfield[1 + i][x] = (rows[i] >> x & 1) ? 7 : -1;
+}
@@ -0,0 +1,242 @@
+/**
+ * @file monstro-tcolumns.c
+ * 
+ * @section LICENSE License
+ * 
+ * This is free and unencumbered software released into the public domain.
+ *
+ * Anyone is free to copy, modify, publish, use, compile, sell, or
+ * distribute this software, either in source code form or as a compiled
+ * binary, for any purpose, commercial or non-commercial, and by any
+ * means.
+ * 
+ * In jurisdictions that recognize copyright laws, the author or authors
+ * of this software dedicate any and all copyright interest in the
+ * software to the public domain. We make this dedication for the benefit
+ * of the public at large and to the detriment of our heirs and
+ * successors. We intend this dedication to be an overt act of
+ * relinquishment in perpetuity of all present and future rights to this
+ * software under copyright law.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+ * OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ * 
+ * For more information, please refer to <https://unlicense.org>
+ * 
+ * @section DESCRIPTION Description
+ * 
+ * This file contains an optional column index for the playfield, 
+ * available only when \c MONSTRO_TWANT_COLUMNS is defined. The index 
+ * is the transposed version of the playfield used by the core functions 
+ * in monstro-tcore.c, an array of \c MONSTRO_TFIELD_WIDTH integers of 
+ * type \c MONSTRO_TCOLUMN where each integer represents one column of 
+ * the playfield and each bit represents one row:
+ * 
+ *      MONSTRO_TCOLUMN columnas[MONSTRO_TFIELD_WIDTH];
+ *                                  // columnas[x] & (1 << y) is set if 
+ *                                  // area_de_juego[y] & (1 << x) is set
+ * 
+ * The functions here mirror poner_pieza(), borrar_pieza() and 
+ * borrar_completas() so the index can be kept up to date alongside the 
+ * playfield, at a cost proportional to the number of blocks in the 
+ * piece. With the index, questions like the height of a column or 
+ * the row where a piece would land are answered in a few instructions 
+ * per column instead of scanning the playfield row by row.
+ */
+
+#include <stdint.h>
+#include <string.h>
+#include "monstro-tcore.h"
+
+
+
+/**
+ * Transpone una matriz de 8x8 bits en la que cada byte es una fila; en 
+ * el resultado, cada byte es una columna de la matriz original.
+ */
+static inline uint64_t transponer8(uint64_t m) {
+    uint64_t t;
+    t = (m ^ (m >> 7)) & 0x00AA00AA00AA00AAULL;
+    m ^= t ^ (t << 7);
+    t = (m ^ (m >> 14)) & 0x0000CCCC0000CCCCULL;
+    m ^= t ^ (t << 14);
+    t = (m ^ (m >> 28)) & 0x00000000F0F0F0F0ULL;
+    m ^= t ^ (t << 28);
+    return m;
+}
+
+
+
+/**
+ * Inicializa el índice de columnas a partir del tablero.
+ * 
+ * @param columnas      Un apuntador a un arreglo de \c MONSTRO_TFIELD_WIDTH 
+ *                      \c MONSTRO_TCOLUMN representando las columnas del 
+ *                      tablero.
+ * @param area_de_juego Un apuntador a un arreglo de \c MONSTRO_TROW 
+ *                      representando el tablero del juego.
+ */
+void iniciar_columnas(MONSTRO_TCOLUMN *columnas, MONSTRO_TROW *area_de_juego) {
+    MONSTRO_TROW filas[(MONSTRO_TFIELD_SIZE + 7) / 8 * 8] = {0};
+    
+    memcpy(filas, area_de_juego, MONSTRO_TFIELD_SIZE * sizeof(MONSTRO_TROW));
+    for (int x = 0; x < MONSTRO_TFIELD_WIDTH; x++)
+        columnas[x] = 0;
+// El tablero se transpone en bloques de 8x8 celdas
+    for (int y = 0; y < MONSTRO_TFIELD_SIZE; y += 8)
+        for (int x = 0; x < MONSTRO_TFIELD_WIDTH; x += 8) {
+            uint64_t bloque = 0;
+            for (int i = 0; i < 8; i++)
+                bloque |= (uint64_t)((filas[y + i] >> x) & 0xFF) << (i * 8);
+            bloque = transponer8(bloque);
+            for (int i = 0; i < 8; i++)
+                columnas[x + i] |= (MONSTRO_TCOLUMN)((bloque >> (i * 8)) & 0xFF) << y;
+        }
+}
+
+
+
+/**
+ * Pone una pieza en la posición (x, y) del índice de columnas; es el 
+ * equivalente de poner_pieza() para el índice.
+ * 
+ * @param columnas      Un apuntador a un arreglo de \c MONSTRO_TFIELD_WIDTH 
+ *                      \c MONSTRO_TCOLUMN representando las columnas del 
+ *                      tablero.
+ * @param pieza         La pieza a colocar, representada como un entero 
+ *                      de 64 bits \c uint64_t.
+ * @param x             La posición \c x en la que se colocará la pieza.
+ * @param y             La posición \c y en la que se colocará la pieza.
+ */
+void poner_columnas(MONSTRO_TCOLUMN *columnas, uint64_t pieza, int x, int y) {
+    for (uint64_t dato = pieza; dato; dato &= dato - 1) {
+        int bit = __builtin_ctzll(dato);
+        columnas[x + bit % 16] |= (MONSTRO_TCOLUMN)1 << (y + bit / 16);
+    }
+}
+
+
+
+/**
+ * Borra una pieza de la posición (x, y) del índice de columnas; es el 
+ * equivalente de borrar_pieza() para el índice.
+ * 
+ * @param columnas      Un apuntador a un arreglo de \c MONSTRO_TFIELD_WIDTH 
+ *                      \c MONSTRO_TCOLUMN representando las columnas del 
+ *                      tablero.
+ * @param pieza         La pieza a borrar, representada como un entero 
+ *                      de 64 bits \c uint64_t.
+ * @param x             La posición \c x en la que se colocó la pieza.
+ * @param y             La posición \c y en la que se colocó la pieza.
+ */
+void borrar_columnas(MONSTRO_TCOLUMN *columnas, uint64_t pieza, int x, int y) {
+    for (uint64_t dato = pieza; dato; dato &= dato - 1) {
+        int bit = __builtin_ctzll(dato);
+        columnas[x + bit % 16] ^= (MONSTRO_TCOLUMN)1 << (y + bit / 16);
+    }
+}
+
+
+
+/**
+ * Borra las líneas completas del índice de columnas; es el equivalente 
+ * de borrar_completas() para el índice y produce exactamente el mismo 
+ * resultado, incluyendo las filas superiores que borrar_completas() 
+ * deja sin modificar.
+ * 
+ * @param columnas      Un apuntador a un arreglo de \c MONSTRO_TFIELD_WIDTH 
+ *                      \c MONSTRO_TCOLUMN representando las columnas del 
+ *                      tablero.
+ * @param y             La posición \c Y en la que se ancló la última 
+ *                      pieza.
+ * @param completas     Una máscara de 4 bits con las líneas completas a 
+ *                      partir de \c y; el bit \c i indica que la fila 
+ *                      <tt>y + i</tt> está completa.
+ */
+void borrar_completas_columnas(MONSTRO_TCOLUMN *columnas, int y, int completas) {
+    int restantes = 4 - __builtin_popcount(completas & 0xF);
+    if (restantes == 4) return;
+    
+// Se trabaja con cuatro filas adicionales debajo del tablero ya que \c y 
+// puede ser negativa, como ocurre con la pieza I horizontal en el fondo
+    int fila = y + 4;
+    uint64_t abajo = ((uint64_t)1 << fila) - 1;
+// Las filas superiores que borrar_completas() no sobreescribe conservan su valor
+    int copiadas = (MONSTRO_TFIELD_SIZE + restantes > fila + 4) ? MONSTRO_TFIELD_SIZE + restantes : fila + 4;
+    uint64_t arriba = ~(((uint64_t)1 << copiadas) - 1);
+    for (int x = 0; x < MONSTRO_TFIELD_WIDTH; x++) {
+        uint64_t columna = (uint64_t)columnas[x] << 4;
+        uint64_t resultado = (columna & abajo) | ((columna >> (fila + 4)) << (fila + restantes));
+        for (int i = 0, j = 0; i < 4; i++)
+            if (!(completas & (1 << i)))
+                resultado |= ((columna >> (fila + i)) & 1) << (fila + j++);
+        columnas[x] = ((resultado & ~arriba) | (columna & arriba)) >> 4;
+    }
+}
+
+
+
+/**
+ * Regresa el índice del bit más alto de una columna.
+ * 
+ * @param columna       La columna, que no debe ser \c 0.
+ */
+static inline int bit_mas_alto(MONSTRO_TCOLUMN columna) {
+    return 63 - __builtin_clzll(columna);
+}
+
+
+
+/**
+ * Regresa la altura de una columna del índice, es decir, la posición 
+ * \c Y de su bloque más alto más uno.
+ * 
+ * @param columnas      Un apuntador a un arreglo de \c MONSTRO_TFIELD_WIDTH 
+ *                      \c MONSTRO_TCOLUMN representando las columnas del 
+ *                      tablero.
+ * @param x             La columna.
+ * @return              La altura de la columna; el piso del tablero 
+ *                      cuenta como una fila.
+ */
+int altura_columna(MONSTRO_TCOLUMN *columnas, int x) {
+    return columnas[x] ? bit_mas_alto(columnas[x]) + 1 : 0;
+}
+
+
+
+/**
+ * Calcula la posición \c Y en la que se anclaría una pieza si cayera 
+ * verticalmente desde la posición (x, y).
+ * 
+ * El costo es proporcional al número de bloques de la pieza, sin 
+ * importar la distancia que tenga que caer. La pieza no debe estar 
+ * incluida en el índice.
+ * 
+ * @param columnas      Un apuntador a un arreglo de \c MONSTRO_TFIELD_WIDTH 
+ *                      \c MONSTRO_TCOLUMN representando las columnas del 
+ *                      tablero.
+ * @param pieza         La pieza, representada como un entero de 64 bits 
+ *                      \c uint64_t.
+ * @param x             La posición \c x de la pieza.
+ * @param y             La posición \c y de la pieza.
+ * @return              La posición \c Y más baja a la que la pieza 
+ *                      puede caer desde (x, y).
+ */
+int caida_pieza(MONSTRO_TCOLUMN *columnas, uint64_t pieza, int x, int y) {
+    int resultado = -4;
+    
+    for (uint64_t dato = pieza; dato; dato &= dato - 1) {
+        int bit = __builtin_ctzll(dato);
+        int fila = bit / 16;
+        MONSTRO_TCOLUMN debajo = columnas[x + bit % 16] & (((MONSTRO_TCOLUMN)1 << (y + fila)) - 1);
+        int candidato = (debajo ? bit_mas_alto(debajo) + 1 : 0) - fila;
+        if (candidato > resultado) resultado = candidato;
+    }
+    
+    return resultado;
+}
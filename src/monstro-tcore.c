@@ -37,10 +37,17 @@
  * 
  *      uint16_t playfield[24];
  * 
- * These values are hardcoded in order for the minimal approach used 
- * here to work reliably while maintaining a simple code strcuture. 
- * However, despite the values being hardcoded, these are enough to 
- * represent any typical playfield size.
+ * These values are the defaults in order for the minimal approach used 
+ * here to work reliably while maintaining a simple code strcuture and 
+ * they are enough to represent any typical playfield size. Other sizes 
+ * can be selected at compile time by defining \c MONSTRO_TFIELD_SIZE 
+ * (number of rows) and \c MONSTRO_TFIELD_WIDTH (16, 32 or 64 bits per 
+ * row), in which case the playfield is an array of \c MONSTRO_TROW:
+ * 
+ *      MONSTRO_TROW playfield[MONSTRO_TFIELD_SIZE];
+ * 
+ * The dimensions are resolved by the preprocessor, so there's no run 
+ * time cost in any of the functions for supporting them.
  * 
  * Game pieces, passed as an argument to three of these functions, are 
  * expected to be represented as a single \c uint64_t where bits are 
@@ -60,6 +67,10 @@
  *                                              // 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 1
  *                                              // 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 1
  * 
+ * Pieces use this representation regardless of \c MONSTRO_TFIELD_WIDTH; 
+ * with wider rows, each 16 bit row of the piece is simply shifted into 
+ * the corresponding row of the playfield.
+ * 
  * @section SAMPLE_USAGE Sample usage
  * 
  * There are four function declarations providing the basic behavior 
@@ -207,90 +218,115 @@
 #include <stdint.h>
 #include <string.h>
 #include <stdbool.h>
+#if defined(__AVX2__) || defined(__BMI2__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+#include "monstro-tcore.h"
 
-
-
-/**
- * Pone una pieza en la posición (x, y) del tablero.
- * 
- * Esta función coloca una pieza en el tablero. La pieza a colocar 
- * debe encajar libremente en la posición especificada, de 
- * lo contrario se podría producir basura en el tablero.
- * 
- * @param area_de_juego Un apuntador a un arreglo de \c uint16_t 
- *                      representando el tablero del juego.
- * @param pieza         La pieza a colocar, representada como un entero 
- *                      de 64 bits \c uint64_t.
- * @param x             La posición \c x en la que se colocará la pieza.
- * @param y             La posición \c y en la que se colocará la pieza.
- */
-void poner_pieza(uint16_t *area_de_juego, uint64_t pieza, int x, int y) {
-    uint64_t *destino = (uint64_t *)&area_de_juego[y];
-    uint64_t dato = pieza << x;
-    *destino |= dato;
-}
+// Unless the inline version of the core is used, this file provides the 
+// external definitions of the functions in monstro-tcore-inline.h
+#ifndef MONSTRO_TWANT_INLINE_CORE
+#define MONSTRO_TCORE_INLINE
+#include "monstro-tcore-inline.h"
+#endif
 
 
 
 /**
- * Borra una pieza de la posición (x, y) del tablero.
+ * Verifica en una sola llamada todas las posiciones \c X en las que se 
+ * pueden colocar las cuatro rotaciones de una pieza a la altura \c y.
  * 
- * Esta función borra del tablero una pieza previamente colocada con la 
- * función poner_pieza(). Llamar esta función sin haber llamado 
- * previamente poner_pieza(), o bien usando coordenadas distintas a las 
- * que se usaron para colocar la pieza, podría producir basura en 
- * el tablero.
+ * Esta función equivale a llamar puede_mover() para cada una de las 
+ * rotaciones de la pieza y para cada valor de \c x entre \c 0 y \c 15, 
+ * pero lee las cuatro filas del tablero una sola vez y, cuando el 
+ * compilador lo permite, verifica varios desplazamientos a la vez 
+ * usando instrucciones AVX2 o SSE2.
  * 
- * @param area_de_juego Un apuntador a un arreglo de \c uint16_t 
- *                      representando el tablero del juego.
- * @param pieza         La pieza a colocar, representada como un entero 
- *                      de 64 bits \c uint64_t.
- * @param x             La posición \c x en la que se colocará la pieza.
- * @param y             La posición \c y en la que se colocará la pieza.
- */
-void borrar_pieza(uint16_t *area_de_juego, uint64_t pieza, int x, int y) {
-    uint64_t *destino = (uint64_t *)&area_de_juego[y];
-    uint64_t dato = pieza << x;
-    *destino ^= dato;
-}
-
-
-
-/**
- * Verifica si se puede colocar una pieza en el tablero en la 
- * posición (x, y).
+ * Esta función sólo está disponible cuando el tablero tiene filas de 
+ * 16 bits, que es el valor predeterminado de \c MONSTRO_TFIELD_WIDTH.
  * 
- * Esta función verifica si se puede colocar una pieza en el tablero. 
- * Regresa \c true si la pieza puede encajar libremente en el tablero; 
- * de lo contrario regresa \c false.
+ * El resultado usa la misma representación que las piezas: cada 
+ * rotación ocupa 16 bits, de forma que el bit <tt>(r * 16 + x)</tt> 
+ * está encendido si la rotación \c r puede ser colocada en la 
+ * posición (x, y):
  * 
- * @param area_de_juego Un apuntador a un arreglo de \c uint16_t 
+ *      uint64_t libres = posiciones_libres(area_de_juego, T, y);
+ *      if (libres & ((uint64_t)1 << (r * 16 + x)))
+ *          // puede_mover(area_de_juego, T[r], x, y) regresaría true
+ * 
+ * @param area_de_juego Un apuntador a un arreglo de \c MONSTRO_TROW 
  *                      representando el tablero del juego.
- * @param pieza         La pieza a colocar, representada como un entero 
- *                      de 64 bits \c uint64_t.
- * @param x             La posición \c x en la que se verificará si 
- *                      puede ser colocada la pieza.
+ * @param rotaciones    Un arreglo con las cuatro rotaciones de la pieza, 
+ *                      cada una representada como un entero de 64 bits 
+ *                      \c uint64_t.
  * @param y             La posición \c y en la que se verificará si 
- *                      puede ser colocada la pieza.
- * @return              \c true si la pieza puede ser colocada 
- *                      libremente en el tablero en la posición (x, y); 
- *                      de lo contrario, \c false.
+ *                      pueden ser colocadas las rotaciones de la pieza.
+ * @return              Una máscara de 64 bits con las posiciones \c X 
+ *                      libres para cada una de las cuatro rotaciones.
  */
-int puede_mover(uint16_t *area_de_juego, uint64_t pieza, int x, int y) {
-    uint64_t *destino = (uint64_t *)&area_de_juego[y];
-    uint64_t dato = pieza << x;
-    uint64_t resultado = *destino | dato;
-    resultado = resultado ^ dato;
-    if (resultado == *destino) return true;
-    return false;
+#if MONSTRO_TFIELD_WIDTH == 16
+uint64_t posiciones_libres(MONSTRO_TROW *area_de_juego, const uint64_t *rotaciones, int y) {
+    uint64_t tablero;
+    uint64_t resultado = 0;
+    memcpy(&tablero, &area_de_juego[y], sizeof(tablero));
+    
+#if defined(__AVX2__)
+// Cuatro desplazamientos de la misma rotación por cada instrucción
+    __m256i t = _mm256_set1_epi64x(tablero);
+    __m256i cero = _mm256_setzero_si256();
+    for (int r = 0; r < 4; r++) {
+        __m256i p = _mm256_set1_epi64x(rotaciones[r]);
+        __m256i x = _mm256_setr_epi64x(0, 1, 2, 3);
+        for (int i = 0; i < 16; i += 4) {
+            __m256i choque = _mm256_and_si256(_mm256_sllv_epi64(p, x), t);
+            uint64_t libres = _mm256_movemask_pd(_mm256_castsi256_pd(_mm256_cmpeq_epi64(choque, cero)));
+            resultado |= libres << (r * 16 + i);
+            x = _mm256_add_epi64(x, _mm256_set1_epi64x(4));
+        }
+    }
+#elif defined(__SSE2__)
+// Dos rotaciones con el mismo desplazamiento por cada instrucción; SSE2 no 
+// tiene comparación de 64 bits, así que se combinan las mitades de 32 bits
+    __m128i t = _mm_set1_epi64x(tablero);
+    __m128i cero = _mm_setzero_si128();
+    for (int r = 0; r < 4; r += 2) {
+        __m128i p = _mm_set_epi64x(rotaciones[r + 1], rotaciones[r]);
+        for (int x = 0; x < 16; x++) {
+            __m128i choque = _mm_and_si128(_mm_sll_epi64(p, _mm_cvtsi32_si128(x)), t);
+            __m128i igual = _mm_cmpeq_epi32(choque, cero);
+            igual = _mm_and_si128(igual, _mm_shuffle_epi32(igual, _MM_SHUFFLE(2, 3, 0, 1)));
+            uint64_t libres = _mm_movemask_pd(_mm_castsi128_pd(igual));
+            resultado |= (libres & 1) << (r * 16 + x);
+            resultado |= (libres >> 1) << ((r + 1) * 16 + x);
+        }
+    }
+#else
+    for (int r = 0; r < 4; r++)
+        for (int x = 0; x < 16; x++)
+            if (!((rotaciones[r] << x) & tablero))
+                resultado |= (uint64_t)1 << (r * 16 + x);
+#endif
+    
+    return resultado;
 }
+#endif
 
 
 
 /**
  * Borra las líneas completas del tablero.
  * 
- * @param area_de_juego Un apuntador a un arreglo de \c uint16_t 
+ * Las cuatro filas a partir de \c y se revisan y se compactan en un 
+ * solo paso y sin saltos condicionales: primero se construye una 
+ * máscara con las filas completas y después se juntan las filas 
+ * restantes, usando las instrucciones PEXT/PDEP de BMI2 cuando el 
+ * compilador lo permite. El piso del tablero, <tt>area_de_juego[0]</tt>, 
+ * nunca se considera una línea completa, así que ya no es necesario 
+ * modificarlo temporalmente.
+ * 
+ * @param area_de_juego Un apuntador a un arreglo de \c MONSTRO_TROW 
  *                      representando el tablero del juego.
  * @param y             La posición \c Y en la que se ancló la última 
  *                      pieza. Este parámetro es importante para que 
@@ -298,23 +334,104 @@ int puede_mover(uint16_t *area_de_juego, uint64_t pieza, int x, int y) {
  *                      basa en el hecho de que las líneas completas 
  *                      siempre estarán definidas por la posición en la 
  *                      que se colocó la última pieza.
+ * @return              Una máscara de 4 bits con las líneas que fueron 
+ *                      borradas, donde el bit \c i corresponde a la 
+ *                      fila <tt>y + i</tt>.
  */
-void borrar_completas(uint16_t *area_de_juego, int y) {
-    uint16_t *origen = (uint16_t *)&area_de_juego[y];
-    uint64_t destino = 0;
-    int i = 0;
+int borrar_completas(MONSTRO_TROW *area_de_juego, int y) {
+// Las filas por debajo de la fila 1 (el piso) no cuentan como completas
+    int validas = 0xF << ((y < 1) ? 1 - y : 0);
+    int completas, i;
+#if MONSTRO_TFIELD_WIDTH == 16
+    const uint64_t altos = 0x8000800080008000ULL;
+    const uint64_t bajos = 0x7FFF7FFF7FFF7FFFULL;
+    uint64_t origen, vacias, destino;
+    
+    memcpy(&origen, &area_de_juego[y], sizeof(origen));
+// El bit alto de cada fila de 16 bits queda encendido si a la fila le 
+// falta al menos un bloque; la suma no acarrea entre filas
+    vacias = ~origen;
+    vacias = (((vacias & bajos) + bajos) | vacias) & altos;
+#if defined(__BMI2__)
+    completas = ~_pext_u64(vacias, altos) & validas & 0xF;
+    destino = _pext_u64(origen, _pdep_u64(~completas & 0xF, 0x0001000100010001ULL) * 0xFFFF);
+#else
+    completas = ~((vacias >> 15 & 1) | (vacias >> 30 & 2) | (vacias >> 45 & 4) | (vacias >> 60 & 8)) & validas & 0xF;
+    destino = 0;
+    i = 0;
+    for (int j = 0; j < 4; j++) {
+        int mantener = !(completas >> j & 1);
+        destino |= (origen >> j * 16 & -(uint64_t)mantener & 0xFFFF) << i * 16;
+        i += mantener;
+    }
+#endif
+    if (!completas)
+        return 0;
+    i = 4 - __builtin_popcount(completas);
+    memcpy(&area_de_juego[y], &destino, sizeof(destino));
+#else
+    MONSTRO_TROW destino[4] = {0};
+    
+    completas = 0;
+    i = 0;
+    for (int j = 0; j < 4; j++) {
+        MONSTRO_TROW fila = area_de_juego[y + j];
+        int mantener = (fila != MONSTRO_TFULL_ROW) | !(validas >> j & 1);
+        completas |= !mantener << j;
+        destino[i] = fila & -(MONSTRO_TROW)mantener;
+        i += mantener;
+    }
+    if (!completas)
+        return 0;
+    memcpy(&area_de_juego[y], destino, sizeof(destino));
+#endif
+    memmove(&area_de_juego[y + i], &area_de_juego[y + 4], (MONSTRO_TFIELD_SIZE - 4 - y) * sizeof(MONSTRO_TROW));
     
-    // safeguard
-    area_de_juego[0] = 0x7FFF;
+    return completas;
+}
+
+
+
+
+/**
+ * Sube el contenido del tablero \c filas posiciones e inserta filas de 
+ * basura en el fondo, justo encima del piso, como ocurre con los ataques 
+ * de un juego de varios jugadores.
+ * 
+ * Todas las filas se insertan con un solo desplazamiento del tablero, 
+ * sin importar cuántas sean, así que la basura de varios ataques 
+ * recibidos en el mismo ciclo debe juntarse en una sola llamada en lugar 
+ * de desplazar el tablero una vez por cada ataque o por cada fila. El 
+ * piso, <tt>area_de_juego[0]</tt>, no se modifica y las filas de basura 
+ * deben incluir los bits de las paredes.
+ * 
+ * @param area_de_juego Un apuntador a un arreglo de \c MONSTRO_TROW 
+ *                      representando el tablero del juego, sin la pieza 
+ *                      en juego.
+ * @param basura        Un apuntador a un arreglo de \c filas 
+ *                      \c MONSTRO_TROW con las filas a insertar, donde 
+ *                      <tt>basura[0]</tt> queda en la fila 1, justo 
+ *                      encima del piso.
+ * @param filas         El número de filas a insertar, de \c 0 a 
+ *                      <tt>MONSTRO_TFIELD_SIZE - 1</tt>; con un valor 
+ *                      mayor sólo se insertan las primeras 
+ *                      <tt>MONSTRO_TFIELD_SIZE - 1</tt> filas.
+ * @return              El OR de las filas que salieron por la parte 
+ *                      superior del tablero, para que la lógica pueda 
+ *                      saber si se perdieron bloques; \c 0 si no salió 
+ *                      ninguna fila.
+ */
+MONSTRO_TROW subir_basura(MONSTRO_TROW *area_de_juego, const MONSTRO_TROW *basura, int filas) {
+    MONSTRO_TROW fuera = 0;
     
-    destino |= ((uint16_t)~*origen) ? (uint64_t)*origen << i++ * 16 : 0; origen++;
-    destino |= ((uint16_t)~*origen) ? (uint64_t)*origen << i++ * 16 : 0; origen++;
-    destino |= ((uint16_t)~*origen) ? (uint64_t)*origen << i++ * 16 : 0; origen++;
-    destino |= ((uint16_t)~*origen) ? (uint64_t)*origen << i++ * 16 : 0; origen++;
-    origen = &area_de_juego[y];
-    *(uint64_t *)origen = destino;
-    memmove(&area_de_juego[y + i], &area_de_juego[y + 4], (20 - y) * 2);  // 20 - y = 24 - 4 - y
+    if (filas <= 0)
+        return 0;
+    if (filas > MONSTRO_TFIELD_SIZE - 1)
+        filas = MONSTRO_TFIELD_SIZE - 1;
+    for (int y = MONSTRO_TFIELD_SIZE - filas; y < MONSTRO_TFIELD_SIZE; y++)
+        fuera |= area_de_juego[y];
+    memmove(&area_de_juego[1 + filas], &area_de_juego[1], (MONSTRO_TFIELD_SIZE - 1 - filas) * sizeof(MONSTRO_TROW));
+    memcpy(&area_de_juego[1], basura, filas * sizeof(MONSTRO_TROW));
     
-    // safeguard
-    area_de_juego[0] = 0xFFFF;
+    return fuera;
 }
@@ -0,0 +1,260 @@
+/**
+ * @file monstro-tevaluate.c
+ * 
+ * @section LICENSE License
+ * 
+ * This is free and unencumbered software released into the public domain.
+ *
+ * Anyone is free to copy, modify, publish, use, compile, sell, or
+ * distribute this software, either in source code form or as a compiled
+ * binary, for any purpose, commercial or non-commercial, and by any
+ * means.
+ * 
+ * In jurisdictions that recognize copyright laws, the author or authors
+ * of this software dedicate any and all copyright interest in the
+ * software to the public domain. We make this dedication for the benefit
+ * of the public at large and to the detriment of our heirs and
+ * successors. We intend this dedication to be an overt act of
+ * relinquishment in perpetuity of all present and future rights to this
+ * software under copyright law.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+ * OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ * 
+ * For more information, please refer to <https://unlicense.org>
+ * 
+ * @section DESCRIPTION Description
+ * 
+ * Test bench for the board feature extractor in monstro-tfeatures.c. 
+ * It plays games with a bot that tries every rotation and column of 
+ * each piece, dropped straight down from where it spawned, and locks 
+ * it where the features of the resulting playfield, after clearing its 
+ * lines, score best; it reports how long extract_features() takes for 
+ * each of those playfields, and extract_features_batch() for all of 
+ * them at once. Usage:
+ * 
+ *      evaluate-main [-c] [-r] [-n games] [-p pieces] [-s seed]
+ * 
+ * \c -r makes the bot pick a random placement instead of the best one, 
+ * which leaves a messier stack, with more holes and wells. \c -c also 
+ * checks the features of every playfield, from both functions, against 
+ * the same features counted cell by cell. The exit status is \c 1 if 
+ * any of them didn't match.
+ */
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include "monstro-tcore.h"
+#include "monstro-tlogic.h"
+#include "monstro-tpieces.h"
+#include "monstro-tfeatures.h"
+
+#define CANDIDATES      (4 * (MONSTRO_TFIELD_WIDTH - 3))
+
+// A playfield with the guard rows below it (see monstro-tlogic.h) and 4 
+// empty rows above it, as borrar_completas() reads and moves the 4 rows 
+// from where the piece is
+typedef struct {
+    MONSTRO_TROW guard[MONSTRO_TGUARD_ROWS];
+    MONSTRO_TROW playfield[MONSTRO_TFIELD_SIZE + 4];
+} SCRATCH;
+
+// A straight drop of the current piece
+typedef struct {
+    int rotation, x, y;
+    int lines;
+} CANDIDATE;
+
+MONSTRO_TGAME board;
+SCRATCH scratch;
+CANDIDATE candidates[CANDIDATES];
+MONSTRO_TROW playfields[CANDIDATES][MONSTRO_TFIELD_SIZE];
+MONSTRO_TFEATURES features[CANDIDATES], batch_features[CANDIDATES];
+
+
+
+double now(void) {
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return t.tv_sec + t.tv_nsec * 1e-9;
+}
+
+
+
+uint32_t next_random(uint32_t *state) {
+    *state = *state * 1103515245 + 12345;
+    return *state >> 16;
+}
+
+
+
+/*
+ * Scores a playfield from its features and the lines cleared to get it.
+ */
+int score_features(const MONSTRO_TFEATURES *f, int lines) {
+    return lines * 30 - f->aggregate_height * 5 - f->holes * 35 - f->bumpiness * 2 - 
+           f->row_transitions * 3 - f->column_transitions * 9 - f->wells * 3;
+}
+
+
+
+int filled(const MONSTRO_TROW *playfield, int x, int y) {
+    return (playfield[y] >> x) & 1;
+}
+
+
+
+/*
+ * The same features as extract_features(), counted cell by cell.
+ */
+MONSTRO_TFEATURES reference_features(const MONSTRO_TROW *playfield) {
+    MONSTRO_TFEATURES f = {0};
+    int heights[MONSTRO_TFIELD_WIDTH] = {0};
+    const int left = MONSTRO_TWALL_SIZE + MONSTRO_TWELL_WIDTH - 1, right = MONSTRO_TWALL_SIZE;
+    
+    for (int x = right; x <= left; x++) {
+        int depth = 0;
+        for (int y = MONSTRO_TFIELD_SIZE - 1; y > 0; y--) {
+            if (filled(playfield, x, y) && heights[x] == 0)
+                heights[x] = y;
+            if (!filled(playfield, x, y) && heights[x] > y)
+                f.holes++;
+            f.column_transitions += filled(playfield, x, y) != filled(playfield, x, y - 1);
+            if (!filled(playfield, x, y) && filled(playfield, x - 1, y) && filled(playfield, x + 1, y))
+                f.wells += ++depth;
+            else
+                depth = 0;
+        }
+        f.aggregate_height += heights[x];
+        f.height = (heights[x] > f.height) ? heights[x] : f.height;
+        if (x > right)
+            f.bumpiness += abs(heights[x] - heights[x - 1]);
+    }
+    for (int y = 1; y < MONSTRO_TFIELD_SIZE; y++)
+        for (int x = right - 1; x <= left; x++)
+            f.row_transitions += filled(playfield, x, y) != filled(playfield, x + 1, y);
+    return f;
+}
+
+
+
+/*
+ * Finds every straight drop of the current piece from where it 
+ * spawned, along with the playfield it leaves once its lines are 
+ * cleared.
+ */
+int find_candidates(const MONSTRO_TGAME *game) {
+    MONSTRO_TROW *field = scratch.playfield;
+    int count = 0;
+    
+    for (int y = MONSTRO_TFIELD_SIZE; y < MONSTRO_TFIELD_SIZE + 4; y++)
+        field[y] = MONSTRO_TWALLS;
+    for (int rotation = 0; rotation < 4; rotation++) {
+        uint64_t piece = piezas[game->piece][rotation];
+        for (int x = 0; x <= MONSTRO_TFIELD_WIDTH - 4; x++) {
+            memcpy(field, game->playfield, sizeof(game->playfield));
+            borrar_pieza(field, piezas[game->piece][game->rotation], game->x, game->y);
+            int y = game->y;
+            if (!puede_mover(field, piece, x, y))
+                continue;
+            while (puede_mover(field, piece, x, y - 1))
+                y--;
+            poner_pieza(field, piece, x, y);
+            int lines = __builtin_popcount(borrar_completas(field, y));
+            candidates[count] = (CANDIDATE){rotation, x, y, lines};
+            memcpy(playfields[count++], field, sizeof(playfields[0]));
+        }
+    }
+    return count;
+}
+
+
+
+int main(int argc, char **argv) {
+    long games = 100, pieces = 1000;
+    uint64_t seed = 1;
+    uint32_t random = 1;
+    int check = false, randomly = false, option;
+    
+    while ((option = getopt(argc, argv, "crn:p:s:")) != -1)
+        switch (option) {
+            case 'c': check = true; break;
+            case 'r': randomly = true; break;
+            case 'n': games = atol(optarg); break;
+            case 'p': pieces = atol(optarg); break;
+            case 's': seed = strtoull(optarg, NULL, 10); break;
+            default:
+                fprintf(stderr, "usage: %s [-c] [-r] [-n games] [-p pieces] [-s seed]\n", argv[0]);
+                return 2;
+        }
+    
+    uint64_t boards = 0, lines = 0, mismatches = 0, errors = 0;
+    double busy = 0.0, batch_busy = 0.0, start = now();
+    MONSTRO_TGAME *game = &board;
+    for (long n = 0; n < games; n++) {
+        start_game(game, seed + n);
+        for (long i = 0; i < pieces && spawn_piece(game); i++) {
+            int count = find_candidates(game);
+            if (count == 0)
+                break;
+            double t = now();
+            for (int j = 0; j < count; j++)
+                extract_features(playfields[j], &features[j]);
+            busy += now() - t;
+            t = now();
+            extract_features_batch(playfields[0], count, batch_features);
+            batch_busy += now() - t;
+            boards += count;
+            if (check)
+                for (int j = 0; j < count; j++) {
+                    MONSTRO_TFEATURES expected = reference_features(playfields[j]);
+                    mismatches += memcmp(&features[j], &expected, sizeof(expected)) != 0 || 
+                                  memcmp(&batch_features[j], &expected, sizeof(expected)) != 0;
+                }
+            
+        // Lock the piece at the best candidate
+            int best = 0, best_score = INT32_MIN;
+            for (int j = 0; j < count; j++) {
+                int score = randomly ? (int)next_random(&random) : 
+                            score_features(&features[j], candidates[j].lines) - (int)(next_random(&random) & 3);
+                if (score > best_score) {
+                    best_score = score;
+                    best = j;
+                }
+            }
+            const CANDIDATE *c = &candidates[best];
+            borrar_pieza(game->playfield, piezas[game->piece][game->rotation], game->x, game->y);
+            game->rotation = c->rotation;
+            game->x = c->x;
+            game->y = c->y;
+            poner_pieza(game->playfield, piezas[game->piece][c->rotation], c->x, c->y);
+            game->inputs = MONSTRO_TINPUT_UP;
+            mover_pieza(game);
+            if (!(game->flags & MONSTRO_TACTION_SNAP) || game->y != c->y)
+                errors++;
+            lines += __builtin_popcount(game->flags & MONSTRO_TACTION_CLEARED);
+        }
+    }
+    double seconds = now() - start;
+    
+    printf("games: count=%ld lines=%llu\n", games, (unsigned long long)lines);
+    printf("features: boards=%llu average=%.1fns boards_per_second=%.0f\n", (unsigned long long)boards, 
+           boards ? busy * 1e9 / boards : 0.0, boards / busy);
+    printf("batch: average=%.1fns boards_per_second=%.0f\n", boards ? batch_busy * 1e9 / boards : 0.0, 
+           boards / batch_busy);
+    if (check)
+        printf("check: mismatches=%llu\n", (unsigned long long)mismatches);
+    printf("total: seconds=%.3f errors=%llu\n", seconds, (unsigned long long)errors);
+    
+    return errors != 0 || mismatches != 0;
+}
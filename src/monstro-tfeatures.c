@@ -0,0 +1,331 @@
+/**
+ * @file monstro-tfeatures.c
+ * 
+ * @section LICENSE License
+ * 
+ * This is free and unencumbered software released into the public domain.
+ *
+ * Anyone is free to copy, modify, publish, use, compile, sell, or
+ * distribute this software, either in source code form or as a compiled
+ * binary, for any purpose, commercial or non-commercial, and by any
+ * means.
+ * 
+ * In jurisdictions that recognize copyright laws, the author or authors
+ * of this software dedicate any and all copyright interest in the
+ * software to the public domain. We make this dedication for the benefit
+ * of the public at large and to the detriment of our heirs and
+ * successors. We intend this dedication to be an overt act of
+ * relinquishment in perpetuity of all present and future rights to this
+ * software under copyright law.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+ * OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ * 
+ * For more information, please refer to <https://unlicense.org>
+ * 
+ * @section DESCRIPTION Description
+ * 
+ * This file contains an optional board feature extractor, available 
+ * only when \c MONSTRO_TWANT_FEATURES is defined, that finds the 
+ * features the evaluation functions of most bots are built from, for 
+ * a playfield with the pieces locked on it:
+ * 
+ *      MONSTRO_TFEATURES features;
+ *      extract_features(playfield, &features);
+ *      int score = -4 * features.aggregate_height - 8 * features.holes 
+ *                  - 2 * features.bumpiness - ...;
+ * 
+ * The features are counted over the columns of the well and over the 
+ * rows above the floor, hidden rows included, with the walls and the 
+ * floor taken as filled cells. The height of a column is the row of 
+ * its highest block, so a hole is an empty cell below it, and a well 
+ * cell is an empty cell with filled cells on both sides.
+ * 
+ * Every feature is a sum of bit counts over the rows of the playfield, 
+ * walked from the top of the stack down: the cells at or below the top 
+ * of each column are the rows ORed together so far, which give the 
+ * heights, and the holes are the cells of that mask missing from the 
+ * current row; shifting a row or that mask one column and XORing them 
+ * gives the row transitions and the bumpiness, and XORing two 
+ * consecutive rows gives the column transitions. The well cells of a 
+ * row are the empty cells of the row ANDed with the row shifted one 
+ * column each way, and their depths are carried from the row above. 
+ * The rows above the stack add the same two row transitions each, for 
+ * the walls, so they are never visited.
+ * 
+ * extract_features_batch() does the same for an array of playfields, 
+ * several at once, 8 playfields with SSE2 or 16 with AVX2 for the 
+ * default row size, using GCC vector extensions: each vector holds the 
+ * same row of every playfield, the bits are counted in parallel for 
+ * every byte of a vector and the well depths are kept as bit sliced 
+ * counters, one vector per bit, so there are no branches nor lookups 
+ * per row. Both give exactly the same features.
+ */
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include "monstro-tfeatures.h"
+
+#define WELL            ((MONSTRO_TROW)~MONSTRO_TWALLS)                 // Columns of the well
+#define PAIRS           ((MONSTRO_TROW)(WELL & (WELL >> 1)))            // Column x of each pair of well columns x and x + 1
+#define EDGES           ((MONSTRO_TROW)(WELL | (WELL >> 1)))            // Column x of each pair of columns x and x + 1 with one in the well
+#define EMPTY_TRANSITIONS   __builtin_popcountll((MONSTRO_TROW)(MONSTRO_TWALLS ^ (MONSTRO_TWALLS >> 1)) & EDGES)
+
+#if defined(__AVX2__)
+#define VECTOR_SIZE     32
+#else
+#define VECTOR_SIZE     16
+#endif
+#define LANES           (VECTOR_SIZE / (int)sizeof(MONSTRO_TROW))      // Playfields per vector
+#define PLANES          ((MONSTRO_TFIELD_SIZE <= 32) ? 5 : 6)           // Bits of the well depth counters
+#define SPAN            31      // Most rows whose bit counts fit in the bytes of a vector
+
+// Whether extract_features() adds the counts of a row together in a single 
+// integer, which is faster unless there's an instruction to count bits
+#if !defined(__POPCNT__) && MONSTRO_TFIELD_WIDTH == 16 && MONSTRO_TFIELD_SIZE <= SPAN + 1
+#define PACKED_COUNTS   1
+#else
+#define PACKED_COUNTS   0
+#endif
+
+typedef MONSTRO_TROW ROW_VECTOR __attribute__((vector_size(VECTOR_SIZE)));
+
+// Bit counts kept by extract_features_batch(); the well depths take one per counter bit
+enum { AGGREGATE_HEIGHT, HOLES, BUMPINESS, ROW_TRANSITIONS, COLUMN_TRANSITIONS, WELLS, COUNTS = WELLS + PLANES };
+
+
+
+/**
+ * Counts the bits set in every byte of an integer.
+ */
+static inline uint64_t count_bytes64(uint64_t v) {
+    v -= (v >> 1) & 0x5555555555555555ULL;
+    v = (v & 0x3333333333333333ULL) + ((v >> 2) & 0x3333333333333333ULL);
+    return (v + (v >> 4)) & 0x0F0F0F0F0F0F0F0FULL;
+}
+
+
+
+/**
+ * Returns the number of bits set in a row.
+ */
+static inline int count_bits(MONSTRO_TROW row) {
+#if defined(__POPCNT__)
+    return __builtin_popcountll(row);
+#else
+// Without the instruction, GCC calls a library function instead
+    return (count_bytes64(row) * 0x0101010101010101ULL) >> 56;
+#endif
+}
+
+
+
+/**
+ * Returns the highest row of a playfield that isn't empty, or \c 0 if 
+ * there's none.
+ */
+static inline int top_row(const MONSTRO_TROW *playfield) {
+    const int span = sizeof(uint64_t) / sizeof(MONSTRO_TROW);
+    MONSTRO_TROW walls[sizeof(uint64_t) / sizeof(MONSTRO_TROW)];
+    uint64_t empty, rows;
+    int y = MONSTRO_TFIELD_SIZE - 1;
+    
+    for (int i = 0; i < span; i++)
+        walls[i] = MONSTRO_TWALLS;
+    memcpy(&empty, walls, sizeof(empty));
+    
+// The empty rows above the stack are skipped several at a time
+    for (; y >= span; y -= span) {
+        memcpy(&rows, &playfield[y + 1 - span], sizeof(rows));
+        if (rows != empty)
+            break;
+    }
+    while (y > 0 && playfield[y] == MONSTRO_TWALLS)
+        y--;
+    return y;
+}
+
+
+
+/**
+ * Finds the features of a playfield.
+ * 
+ * @param playfield An array of \c MONSTRO_TFIELD_SIZE \c MONSTRO_TROW 
+ *                  representing the playfield, with the floor in row 
+ *                  \c 0 and without the current piece, as the features 
+ *                  of a game are meant to be found once its piece has 
+ *                  locked.
+ * @param features  The features of the playfield.
+ */
+void extract_features(const MONSTRO_TROW *playfield, MONSTRO_TFEATURES *features) {
+    int top = top_row(playfield);
+    int height = 0, aggregate_height = 0, holes = 0, bumpiness = 0, row_transitions = 0, column_transitions = 0, wells = 0;
+    uint8_t depths[MONSTRO_TFIELD_WIDTH] = {0};
+#if PACKED_COUNTS
+    uint64_t counts = 0;
+#endif
+    MONSTRO_TROW cover = 0, wells_above = 0;
+    MONSTRO_TROW above = playfield[(top < MONSTRO_TFIELD_SIZE - 1) ? top + 1 : top];
+    
+    for (int y = top; y > 0; y--) {
+        MONSTRO_TROW row = playfield[y];
+        MONSTRO_TROW well = ~row & (row << 1) & (row >> 1) & WELL;
+        MONSTRO_TROW hidden = cover & ~row;
+        MONSTRO_TROW grown = cover | (row & WELL);
+    // The columns whose highest block is in this row add it to the 
+    // aggregate height, which saves counting every row of each column
+        aggregate_height += y * count_bits(grown ^ cover);
+        cover = grown;
+        height += cover != 0;
+#if PACKED_COUNTS
+    // The other four counts are added together, each one in 16 bits of 
+    // the same integer
+        counts += count_bytes64(hidden | (uint64_t)((cover ^ (cover >> 1)) & PAIRS) << 16 | 
+                                (uint64_t)((row ^ (row >> 1)) & EDGES) << 32 | (uint64_t)((row ^ above) & WELL) << 48);
+#else
+        holes += count_bits(hidden);
+        bumpiness += count_bits((cover ^ (cover >> 1)) & PAIRS);
+        row_transitions += count_bits((row ^ (row >> 1)) & EDGES);
+        column_transitions += count_bits((row ^ above) & WELL);
+#endif
+    // Well cells are few, so their depths are counted one by one
+        for (MONSTRO_TROW cells = well; cells; cells &= cells - 1) {
+            int x = __builtin_ctzll(cells);
+            depths[x] = ((wells_above >> x) & 1) ? depths[x] + 1 : 1;
+            wells += depths[x];
+        }
+        above = row;
+        wells_above = well;
+    }
+#if PACKED_COUNTS
+    counts = (counts & 0x00FF00FF00FF00FFULL) + ((counts >> 8) & 0x00FF00FF00FF00FFULL);
+    holes = counts & 0xFFFF;
+    bumpiness = (counts >> 16) & 0xFFFF;
+    row_transitions = (counts >> 32) & 0xFFFF;
+    column_transitions = counts >> 48;
+#endif
+    column_transitions += count_bits((playfield[0] ^ above) & WELL);
+    
+    *features = (MONSTRO_TFEATURES){ .height = height, .aggregate_height = aggregate_height, .holes = holes, 
+                                     .bumpiness = bumpiness, 
+                                     .row_transitions = row_transitions + (MONSTRO_TFIELD_SIZE - 1 - top) * EMPTY_TRANSITIONS, 
+                                     .column_transitions = column_transitions, .wells = wells};
+}
+
+
+
+/**
+ * Counts the bits set in every byte of a vector; each byte of the 
+ * result holds at most 8, so up to \c SPAN of them can be added 
+ * together before sum_bytes().
+ */
+static inline ROW_VECTOR count_bytes(ROW_VECTOR v) {
+    v -= (v >> 1) & (MONSTRO_TROW)0x5555555555555555ULL;
+    v = (v & (MONSTRO_TROW)0x3333333333333333ULL) + ((v >> 2) & (MONSTRO_TROW)0x3333333333333333ULL);
+    return (v + (v >> 4)) & (MONSTRO_TROW)0x0F0F0F0F0F0F0F0FULL;
+}
+
+
+
+/**
+ * Adds the bytes of each lane of a vector together.
+ */
+static inline ROW_VECTOR sum_bytes(ROW_VECTOR v) {
+    v = (v & (MONSTRO_TROW)0x00FF00FF00FF00FFULL) + ((v >> 8) & (MONSTRO_TROW)0x00FF00FF00FF00FFULL);
+#if MONSTRO_TFIELD_WIDTH > 16
+    v = (v & (MONSTRO_TROW)0x0000FFFF0000FFFFULL) + ((v >> 16) & (MONSTRO_TROW)0x0000FFFF0000FFFFULL);
+#endif
+#if MONSTRO_TFIELD_WIDTH > 32
+    v = (v & (MONSTRO_TROW)0x00000000FFFFFFFFULL) + (v >> 32);
+#endif
+    return v;
+}
+
+
+
+/**
+ * Finds the features of an array of playfields; the result is the same 
+ * as calling extract_features() on each of them.
+ * 
+ * @param playfields    An array of \c count playfields, one after the 
+ *                      other, each one as expected by 
+ *                      extract_features().
+ * @param count         The number of playfields.
+ * @param features      An array of \c count \c MONSTRO_TFEATURES that 
+ *                      gets the features of each playfield.
+ */
+void extract_features_batch(const MONSTRO_TROW *playfields, int count, MONSTRO_TFEATURES *features) {
+    for (int first = 0; first < count; first += LANES) {
+        int lanes = (count - first < LANES) ? count - first : LANES;
+        const MONSTRO_TROW *lane_playfields[LANES];
+        int top = 0;
+        
+    // The lanes left over at the end repeat the first playfield
+        for (int i = 0; i < LANES; i++) {
+            lane_playfields[i] = playfields + (size_t)(first + ((i < lanes) ? i : 0)) * MONSTRO_TFIELD_SIZE;
+            int lane_top = top_row(lane_playfields[i]);
+            top = (lane_top > top) ? lane_top : top;
+        }
+        
+    // Each vector holds the same row of every playfield, up to the row 
+    // above the highest stack
+        int rows = (top < MONSTRO_TFIELD_SIZE - 1) ? top + 2 : MONSTRO_TFIELD_SIZE;
+        ROW_VECTOR field[MONSTRO_TFIELD_SIZE];
+        for (int y = 0; y < rows; y++)
+            for (int i = 0; i < LANES; i++)
+                field[y][i] = lane_playfields[i][y];
+        
+    // A well can't be deeper than the highest stack, which bounds the 
+    // bits its depth needs
+        int planes = top ? 32 - __builtin_clz(top) : 0;
+        ROW_VECTOR cover = {0}, heights = {0}, above = field[rows - 1], depths[PLANES];
+        ROW_VECTOR bytes[COUNTS], totals[COUNTS];
+        memset(depths, 0, sizeof(depths));
+        memset(bytes, 0, sizeof(bytes));
+        memset(totals, 0, sizeof(totals));
+        for (int y = top; y > 0; y--) {
+            ROW_VECTOR row = field[y];
+            ROW_VECTOR well = ~row & (row << 1) & (row >> 1) & WELL;
+            bytes[HOLES] += count_bytes(cover & ~row);
+            cover |= row & WELL;
+            bytes[AGGREGATE_HEIGHT] += count_bytes(cover);
+            heights -= (ROW_VECTOR)(cover != 0);
+            bytes[BUMPINESS] += count_bytes((cover ^ (cover >> 1)) & PAIRS);
+            bytes[ROW_TRANSITIONS] += count_bytes((row ^ (row >> 1)) & EDGES);
+            bytes[COLUMN_TRANSITIONS] += count_bytes((row ^ above) & WELL);
+        // Adding one to the depth of the well cells, which clears it 
+        // everywhere else, and counting the bits of each depth bit
+            ROW_VECTOR carry = well;
+            for (int k = 0; k < planes; k++) {
+                ROW_VECTOR bit = depths[k];
+                depths[k] = (bit ^ carry) & well;
+                carry &= bit;
+                bytes[WELLS + k] += count_bytes(depths[k]);
+            }
+            above = row;
+            
+            if (y % SPAN == 1)
+                for (int c = 0; c < COUNTS; c++) {
+                    totals[c] += sum_bytes(bytes[c]);
+                    bytes[c] ^= bytes[c];
+                }
+        }
+        totals[COLUMN_TRANSITIONS] += sum_bytes(count_bytes((field[0] ^ above) & WELL));
+        
+        for (int i = 0; i < lanes; i++) {
+            int wells = 0;
+            for (int k = 0; k < PLANES; k++)
+                wells += (int)totals[WELLS + k][i] << k;
+            features[first + i] = (MONSTRO_TFEATURES){ .height = heights[i], .aggregate_height = totals[AGGREGATE_HEIGHT][i], 
+                                                        .holes = totals[HOLES][i], .bumpiness = totals[BUMPINESS][i], 
+                                                        .row_transitions = totals[ROW_TRANSITIONS][i] + (MONSTRO_TFIELD_SIZE - 1 - top) * EMPTY_TRANSITIONS, 
+                                                        .column_transitions = totals[COLUMN_TRANSITIONS][i], .wells = wells};
+        }
+    }
+}
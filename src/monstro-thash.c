@@ -0,0 +1,261 @@
+/**
+ * @file monstro-thash.c
+ * 
+ * @section LICENSE License
+ * 
+ * This is free and unencumbered software released into the public domain.
+ *
+ * Anyone is free to copy, modify, publish, use, compile, sell, or
+ * distribute this software, either in source code form or as a compiled
+ * binary, for any purpose, commercial or non-commercial, and by any
+ * means.
+ * 
+ * In jurisdictions that recognize copyright laws, the author or authors
+ * of this software dedicate any and all copyright interest in the
+ * software to the public domain. We make this dedication for the benefit
+ * of the public at large and to the detriment of our heirs and
+ * successors. We intend this dedication to be an overt act of
+ * relinquishment in perpetuity of all present and future rights to this
+ * software under copyright law.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+ * OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ * 
+ * For more information, please refer to <https://unlicense.org>
+ * 
+ * @section DESCRIPTION Description
+ * 
+ * This file contains an optional Zobrist hash of the playfield, 
+ * available only when \c MONSTRO_TWANT_HASH is defined. Each cell of 
+ * the playfield gets a random 64 bit key and the hash of a playfield 
+ * is the XOR of the keys of its solid cells, so that:
+ * 
+ * - Placing or removing a piece XORs the keys of its four blocks, see 
+ * poner_hash() and borrar_hash(); both are the same operation.
+ * - Clearing lines only changes the rows from the cleared ones up, so 
+ * borrar_completas_hash() updates the hash from those rows alone, 
+ * skipping the ones that didn't change. The work is bounded by 
+ * \c MONSTRO_TFIELD_SIZE rows, each hashed with one table lookup per 
+ * 4 bits.
+ * - calcular_hash() computes the same value from scratch.
+ * 
+ * Keys are generated from a fixed seed by iniciar_claves(), so hashes 
+ * are comparable between runs and between processes built with the 
+ * same playfield dimensions. The state of the piece in play is hashed 
+ * separately by hash_estado(), which lets the logic hash the locked 
+ * blocks only and add the piece in play on demand.
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "monstro-tcore.h"
+
+
+
+#define NIBBLES         (MONSTRO_TFIELD_WIDTH / 4)
+#define FILAS_CLAVES    (MONSTRO_TFIELD_SIZE + 4)     // Piece blocks can reach 3 rows above the playfield
+
+enum {CLAVES_VACIAS, CLAVES_GENERANDO, CLAVES_LISTAS};
+
+// Keys for every group of 4 cells in a row: claves[y][n][v] is the XOR 
+// of the keys of the cells set in v, at columns 4 * n to 4 * n + 3
+static uint64_t claves[FILAS_CLAVES][NIBBLES][16];
+static uint64_t claves_pieza[8][4];
+static uint64_t claves_x[64];
+static uint64_t claves_y[MONSTRO_TFIELD_SIZE + 8];
+static int claves_listas = CLAVES_VACIAS;
+
+
+
+/**
+ * Generador splitmix64, usado únicamente para las claves.
+ */
+static uint64_t siguiente_clave(uint64_t *estado) {
+    uint64_t z = (*estado += 0x9E3779B97F4A7C15ULL);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+}
+
+
+
+/**
+ * Regresa la clave de la celda (x, y).
+ */
+static inline uint64_t clave_celda(int x, int y) {
+    return claves[y][x / 4][1 << (x % 4)];
+}
+
+
+
+/**
+ * Regresa el hash de una fila del tablero colocada a la altura \c y.
+ */
+static inline uint64_t hash_fila(int y, MONSTRO_TROW fila) {
+    uint64_t hash = 0;
+    for (int n = 0; n < NIBBLES; n++)
+        hash ^= claves[y][n][(fila >> (n * 4)) & 0xF];
+    return hash;
+}
+
+
+
+/**
+ * Genera las claves.
+ */
+static void generar_claves(void) {
+    uint64_t estado = 0x6D6F6E7374726F73ULL;
+    
+    for (int y = 0; y < FILAS_CLAVES; y++)
+        for (int n = 0; n < NIBBLES; n++) {
+            uint64_t celda[4];
+            for (int i = 0; i < 4; i++)
+                celda[i] = siguiente_clave(&estado);
+            for (int v = 0; v < 16; v++) {
+                claves[y][n][v] = 0;
+                for (int i = 0; i < 4; i++)
+                    if (v & (1 << i))
+                        claves[y][n][v] ^= celda[i];
+            }
+        }
+    for (int p = 0; p < 8; p++)
+        for (int r = 0; r < 4; r++)
+            claves_pieza[p][r] = siguiente_clave(&estado);
+    for (int x = 0; x < 64; x++)
+        claves_x[x] = siguiente_clave(&estado);
+    for (int y = 0; y < MONSTRO_TFIELD_SIZE + 8; y++)
+        claves_y[y] = siguiente_clave(&estado);
+}
+
+
+
+/**
+ * Genera las claves usadas por el resto de las funciones de este 
+ * archivo. Las claves siempre son las mismas, así que llamar esta 
+ * función más de una vez no tiene ningún efecto. Puede llamarse desde 
+ * varios hilos a la vez: sólo el primero genera las claves y los demás 
+ * esperan a que estén publicadas.
+ */
+void iniciar_claves(void) {
+    int estado = CLAVES_VACIAS;
+    
+    if (__atomic_load_n(&claves_listas, __ATOMIC_ACQUIRE) == CLAVES_LISTAS)
+        return;
+    if (__atomic_compare_exchange_n(&claves_listas, &estado, CLAVES_GENERANDO, false, 
+                                    __ATOMIC_ACQUIRE, __ATOMIC_ACQUIRE)) {
+        generar_claves();
+        __atomic_store_n(&claves_listas, CLAVES_LISTAS, __ATOMIC_RELEASE);
+    }
+    else
+        while (__atomic_load_n(&claves_listas, __ATOMIC_ACQUIRE) != CLAVES_LISTAS)
+            ;
+}
+
+
+
+/**
+ * Calcula el hash de todo el tablero.
+ * 
+ * @param area_de_juego Un apuntador a un arreglo de \c MONSTRO_TROW 
+ *                      representando el tablero del juego.
+ * @return              El hash del tablero.
+ */
+uint64_t calcular_hash(MONSTRO_TROW *area_de_juego) {
+    uint64_t hash = 0;
+    for (int y = 0; y < MONSTRO_TFIELD_SIZE; y++)
+        hash ^= hash_fila(y, area_de_juego[y]);
+    return hash;
+}
+
+
+
+/**
+ * Pone una pieza en la posición (x, y) del hash; es el equivalente de 
+ * poner_pieza() para el hash.
+ * 
+ * @param hash          Un apuntador al hash del tablero.
+ * @param pieza         La pieza a colocar, representada como un entero 
+ *                      de 64 bits \c uint64_t.
+ * @param x             La posición \c x en la que se colocará la pieza.
+ * @param y             La posición \c y en la que se colocará la pieza.
+ */
+void poner_hash(uint64_t *hash, uint64_t pieza, int x, int y) {
+    for (uint64_t dato = pieza; dato; dato &= dato - 1) {
+        int bit = __builtin_ctzll(dato);
+        *hash ^= clave_celda(x + bit % 16, y + bit / 16);
+    }
+}
+
+
+
+/**
+ * Borra una pieza de la posición (x, y) del hash; es el equivalente de 
+ * borrar_pieza() para el hash.
+ * 
+ * @param hash          Un apuntador al hash del tablero.
+ * @param pieza         La pieza a borrar, representada como un entero 
+ *                      de 64 bits \c uint64_t.
+ * @param x             La posición \c x en la que se colocó la pieza.
+ * @param y             La posición \c y en la que se colocó la pieza.
+ */
+void borrar_hash(uint64_t *hash, uint64_t pieza, int x, int y) {
+    poner_hash(hash, pieza, x, y);
+}
+
+
+
+/**
+ * Actualiza el hash después de borrar las líneas completas; debe 
+ * llamarse justo después de borrar_completas(), con la máscara que 
+ * ésta regresó. Las filas anteriores a la llamada se reconstruyen a 
+ * partir del tablero y de la máscara, incluyendo las filas superiores 
+ * que borrar_completas() deja sin modificar.
+ * 
+ * @param hash          Un apuntador al hash del tablero.
+ * @param area_de_juego Un apuntador a un arreglo de \c MONSTRO_TROW 
+ *                      representando el tablero del juego, con las 
+ *                      líneas completas ya borradas.
+ * @param y             La posición \c Y en la que se ancló la última 
+ *                      pieza.
+ * @param completas     La máscara de 4 bits regresada por 
+ *                      borrar_completas().
+ */
+void borrar_completas_hash(uint64_t *hash, MONSTRO_TROW *area_de_juego, int y, int completas) {
+    int restantes = 4 - __builtin_popcount(completas & 0xF);
+    if (restantes == 4) return;
+    
+// Las cuatro filas a partir de y: las completas y, en orden, las que se conservaron
+    for (int i = 0, j = 0; i < 4; i++) {
+        MONSTRO_TROW antes = (completas & (1 << i)) ? MONSTRO_TFULL_ROW : area_de_juego[y + j++];
+        if (y + i >= 0 && y + i < MONSTRO_TFIELD_SIZE && antes != area_de_juego[y + i])
+            *hash ^= hash_fila(y + i, antes) ^ hash_fila(y + i, area_de_juego[y + i]);
+    }
+// Las filas de más arriba bajaron 4 - restantes posiciones
+    for (int i = y + 4; i < MONSTRO_TFIELD_SIZE; i++) {
+        MONSTRO_TROW antes = area_de_juego[i - 4 + restantes];
+        if (antes != area_de_juego[i])
+            *hash ^= hash_fila(i, antes) ^ hash_fila(i, area_de_juego[i]);
+    }
+}
+
+
+
+/**
+ * Regresa el hash del estado de la pieza en juego, para combinarlo 
+ * mediante XOR con el hash del tablero.
+ * 
+ * @param pieza         El número de la pieza, de \c 0 a \c 7.
+ * @param rotacion      La rotación de la pieza, de \c 0 a \c 3.
+ * @param x             La posición \c x de la pieza, de \c 0 a \c 63.
+ * @param y             La posición \c y de la pieza, de \c -4 a 
+ *                      <tt>MONSTRO_TFIELD_SIZE + 3</tt>.
+ * @return              El hash del estado de la pieza.
+ */
+uint64_t hash_estado(int pieza, int rotacion, int x, int y) {
+    return claves_pieza[pieza & 7][rotacion & 3] ^ claves_x[x & 63] ^ claves_y[y + 4];
+}
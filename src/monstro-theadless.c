@@ -0,0 +1,544 @@
+/**
+ * @file monstro-theadless.c
+ * 
+ * @section LICENSE License
+ * 
+ * This is free and unencumbered software released into the public domain.
+ *
+ * Anyone is free to copy, modify, publish, use, compile, sell, or
+ * distribute this software, either in source code form or as a compiled
+ * binary, for any purpose, commercial or non-commercial, and by any
+ * means.
+ * 
+ * In jurisdictions that recognize copyright laws, the author or authors
+ * of this software dedicate any and all copyright interest in the
+ * software to the public domain. We make this dedication for the benefit
+ * of the public at large and to the detriment of our heirs and
+ * successors. We intend this dedication to be an overt act of
+ * relinquishment in perpetuity of all present and future rights to this
+ * software under copyright law.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+ * OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ * 
+ * For more information, please refer to <https://unlicense.org>
+ * 
+ * @section DESCRIPTION Description
+ * 
+ * Headless implementation that plays games from input scripts as fast 
+ * as possible, without any display or timer, and writes their final 
+ * state and statistics. Usage:
+ * 
+ *      headless-main [-b] [-c] [-s] [-r] [-a archive] [-k seeks] script...
+ * 
+ * Each script is a text file, or - for the standard input, with one 
+ * game per file:
+ * 
+ *      # Lines starting with # are comments
+ *      seed 1234       # Seed for seed_game(); must come before any input, 0 if missing
+ *      30 -            # No input for 30 calls to mover_pieza()
+ *      4 LD            # Hold left and down for 4 calls
+ *      1 A             # Rotate left once
+ * 
+ * Inputs are any combination of U (hard drop), D, L, R, A (rotate left) 
+ * and B (rotate right), using the same input flags as the other 
+ * implementations, or - for no input. The game ends when the script 
+ * does or when a piece can't be spawned. The lines cleared increase 
+ * the speed just like in the ncurses implementation.
+ * 
+ * For each game a line with its statistics is written to the standard 
+ * output; \c -b also writes the final playfield and \c -s saves the 
+ * final state with save_snapshot() to a file named after the script 
+ * plus \c .snap.
+ * 
+ * \c -c checks the game after every tick of a script against the 
+ * playfield: posiciones_libres() against puede_mover() for every 
+ * rotation, column and row of the current piece and, when built with 
+ * \c MONSTRO_TWANT_COLUMNS, the column index against one built from 
+ * scratch, altura_columna() against a scan of each column and 
+ * caida_pieza() against dropping the piece with puede_mover() from 
+ * every column at its row and, when built with \c MONSTRO_TWANT_HASH, 
+ * the incremental hash and game_hash() against hashing the whole 
+ * playfield again with calcular_hash(). The exit status is \c 1 if 
+ * anything didn't match.
+ * 
+ * When built with \c MONSTRO_TWANT_REPLAY, \c -r also records each 
+ * game to a file named after the script plus \c .rpl, and any file 
+ * that starts like a replay is played back as one instead of being 
+ * read as a script, with its checkpoints verified; see monstro-treplay.c.
+ * 
+ * When built with \c MONSTRO_TWANT_ARCHIVE, \c -a appends every replay 
+ * recorded with \c -r and every replay file that plays back correctly 
+ * to the given archive, creating it if needed; see monstro-tarchive.c. 
+ * \c -k then opens the archive, which may also be one written before, 
+ * in which case no script is needed, seeks the given number of random 
+ * ticks of random replays with seek_replay() and checks each one 
+ * against a straight playback of the same replay up to the same tick, 
+ * comparing their game_checksum() and counters.
+ */
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <time.h>
+#include "monstro-tlogic.h"
+#include "monstro-tpieces.h"
+#ifdef MONSTRO_TWANT_REPLAY
+#include "monstro-treplay.h"
+#endif
+#ifdef MONSTRO_TWANT_ARCHIVE
+#include "monstro-tarchive.h"
+#endif
+
+
+
+typedef struct {
+    uint64_t seed;
+    long ticks;
+    long pieces;
+    long lines;
+    int level_lines;    // Lines cleared since the last speed increase
+    int game_over;
+} RESULT;
+
+int write_board = false;
+int write_snapshot = false;
+int check = false;
+long check_errors = 0;
+#ifdef MONSTRO_TWANT_REPLAY
+int write_replay = false;
+MONSTRO_TRECORDER recorder;
+#endif
+#ifdef MONSTRO_TWANT_ARCHIVE
+const char *archive_path = NULL;
+MONSTRO_TARCHIVE_WRITER archive;
+long seeks = 0;
+#endif
+
+
+
+/*
+ * Converts a string of input letters into input flags; returns -1 if 
+ * the string has an unknown letter.
+ */
+int parse_inputs(const char *text) {
+    int inputs = 0;
+    
+    for (; *text; text++)
+        switch (*text) {
+            case 'U': inputs |= MONSTRO_TINPUT_UP; break;
+            case 'D': inputs |= MONSTRO_TINPUT_DOWN; break;
+            case 'L': inputs |= MONSTRO_TINPUT_LEFT; break;
+            case 'R': inputs |= MONSTRO_TINPUT_RIGHT; break;
+            case 'A': inputs |= MONSTRO_TINPUT_ROTATE_LEFT; break;
+            case 'B': inputs |= MONSTRO_TINPUT_ROTATE_RIGHT; break;
+            case '-': break;
+            default: return -1;
+        }
+    return inputs;
+}
+
+
+
+/*
+ * Checks a game against its playfield, for -c; returns the number of 
+ * differences.
+ */
+int check_game(const MONSTRO_TGAME *game) {
+    MONSTRO_TGAME locked = *game;
+    const uint64_t *rotations = piezas[game->piece];
+    int errors = 0;
+    
+    borrar_pieza(locked.playfield, rotations[game->rotation], game->x, game->y);
+#if MONSTRO_TFIELD_WIDTH == 16
+    for (int y = -1; y <= MONSTRO_TFIELD_SIZE - 4; y++) {
+        uint64_t positions = posiciones_libres(locked.playfield, rotations, y);
+        for (int r = 0; r < 4; r++)
+            for (int x = 0; x < 16; x++)
+                errors += (int)((positions >> (r * 16 + x)) & 1) != puede_mover(locked.playfield, rotations[r], x, y);
+    }
+#endif
+#ifdef MONSTRO_TWANT_COLUMNS
+    MONSTRO_TCOLUMN columns[MONSTRO_TFIELD_WIDTH];
+    iniciar_columnas(columns, locked.playfield);
+    errors += memcmp(columns, game->columns, sizeof(columns)) != 0;
+    for (int x = 0; x < MONSTRO_TFIELD_WIDTH; x++) {
+        int height = MONSTRO_TFIELD_SIZE;
+        while (height > 0 && !((locked.playfield[height - 1] >> x) & 1))
+            height--;
+        errors += altura_columna(locked.columns, x) != height;
+    }
+    for (int r = 0; r < 4; r++)
+        for (int x = 0; x <= MONSTRO_TFIELD_WIDTH - 4; x++) {
+            int y = game->y;
+            if (!puede_mover(locked.playfield, rotations[r], x, y))
+                continue;
+            while (puede_mover(locked.playfield, rotations[r], x, y - 1))
+                y--;
+            errors += caida_pieza(locked.columns, rotations[r], x, game->y) != y;
+        }
+#endif
+#ifdef MONSTRO_TWANT_HASH
+    uint64_t hash = calcular_hash(locked.playfield);
+    errors += game->hash != hash;
+    errors += game_hash(&locked) != (hash ^ hash_estado(game->piece, game->rotation, game->x, game->y));
+#endif
+    return errors;
+}
+
+
+
+/*
+ * Game logic for one tick, the same as in the ncurses implementation 
+ * minus the drawing.
+ */
+void logic(MONSTRO_TGAME *game, int inputs, RESULT *result) {
+    game->inputs = inputs;
+#ifdef MONSTRO_TWANT_REPLAY
+    if (write_replay)
+        mover_pieza_recorded(&recorder, game);
+    else
+#endif
+    mover_pieza(game);
+    result->ticks++;
+    
+    if (game->flags & MONSTRO_TACTION_SPAWN) {
+        result->game_over = !spawn_piece(game);
+        result->pieces += !result->game_over;
+    }
+    if (game->flags & MONSTRO_TACTION_CLEARED) {
+    // Count cleared lines and increase speed every few lines
+        int lines = __builtin_popcount(game->flags & MONSTRO_TACTION_CLEARED);
+        result->lines += lines;
+        level_up(game, &result->level_lines, lines);
+    }
+    if (check && !result->game_over)
+        check_errors += check_game(game);
+}
+
+
+
+/*
+ * Plays the script in a file until it ends or the game is over; returns 
+ * false if the script can't be read.
+ */
+int play_script(FILE *file, const char *name, MONSTRO_TGAME *game, RESULT *result) {
+    char line[256], letters[16];
+    int started = false;
+    long number = 0;
+    unsigned long long seed;
+    
+    memset(result, 0, sizeof(*result));
+    for (; fgets(line, sizeof(line), file); number++) {
+        char *text = line + strspn(line, " \t");
+        long ticks;
+        
+        if (*text == '#' || *text == '\n' || *text == '\0')
+            continue;
+        if (!started && sscanf(text, "seed %llu", &seed) == 1) {
+            result->seed = seed;
+            continue;
+        }
+        
+        int inputs = -1;
+        if (sscanf(text, "%ld %15s", &ticks, letters) == 2)
+            inputs = parse_inputs(letters);
+        if (inputs < 0 || ticks < 0) {
+            fprintf(stderr, "%s:%ld: invalid line\n", name, number + 1);
+            return false;
+        }
+        
+        if (!started) {
+            start_game(game, result->seed);
+            result->game_over = !spawn_piece(game);
+            result->pieces = !result->game_over;
+#ifdef MONSTRO_TWANT_REPLAY
+            if (write_replay)
+                start_recording(&recorder, game, result->seed, MONSTRO_TREPLAY_INTERVAL);
+#endif
+            started = true;
+        }
+        while (ticks-- > 0 && !result->game_over)
+            logic(game, inputs, result);
+        if (result->game_over)
+            break;
+    }
+    
+// A script without inputs still gets a game, just with no ticks
+    if (!started) {
+        start_game(game, result->seed);
+        result->game_over = !spawn_piece(game);
+        result->pieces = !result->game_over;
+#ifdef MONSTRO_TWANT_REPLAY
+        if (write_replay)
+            start_recording(&recorder, game, result->seed, MONSTRO_TREPLAY_INTERVAL);
+#endif
+    }
+    return !ferror(file);
+}
+
+
+
+/*
+ * Writes the visible rows of the playfield, including the current piece.
+ */
+void print_board(MONSTRO_TGAME *game) {
+    for (int y = MONSTRO_TFIELD_SIZE - 5; y >= 0; y--) {
+        for (int x = MONSTRO_TFIELD_WIDTH - 1; x >= 0; x--)
+            putchar((game->playfield[y] >> x) & 1 ? '#' : '.');
+        putchar('\n');
+    }
+}
+
+
+
+/*
+ * Saves the final state of a game next to its script.
+ */
+int save_game(MONSTRO_TGAME *game, const char *name) {
+    uint8_t buffer[MONSTRO_TSNAPSHOT_SIZE];
+    char path[4096];
+    
+    snprintf(path, sizeof(path), "%s.snap", strcmp(name, "-") ? name : "stdin");
+    size_t size = save_snapshot(game, buffer);
+    FILE *file = fopen(path, "wb");
+    if (!file) return false;
+    int saved = fwrite(buffer, 1, size, file) == size;
+    return fclose(file) == 0 && saved;
+}
+
+
+
+#ifdef MONSTRO_TWANT_REPLAY
+/*
+ * Writes the replay recorded while playing a script next to it.
+ */
+int save_replay(const char *name, MONSTRO_TGAME *game) {
+    char path[4096];
+    
+    snprintf(path, sizeof(path), "%s.rpl", strcmp(name, "-") ? name : "stdin");
+    size_t size = finish_recording(&recorder, game);
+    FILE *file = fopen(path, "wb");
+    int saved = file && size > 0 && fwrite(recorder.data, 1, size, file) == size;
+    if (file && fclose(file) != 0) saved = false;
+#ifdef MONSTRO_TWANT_ARCHIVE
+    if (archive_path && !(size > 0 && append_replay(&archive, recorder.data, size, MONSTRO_TARCHIVE_INTERVAL))) saved = false;
+#endif
+    free_recording(&recorder);
+    return saved;
+}
+
+
+
+/*
+ * Plays a replay file back; returns false if it doesn't play to the end.
+ */
+int play_replay_file(FILE *file, const char *name, MONSTRO_TGAME *game, RESULT *result) {
+    static const char *outcomes[] = {"ok", "desync", "corrupt", "incompatible"};
+    MONSTRO_TREPLAY_RESULT replay;
+    uint8_t *data = NULL;
+    size_t size = 0, capacity = 0, n;
+    
+    do {
+        if (size == capacity) {
+            capacity = capacity * 2 + 65536;
+            uint8_t *grown = realloc(data, capacity);
+            if (!grown) break;
+            data = grown;
+        }
+        n = fread(data + size, 1, capacity - size, file);
+        size += n;
+    } while (n > 0);
+    
+    int outcome = play_replay(data, size, game, &replay), appended = true;
+#ifdef MONSTRO_TWANT_ARCHIVE
+    if (outcome == MONSTRO_TREPLAY_OK && archive_path && !append_replay(&archive, data, size, MONSTRO_TARCHIVE_INTERVAL)) {
+        fprintf(stderr, "%s: can't append the replay to %s\n", name, archive_path);
+        appended = false;
+    }
+#endif
+    free(data);
+    memset(result, 0, sizeof(*result));
+    result->seed = replay.seed;
+    result->ticks = replay.ticks;
+    result->pieces = replay.pieces;
+    result->lines = replay.lines;
+    result->game_over = replay.game_over;
+    printf("%s: replay=%s checkpoints=%llu\n", name, outcomes[outcome], (unsigned long long)replay.checkpoints);
+    if (outcome == MONSTRO_TREPLAY_DESYNC)
+        fprintf(stderr, "%s: desync at tick %llu\n", name, (unsigned long long)replay.ticks);
+    return outcome == MONSTRO_TREPLAY_OK && appended;
+}
+#endif
+
+
+
+#ifdef MONSTRO_TWANT_ARCHIVE
+uint32_t next_random(uint32_t *state) {
+    *state = *state * 1103515245 + 12345;
+    return *state >> 16;
+}
+
+
+
+/*
+ * Seeks random ticks of random replays of the archive and compares 
+ * each one with a straight playback of the replay up to the same tick; 
+ * returns the number of seeks that didn't match, or -1 if the archive 
+ * can't be opened.
+ */
+long check_seeks(const char *path, long count) {
+    MONSTRO_TARCHIVE reader;
+    MONSTRO_TGAME sought, played;
+    MONSTRO_TREPLAY_CURSOR sought_cursor, played_cursor;
+    MONSTRO_TREPLAY_RESULT sought_result, played_result;
+    const uint8_t *replay;
+    size_t size;
+    uint32_t random = 1;
+    long mismatches = 0;
+    
+    if (!open_archive(&reader, path))
+        return -1;
+    for (long n = 0; n < count && reader.count > 0; n++) {
+        uint64_t i = next_random(&random) % reader.count;
+        if (!archive_replay(&reader, i, &replay, &size) || 
+            start_replay(replay, size, &played, &played_cursor, &played_result) != MONSTRO_TREPLAY_PAUSED) {
+            mismatches++;
+            continue;
+        }
+        
+    // Seeking past the end plays the replay from its last keyframe to 
+    // the end, which gives its length
+        seek_replay(&reader, i, UINT64_MAX, &sought, &sought_cursor, &sought_result);
+        uint64_t tick = (((uint64_t)next_random(&random) << 16) | next_random(&random)) % (sought_result.ticks + 1);
+        
+        int sought_outcome = seek_replay(&reader, i, tick, &sought, &sought_cursor, &sought_result);
+        int played_outcome = continue_replay(replay, size, &played, &played_cursor, &played_result, tick);
+        if (sought_outcome != played_outcome || game_checksum(&sought, 0) != game_checksum(&played, 0) || 
+            memcmp(&sought_result, &played_result, sizeof(sought_result)) != 0 || 
+            sought_cursor.offset != played_cursor.offset || sought_cursor.run != played_cursor.run || 
+            sought_cursor.inputs != played_cursor.inputs) {
+            fprintf(stderr, "%s: replay %llu doesn't match at tick %llu\n", path, (unsigned long long)i, 
+                    (unsigned long long)tick);
+            mismatches++;
+        }
+    }
+    close_archive(&reader);
+    return mismatches;
+}
+#endif
+
+
+
+/*
+ * Plays every script given on the command line.
+ */
+int main(int argc, char **argv) {
+    MONSTRO_TGAME game;
+    RESULT result;
+    long games = 0, ticks = 0;
+    int status = 0, option;
+    
+    while ((option = getopt(argc, argv, "bcsra:k:")) != -1)
+        switch (option) {
+            case 'b': write_board = true; break;
+            case 'c': check = true; break;
+            case 's': write_snapshot = true; break;
+#ifdef MONSTRO_TWANT_REPLAY
+            case 'r': write_replay = true; break;
+#endif
+#ifdef MONSTRO_TWANT_ARCHIVE
+            case 'a': archive_path = optarg; break;
+            case 'k': seeks = atol(optarg); break;
+#endif
+            default:
+                fprintf(stderr, "usage: %s [-b] [-c] [-s] [-r] [-a archive] [-k seeks] script...\n", argv[0]);
+                return 2;
+        }
+#ifdef MONSTRO_TWANT_ARCHIVE
+    if ((optind == argc && seeks <= 0) || (seeks > 0 && !archive_path)) {
+#else
+    if (optind == argc) {
+#endif
+        fprintf(stderr, "usage: %s [-b] [-c] [-s] [-r] [-a archive] [-k seeks] script...\n", argv[0]);
+        return 2;
+    }
+#ifdef MONSTRO_TWANT_ARCHIVE
+    if (archive_path && !open_archive_writer(&archive, archive_path)) {
+        fprintf(stderr, "%s: can't open the archive\n", archive_path);
+        return 1;
+    }
+#endif
+    
+    clock_t start = clock();
+    for (int i = optind; i < argc; i++) {
+        const char *name = argv[i];
+        FILE *file = strcmp(name, "-") ? fopen(name, "r") : stdin;
+        if (!file) {
+            perror(name);
+            status = 1;
+            continue;
+        }
+#ifdef MONSTRO_TWANT_REPLAY
+        int c = getc(file);
+        if (c != EOF) ungetc(c, file);
+        int played = (c == 'M') ? play_replay_file(file, name, &game, &result) : 
+                                  play_script(file, name, &game, &result);
+        if (c != 'M' && write_replay && !(played ? save_replay(name, &game) : (free_recording(&recorder), true))) {
+            fprintf(stderr, "%s: can't save the replay\n", name);
+            status = 1;
+        }
+#else
+        int played = play_script(file, name, &game, &result);
+#endif
+        if (file != stdin) fclose(file);
+        if (!played) {
+            status = 1;
+            continue;
+        }
+        
+        printf("%s: seed=%llu ticks=%ld pieces=%ld lines=%ld game_over=%d\n", name, 
+               (unsigned long long)result.seed, result.ticks, result.pieces, result.lines, result.game_over);
+        if (write_board)
+            print_board(&game);
+        if (write_snapshot && !save_game(&game, name)) {
+            fprintf(stderr, "%s: can't save the snapshot\n", name);
+            status = 1;
+        }
+        games++;
+        ticks += result.ticks;
+    }
+    
+    double seconds = (double)(clock() - start) / CLOCKS_PER_SEC;
+    printf("total: games=%ld ticks=%ld seconds=%.3f\n", games, ticks, seconds);
+    if (check) {
+        printf("check: errors=%ld\n", check_errors);
+        if (check_errors != 0)
+            status = 1;
+    }
+#ifdef MONSTRO_TWANT_ARCHIVE
+    if (archive_path)
+        close_archive_writer(&archive);
+    if (seeks > 0) {
+        clock_t seek_start = clock();
+        long mismatches = check_seeks(archive_path, seeks);
+        if (mismatches < 0)
+            fprintf(stderr, "%s: can't open the archive\n", archive_path);
+        else
+            printf("seek: count=%ld mismatches=%ld seconds=%.3f\n", seeks, mismatches, 
+                   (double)(clock() - seek_start) / CLOCKS_PER_SEC);
+        if (mismatches != 0)
+            status = 1;
+    }
+#endif
+    
+    return status;
+}
@@ -0,0 +1,201 @@
+/**
+ * @file monstro-tlockstep.c
+ * 
+ * @section LICENSE License
+ * 
+ * This is free and unencumbered software released into the public domain.
+ *
+ * Anyone is free to copy, modify, publish, use, compile, sell, or
+ * distribute this software, either in source code form or as a compiled
+ * binary, for any purpose, commercial or non-commercial, and by any
+ * means.
+ * 
+ * In jurisdictions that recognize copyright laws, the author or authors
+ * of this software dedicate any and all copyright interest in the
+ * software to the public domain. We make this dedication for the benefit
+ * of the public at large and to the detriment of our heirs and
+ * successors. We intend this dedication to be an overt act of
+ * relinquishment in perpetuity of all present and future rights to this
+ * software under copyright law.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+ * OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ * 
+ * For more information, please refer to <https://unlicense.org>
+ * 
+ * @section DESCRIPTION Description
+ * 
+ * Test bench for the batch engine in monstro-tbatch.c. It plays a batch 
+ * of games with random inputs through mover_piezas() and, in lockstep, 
+ * the same games one at a time through mover_pieza(), then reports how 
+ * many ticks per second each of them runs. A game that tops out is 
+ * restarted with a new seed on both sides, so every game stays alive 
+ * for the whole run. Usage:
+ * 
+ *      lockstep-main [-c] [-n games] [-t ticks] [-s seed]
+ * 
+ * \c -c also compares every game of the batch against its copy after 
+ * every tick, playfield, piece, counters and action flags alike. The 
+ * exit status is \c 1 if any of them didn't match.
+ */
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include "monstro-tcore.h"
+#include "monstro-tlogic.h"
+#include "monstro-tbatch.h"
+
+
+
+double now(void) {
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return t.tv_sec + t.tv_nsec * 1e-9;
+}
+
+
+
+uint32_t next_random(uint32_t *state) {
+    *state = *state * 1103515245 + 12345;
+    return *state >> 16;
+}
+
+
+
+/*
+ * Random inputs: mostly movement, with a rotation about once every 8 
+ * ticks and a hard drop about once every 64 ticks.
+ */
+int random_inputs(uint32_t *state) {
+    uint32_t r = next_random(state);
+    int inputs = r & (MONSTRO_TINPUT_DOWN | MONSTRO_TINPUT_LEFT | MONSTRO_TINPUT_RIGHT);
+    if (((r >> 4) & 7) == 0)
+        inputs |= (r & 0x80) ? MONSTRO_TINPUT_ROTATE_LEFT : MONSTRO_TINPUT_ROTATE_RIGHT;
+    if (((r >> 8) & 63) == 0)
+        inputs |= MONSTRO_TINPUT_UP;
+    return inputs;
+}
+
+
+
+/*
+ * Checks a game of the batch against the game played by mover_pieza(); 
+ * snap_index and drop_index are left out since mover_pieza() resets 
+ * them at every call.
+ */
+int compare_game(const MONSTRO_TBATCH *batch, int i, const MONSTRO_TGAME *game) {
+    MONSTRO_TGAME copy;
+    
+    get_game(batch, i, &copy);
+    return memcmp(copy.playfield, game->playfield, sizeof(game->playfield)) != 0 || 
+           copy.piece != game->piece || copy.rotation != game->rotation || 
+           copy.x != game->x || copy.y != game->y || copy.flags != game->flags || 
+           copy.snap_default != game->snap_default || copy.snap_count != game->snap_count || 
+           copy.drop_default != game->drop_default || copy.drop_count != game->drop_count || 
+           copy.move_default != game->move_default || copy.move_count != game->move_count || 
+           copy.move_index != game->move_index || copy.random_state != game->random_state;
+}
+
+
+
+int main(int argc, char **argv) {
+    long ticks = 2000;
+    int count = 4096;
+    uint64_t seed = 1;
+    uint32_t random = 1;
+    int check = false, option;
+    
+    while ((option = getopt(argc, argv, "cn:t:s:")) != -1)
+        switch (option) {
+            case 'c': check = true; break;
+            case 'n': count = atoi(optarg); break;
+            case 't': ticks = atol(optarg); break;
+            case 's': seed = strtoull(optarg, NULL, 10); break;
+            default:
+                fprintf(stderr, "usage: %s [-c] [-n games] [-t ticks] [-s seed]\n", argv[0]);
+                return 2;
+        }
+    
+    MONSTRO_TBATCH batch;
+    MONSTRO_TGAME *games = malloc(sizeof(MONSTRO_TGAME) * (count > 0 ? count : 1));
+    if (games == NULL || !init_batch(&batch, count)) {
+        fprintf(stderr, "%s: can't allocate %d games\n", argv[0], count);
+        free(games);
+        return 2;
+    }
+    uint64_t next_seed = seed;
+    for (int i = 0; i < count; i++) {
+        start_game(&games[i], next_seed++);
+        spawn_piece(&games[i]);
+        set_game(&batch, i, &games[i]);
+    }
+    
+    uint64_t lines = 0, restarts = 0, mismatches = 0, errors = 0;
+    double batch_busy = 0.0, game_busy = 0.0, start = now();
+    for (long t = 0; t < ticks; t++) {
+        for (int i = 0; i < count; i++)
+            games[i].inputs = batch.inputs[i] = random_inputs(&random);
+        
+        double s = now();
+        mover_piezas(&batch);
+        batch_busy += now() - s;
+        s = now();
+        for (int i = 0; i < count; i++)
+            mover_pieza(&games[i]);
+        game_busy += now() - s;
+        
+    // Spawn the next pieces, restarting the games that topped out; a 
+    // disagreement on the flags here would make the two sides diverge
+        for (int i = 0; i < count; i++) {
+            MONSTRO_TGAME *game = &games[i];
+            if (batch.flags[i] != game->flags) {
+                errors++;
+                set_game(&batch, i, game);
+            }
+            lines += __builtin_popcount(game->flags & MONSTRO_TACTION_CLEARED);
+            if (!(game->flags & MONSTRO_TACTION_SPAWN))
+                continue;
+            int spawned = spawn_piece(game);
+            if (spawn_piece_batch(&batch, i) != spawned)
+                errors++;
+            if (!spawned) {
+                start_game(game, next_seed++);
+                spawn_piece(game);
+                set_game(&batch, i, game);
+                restarts++;
+            }
+        }
+        
+        if (check)
+            for (int i = 0; i < count; i++)
+                if (compare_game(&batch, i, &games[i])) {
+                    mismatches++;
+                    set_game(&batch, i, &games[i]);
+                }
+    }
+    double seconds = now() - start;
+    
+    printf("games: count=%d ticks=%ld lines=%llu restarts=%llu\n", count, ticks, 
+           (unsigned long long)lines, (unsigned long long)restarts);
+    printf("batch: seconds=%.3f ticks_per_second=%.0f\n", batch_busy, count * ticks / batch_busy);
+    printf("single: seconds=%.3f ticks_per_second=%.0f\n", game_busy, count * ticks / game_busy);
+    if (check)
+        printf("check: mismatches=%llu\n", (unsigned long long)mismatches);
+    printf("total: seconds=%.3f speedup=%.2f errors=%llu\n", seconds, game_busy / batch_busy, 
+           (unsigned long long)errors);
+    
+    free_batch(&batch);
+    free(games);
+    
+    return errors != 0 || mismatches != 0;
+}
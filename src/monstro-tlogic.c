@@ -58,11 +58,18 @@
  * 
  *      // Declare a MONSTRO_TGAME variable representing an independent game
  *      MONSTRO_TGAME game;
+ *      init_playfield(&game);
+ * 
+ *      // Seed the game's own random number generator before spawning 
+ *      // the first piece; the same seed always produces the same pieces
+ *      seed_game(&game, seed);
+ *      spawn_piece(&game);
  * 
  *      ...
  *      // Within the game loop, update user inputs and call the main 
  *      // logic function mover_pieza() at a rate of ~30 times per second
  *      game.inputs = 0;
+ *      if (user_input_hard_drop) game.inputs |= MONSTRO_TINPUT_UP;
  *      if (user_input_down) game.inputs |= MONSTRO_TINPUT_DOWN;
  *      if (user_input_left) game.inputs |= MONSTRO_TINPUT_LEFT;
  *      if (user_input_right) game.inputs |= MONSTRO_TINPUT_RIGHT;
@@ -97,35 +104,43 @@
  * time the player advances to a new level, increasing de default speed. So, 
  * changes to movement speed based on player input should be handled by 
  * modifying the <em>*_index</em> values instead.
+ * 
+ * When \c drop_default reaches \c 0 the piece no longer falls one block 
+ * at a time; instead, it falls all the way to its landing row at every 
+ * call (what is usually known as 20G gravity) and only the \c snap 
+ * counter delays the lock. Similarly, \c MONSTRO_TINPUT_UP performs a 
+ * hard drop: the piece falls to its landing row and locks in the same 
+ * call to mover_pieza().
  */
 
-#include <stdlib.h>                 // rand()
 #include <stdint.h>
 #include <stdbool.h>
+#include <string.h>
 #include <monstro-tlogic.h>
+#include <monstro-tpieces.h>
 
 
 
-// Piezas:
-static enum {_I_, _O_, _T_, _J_, _L_, _S_, _Z_};   // Named values for the pieces' index
-// I,    O,      T,      J,    L,      S,    Z
-// cyan, yellow, purple, blue, orange, lime, red
-static const uint64_t I[] = {0xF00000000, 0x2000200020002, 0xF0000, 0x4000400040004};
-static const uint64_t O[] = {0x600060000, 0x600060000, 0x600060000, 0x600060000};
-static const uint64_t T[] = {0x200070000, 0x200030002, 0x70002, 0x200060002};
-static const uint64_t J[] = {0x400070000, 0x300020002, 0x70001, 0x200020006};
-static const uint64_t L[] = {0x100070000, 0x200020003, 0x70004, 0x600020002};
-static const uint64_t S[] = {0x300060000, 0x200030001, 0x30006, 0x400060002};
-static const uint64_t Z[] = {0x600030000, 0x100030002, 0x60003, 0x200060004};
-// Use 0xF000700030001 to see the way the board maps to an uint64_t
-static const uint64_t *piezas[] = {I, O, T, J, L, S, Z};
+/**
+ * Returns a pseudo random value in the range [0, n) from the game's 
+ * generator, see pcg32_next().
+ * 
+ * Uses a multiply and shift instead of a modulo, which is both faster 
+ * and free of the modulo bias for small values of \c n.
+ * 
+ * @param game  A \c MONSTRO_TGAME struct representing the current game.
+ * @param n     The upper bound (exclusive) of the returned value.
+ */
+static int random_range(MONSTRO_TGAME *game, int n) {
+    return (int)(((uint64_t)pcg32_next(&game->random_state) * n) >> 32);
+}
 
 
 
 /**
  * Verifica si una pieza puede hacer <em>wall kick</em>.
  * 
- * @param area_de_juego Un apuntador a un arreglo de \c uint16_t 
+ * @param area_de_juego Un apuntador a un arreglo de \c MONSTRO_TROW 
  *                      representando el tablero del juego.
  * @param pieza         La pieza a colocar, representada como un entero 
  *                      de 64 bits \c uint64_t.
@@ -138,7 +153,7 @@ static const uint64_t *piezas[] = {I, O, T, J, L, S, Z};
  *                      en el eje \c X; finalmente, regresa \c 0 si la pieza
  *                      no puede hacer <em>wall kick</em>
  */
-static int puede_wallkick(uint16_t *area_de_juego, uint64_t pieza, int x, int y) {
+static int puede_wallkick(MONSTRO_TROW *area_de_juego, uint64_t pieza, int x, int y) {
     if (puede_mover(area_de_juego, pieza, x - 1, y))
         return -1;
     else if (puede_mover(area_de_juego, pieza, x + 1, y))
@@ -151,7 +166,7 @@ static int puede_wallkick(uint16_t *area_de_juego, uint64_t pieza, int x, int y)
 /**
  * Verifica si una pieza puede hacer <em>floor kick</em>.
  * 
- * @param area_de_juego Un apuntador a un arreglo de \c uint16_t 
+ * @param area_de_juego Un apuntador a un arreglo de \c MONSTRO_TROW 
  *                      representando el tablero del juego.
  * @param pieza         La pieza a colocar, representada como un entero 
  *                      de 64 bits \c uint64_t.
@@ -160,7 +175,7 @@ static int puede_wallkick(uint16_t *area_de_juego, uint64_t pieza, int x, int y)
  * @return              \c true si la pieza puede hacer <em>floor kick</em>; 
  *                      de lo contrario, \c false.
  */
-static int puede_floorkick(uint16_t *area_de_juego, uint64_t pieza, int x, int y) {
+static int puede_floorkick(MONSTRO_TROW *area_de_juego, uint64_t pieza, int x, int y) {
     if (puede_mover(area_de_juego, pieza, x, y + 1))
         return true;
     return false;
@@ -171,7 +186,7 @@ static int puede_floorkick(uint16_t *area_de_juego, uint64_t pieza, int x, int y
 /**
  * Verifica si una pieza puede hacer un \c spin.
  * 
- * @param area_de_juego Un apuntador a un arreglo de \c uint16_t 
+ * @param area_de_juego Un apuntador a un arreglo de \c MONSTRO_TROW 
  *                      representando el tablero del juego.
  * @param pieza         La pieza a colocar, representada como un entero 
  *                      de 64 bits \c uint64_t.
@@ -180,7 +195,7 @@ static int puede_floorkick(uint16_t *area_de_juego, uint64_t pieza, int x, int y
  * @return              \c true si la pieza puede hacer un \c spin; de 
  *                      lo contrario, \c false.
  */
-static int puede_spin(uint16_t *area_de_juego, uint64_t pieza, int x, int y) {
+static int puede_spin(MONSTRO_TROW *area_de_juego, uint64_t pieza, int x, int y) {
     if (puede_mover(area_de_juego, pieza, x, y - 1))
         return true;
     return false;
@@ -188,6 +203,31 @@ static int puede_spin(uint16_t *area_de_juego, uint64_t pieza, int x, int y) {
 
 
 
+/**
+ * Finds the row where a piece would land if it fell straight down from 
+ * its current position.
+ * 
+ * The current piece must not be on the playfield when this function is 
+ * called. When \c MONSTRO_TWANT_COLUMNS is defined the column index is 
+ * used and the cost doesn't depend on the distance to the landing row.
+ * 
+ * @param game  A \c MONSTRO_TGAME struct representing the current game.
+ * @param piece The \c uint64_t representation of the piece.
+ * @return      The landing row for the piece at the current \c x.
+ */
+static int landing_row(MONSTRO_TGAME *game, uint64_t piece) {
+#ifdef MONSTRO_TWANT_COLUMNS
+    return caida_pieza(game->columns, piece, game->x, game->y);
+#else
+    int y = game->y;
+    while (puede_mover(game->playfield, piece, game->x, y - 1))
+        y--;
+    return y;
+#endif
+}
+
+
+
 /**
  * Sets the piece movement variables to the right values based on user input.
  * 
@@ -252,7 +292,12 @@ static void horizontal_movement(MONSTRO_TGAME *game) {
  */
 static void vertical_movement(MONSTRO_TGAME *game) {
     game->drop_count += game->drop_index;
-    if (game->drop_count > game->drop_default) game->y--;
+    if (game->drop_count > game->drop_default) {
+    // With 20G gravity the piece falls to its landing row; once it's there, 
+    // moving it one more row down makes it start to snap, as usual
+        int y = (game->drop_default == 0) ? landing_row(game, piezas[game->piece][game->rotation]) : game->y;
+        game->y = (y < game->y) ? y : game->y - 1;
+    }
 }
 
 
@@ -309,7 +354,9 @@ static void rotation_movement(MONSTRO_TGAME *game) {
 // La pieza no pudo rotar normalmente ni con 'wall kick', una última opción es intentar un 'floor kick'
 
 // La pieza I requiere verificar una condición especial cuando está en Y = -1 antes de intentar hacer un 'floor kick'
-    if (game->piece == _I_ && game->snap_count > 0 && game->rotation == 0) {
+// Ningún 'floor kick' puede subir la pieza por encima de la última fila del tablero
+    int y_maxima = MONSTRO_TFIELD_SIZE - 4;
+    if (game->piece == _I_ && game->snap_count > 0 && game->rotation == 0 && game->y + 3 <= y_maxima) {
         rotation_candidate = (rotation_candidate + 2) % 4;
         game->rotation = 2;
         game->y += 2;
@@ -318,7 +365,7 @@ static void rotation_movement(MONSTRO_TGAME *game) {
     }
     
     int i = (game->snap_count > 0) ? 1 : 0;
-    if (puede_floorkick(game->playfield, piece_candidate, game->x, game->y + i)) {
+    if (game->y + i + 1 <= y_maxima && puede_floorkick(game->playfield, piece_candidate, game->x, game->y + i)) {
         game->flags = MONSTRO_TACTION_FLOOR_KICK;
         game->rotation = rotation_candidate;
         game->y += (game->snap_count > 0) ? 2 : 1;
@@ -329,6 +376,25 @@ static void rotation_movement(MONSTRO_TGAME *game) {
 
 
 
+/**
+ * Initializes the playfield with its floor and walls.
+ * 
+ * The floor is the bottom row and the walls are every column outside 
+ * of the \c MONSTRO_TWELL_WIDTH columns of the well, with the well 
+ * starting \c MONSTRO_TWALL_SIZE columns from the right. The guard 
+ * rows below the floor are cleared as well; see \c MONSTRO_TGUARD_ROWS.
+ * 
+ * @param game  A \c MONSTRO_TGAME struct representing the current game.
+ */
+void init_playfield(MONSTRO_TGAME *game) {
+    memset(game->guard, 0, sizeof(game->guard));
+    game->playfield[0] = MONSTRO_TFULL_ROW;
+    for (int y = 1; y < MONSTRO_TFIELD_SIZE; y++)
+        game->playfield[y] = MONSTRO_TWALLS;
+}
+
+
+
 /**
  * Performs the game logic.
  * 
@@ -342,6 +408,7 @@ static void rotation_movement(MONSTRO_TGAME *game) {
 void mover_pieza(MONSTRO_TGAME *game) {
     uint64_t piece = piezas[game->piece][game->rotation];
     int ox = game->x, oy = game->y;                     // Almacena la posición actual de la pieza
+    int hard_drop = game->inputs & MONSTRO_TINPUT_UP;
     
     game->flags = 0;
     borrar_pieza(game->playfield, piece, game->x, game->y);
@@ -351,7 +418,7 @@ void mover_pieza(MONSTRO_TGAME *game) {
     vertical_movement(game);
     if (game->inputs & (MONSTRO_TINPUT_ROTATE_LEFT | MONSTRO_TINPUT_ROTATE_RIGHT))
         rotation_movement(game);
-    game->inputs &= ~(MONSTRO_TINPUT_ROTATE_LEFT | MONSTRO_TINPUT_ROTATE_RIGHT);    // Reset inputs
+    game->inputs &= ~(MONSTRO_TINPUT_UP | MONSTRO_TINPUT_ROTATE_LEFT | MONSTRO_TINPUT_ROTATE_RIGHT);    // Reset inputs
     
 // After all the logic is handled, all left is to verify the piece can be placed on 
 // the playfield and then proceed to actually place it in its new position
@@ -363,6 +430,10 @@ void mover_pieza(MONSTRO_TGAME *game) {
         game->y = oy; 
         game->snap_count += game->snap_index;
     }
+    if (hard_drop) {
+        game->y = landing_row(game, piece);
+        game->flags |= MONSTRO_TACTION_HARD_DROP;
+    }
     poner_pieza(game->playfield, piece, game->x, game->y);
     
 // If the piece moved vertically, snap and drop counters are reset
@@ -376,24 +447,27 @@ void mover_pieza(MONSTRO_TGAME *game) {
         game->move_count = 0;
         game->flags |= MONSTRO_TACTION_MOVE;
     }
+// A hard dropped piece locks right away
+    if (hard_drop)
+        game->snap_count = game->snap_default + 1;
 // If snap counter reached its limit, the piece effectively has locked, 
 // so proceed to clear completed lines and spawn a new piece
     if (game->snap_count > game->snap_default) {
         game->flags |= MONSTRO_TACTION_SNAP;
         game->flags |= MONSTRO_TACTION_SPAWN;
-    // Flag completed lines
-        int completed = 0;
-        game->playfield[0] = 0x7FFF;      // safeguard
-        completed |=     (game->playfield[game->y] == 0xFFFF) ? MONSTRO_TACTION_CLEARED0 : 0;
-        completed |= (game->playfield[game->y + 1] == 0xFFFF) ? MONSTRO_TACTION_CLEARED1 : 0;
-        completed |= (game->playfield[game->y + 2] == 0xFFFF) ? MONSTRO_TACTION_CLEARED2 : 0;
-        completed |= (game->playfield[game->y + 3] == 0xFFFF) ? MONSTRO_TACTION_CLEARED3 : 0;
-        game->playfield[0] = 0xFFFF;      // safeguard
-        game->flags |= completed;
-    // Clear completed lines from the playfield
+    // Clear completed lines from the playfield and flag them
     // TODO: Maybe borrar_completas() can be called from the main game loop in
     //       response to the flags, just like spawn_piece() in recent versions ???
-        borrar_completas(game->playfield, game->y);
+        int completed = borrar_completas(game->playfield, game->y);
+        game->flags |= completed << 8;
+#ifdef MONSTRO_TWANT_COLUMNS
+        poner_columnas(game->columns, piece, game->x, game->y);
+        borrar_completas_columnas(game->columns, game->y, completed);
+#endif
+#ifdef MONSTRO_TWANT_HASH
+        poner_hash(&game->hash, piece, game->x, game->y);
+        borrar_completas_hash(&game->hash, game->playfield, game->y, completed);
+#endif
     }
 }
 
@@ -405,10 +479,10 @@ void mover_pieza(MONSTRO_TGAME *game) {
  * @param game  A \c MONSTRO_TGAME struct representing the current game.
  */
 int spawn_piece(MONSTRO_TGAME *game) {
-    game->piece = rand() % 7;
-    game->rotation = rand() % 4;
-    game->x = 6;
-    game->y = 20;
+    game->piece = random_range(game, 7);
+    game->rotation = random_range(game, 4);
+    game->x = MONSTRO_TWALL_SIZE + (MONSTRO_TWELL_WIDTH - 4) / 2;
+    game->y = MONSTRO_TFIELD_SIZE - 4;
     game->drop_count = 0;
     game->snap_count = 0;
     uint64_t piece = piezas[game->piece][game->rotation];
@@ -422,3 +496,240 @@ int spawn_piece(MONSTRO_TGAME *game) {
     
     return false;
 }
+
+
+
+/**
+ * Pushes garbage rows into the game from the bottom of the playfield, 
+ * as sent by the opponents in a multiplayer game.
+ * 
+ * Every row is full except for its hole and all of them are inserted 
+ * with a single call to subir_basura(), so the garbage received from 
+ * several attacks in the same tick should be added with a single call. 
+ * The color playfield, the column index and the hash are updated along 
+ * with the playfield. If the current piece overlaps the garbage, it's 
+ * pushed up until it fits.
+ * 
+ * This function must be called between calls to mover_pieza(), while 
+ * there's a piece in play, for example right after spawn_piece().
+ * 
+ * @param game  A \c MONSTRO_TGAME struct representing the current game.
+ * @param holes An array of \c count hole positions, from \c 0 to 
+ *              <tt>MONSTRO_TWELL_WIDTH - 1</tt> counted from the right 
+ *              wall, one for each row; the first one is the bottom row.
+ * @param count The number of rows to insert, up to 
+ *              <tt>MONSTRO_TFIELD_SIZE - 1</tt>.
+ * @return      \c true if the game goes on or \c false if blocks were 
+ *              pushed out of the playfield or the current piece 
+ *              doesn't fit anymore, meaning the game is over.
+ */
+int add_garbage(MONSTRO_TGAME *game, const int *holes, int count) {
+    MONSTRO_TROW rows[MONSTRO_TFIELD_SIZE];
+    uint64_t piece = piezas[game->piece][game->rotation];
+    
+    if (count > MONSTRO_TFIELD_SIZE - 1)
+        count = MONSTRO_TFIELD_SIZE - 1;
+    for (int i = 0; i < count; i++)
+        rows[i] = MONSTRO_TGARBAGE_ROW(holes[i]);
+    borrar_pieza(game->playfield, piece, game->x, game->y);
+    MONSTRO_TROW lost = subir_basura(game->playfield, rows, count);
+#ifdef MONSTRO_TWANT_COLORS
+    add_color_garbage(game, rows, count);
+#endif
+#ifdef MONSTRO_TWANT_COLUMNS
+    iniciar_columnas(game->columns, game->playfield);
+#endif
+#ifdef MONSTRO_TWANT_HASH
+    game->hash = calcular_hash(game->playfield);
+#endif
+    while (!puede_mover(game->playfield, piece, game->x, game->y))
+        if (++game->y > MONSTRO_TFIELD_SIZE - 4)
+            return false;
+    poner_pieza(game->playfield, piece, game->x, game->y);
+    
+    return !(lost & ~MONSTRO_TWALLS);
+}
+
+
+
+/**
+ * Seeds the game's pseudo random number generator.
+ * 
+ * Games seeded with the same value will get the same sequence of pieces 
+ * from spawn_piece(). A game that is never seeded still works, it just 
+ * always gets the sequence corresponding to a zeroed state.
+ * 
+ * @param game  A \c MONSTRO_TGAME struct representing the current game.
+ * @param seed  The seed value.
+ */
+void seed_game(MONSTRO_TGAME *game, uint64_t seed) {
+    game->random_state = 0;
+    pcg32_next(&game->random_state);
+    game->random_state += seed;
+    pcg32_next(&game->random_state);
+}
+
+
+
+/**
+ * Returns the next value from a pseudo random number generator.
+ * 
+ * This is a PCG32 (XSH RR) generator whose whole state is a single 
+ * \c uint64_t, such as \c random_state in \c MONSTRO_TGAME, so 
+ * independent games can run on different threads without locking and 
+ * the sequence of pieces is the same on every platform for a given 
+ * seed, unlike rand(). Anything else that must be just as reproducible, 
+ * such as the garbage holes of a room, can keep its own state and 
+ * step it with this function.
+ * 
+ * @param state The state of the generator, updated here.
+ * @return      A uniformly distributed 32 bit value.
+ */
+uint32_t pcg32_next(uint64_t *state) {
+    uint64_t old = *state;
+    *state = old * 6364136223846793005ULL + 1442695040888963407ULL;
+    uint32_t xorshifted = ((old >> 18) ^ old) >> 27;
+    uint32_t rot = old >> 59;
+    return (xorshifted >> rot) | (xorshifted << (-rot & 31));
+}
+
+
+
+#ifdef MONSTRO_TWANT_COLUMNS
+/**
+ * Initializes the column index from the playfield.
+ * 
+ * This function must be called *only if* \c MONSTRO_TWANT_COLUMNS is 
+ * defined, once the playfield walls are set and before the first call 
+ * to spawn_piece(). After that, mover_pieza() keeps the index up to date.
+ * 
+ * @param game  A \c MONSTRO_TGAME struct representing the current game.
+ */
+void init_columns(MONSTRO_TGAME *game) {
+    iniciar_columnas(game->columns, game->playfield);
+}
+#endif
+
+
+
+#ifdef MONSTRO_TWANT_HASH
+/**
+ * Initializes the playfield hash.
+ * 
+ * This function must be called *only if* \c MONSTRO_TWANT_HASH is 
+ * defined, once the playfield walls are set and before the first call 
+ * to spawn_piece(). After that, mover_pieza() keeps the hash up to date.
+ * 
+ * @param game  A \c MONSTRO_TGAME struct representing the current game.
+ */
+void init_hash(MONSTRO_TGAME *game) {
+    iniciar_claves();
+    game->hash = calcular_hash(game->playfield);
+}
+
+
+
+/**
+ * Returns the hash of the game state: the locked blocks on the 
+ * playfield plus the current piece, its rotation and its position.
+ * 
+ * Two games with the same hash are, with overwhelming probability, in 
+ * the same state as far as the playfield and the current piece are 
+ * concerned; counters and the random state are not part of the hash.
+ * 
+ * @param game  A \c MONSTRO_TGAME struct representing the current game.
+ * @return      The hash of the game state.
+ */
+uint64_t game_hash(MONSTRO_TGAME *game) {
+    return game->hash ^ hash_estado(game->piece, game->rotation, game->x, game->y);
+}
+#endif
+
+
+
+/**
+ * Starts a new game: sets the default speed, sets the playfield walls, 
+ * seeds the game and initializes the color playfield, the column index 
+ * and the hash when they are enabled. Every field not mentioned above 
+ * is zeroed; the first piece still has to be spawned with spawn_piece().
+ * 
+ * @param game  A \c MONSTRO_TGAME struct representing the game to start.
+ * @param seed  The seed value, see seed_game().
+ */
+void start_game(MONSTRO_TGAME *game, uint64_t seed) {
+    *game = (MONSTRO_TGAME){ .snap_default = MONSTRO_TSNAP_LIMIT, .snap_index = 1, 
+                             .drop_default = MONSTRO_TDROP_LIMIT, .drop_index = 1, 
+                             .move_default = MONSTRO_TMOVE_LIMIT, .move_index = 1};
+    init_playfield(game);
+    seed_game(game, seed);
+#ifdef MONSTRO_TWANT_COLORS
+    init_color_playfield(game);
+#endif
+#ifdef MONSTRO_TWANT_COLUMNS
+    init_columns(game);
+#endif
+#ifdef MONSTRO_TWANT_HASH
+    init_hash(game);
+#endif
+}
+
+
+
+/**
+ * Counts cleared lines towards the next speed increase and, once more 
+ * than \c MONSTRO_TLEVEL_LINES lines are cleared, speeds the game up: 
+ * pieces fall twice as fast and lock a little sooner.
+ * 
+ * @param game          A \c MONSTRO_TGAME struct representing the current game.
+ * @param level_lines   The lines cleared since the last speed increase, 
+ *                      kept by the caller and updated here.
+ * @param lines         The lines that were just cleared.
+ */
+void level_up(MONSTRO_TGAME *game, int *level_lines, int lines) {
+    *level_lines += lines;
+    if (*level_lines > MONSTRO_TLEVEL_LINES) {
+        *level_lines -= MONSTRO_TLEVEL_LINES;
+        game->drop_default /= 2;
+        game->snap_default -= game->snap_default / 8;
+    }
+}
+
+
+
+#ifdef MONSTRO_TWANT_MOVES
+/**
+ * Rotates the current piece the same way mover_pieza() does, wall 
+ * kicks and floor kicks included, without moving it otherwise.
+ * 
+ * This lets code that searches over piece positions, like the move 
+ * generator in monstro-tmoves.c, follow the very same rotation rules 
+ * as the game. The current piece must not be on the playfield and 
+ * \c snap_count tells whether the piece has started to snap, since 
+ * kicks depend on it. Just like in mover_pieza(), a kick that leaves 
+ * the piece where it can't be placed keeps its original row.
+ * 
+ * @param game      A \c MONSTRO_TGAME struct representing the current game.
+ * @param inputs    Either \c MONSTRO_TINPUT_ROTATE_LEFT or 
+ *                  \c MONSTRO_TINPUT_ROTATE_RIGHT.
+ * @return          \c true if the piece rotated, with the kick in 
+ *                  \c flags; otherwise, \c false and the piece is 
+ *                  left where it was.
+ */
+int rotate_piece(MONSTRO_TGAME *game, int inputs) {
+    int rotation = game->rotation, x = game->x, y = game->y;
+    
+    game->flags = 0;
+    game->inputs = inputs;
+    rotation_movement(game);
+    if (game->rotation == rotation && game->x == x && game->y == y)
+        return false;
+    if (!puede_mover(game->playfield, piezas[game->piece][game->rotation], game->x, game->y))
+        game->y = y;
+    if (!puede_mover(game->playfield, piezas[game->piece][game->rotation], game->x, game->y)) {
+        game->rotation = rotation;
+        game->x = x;
+        return false;
+    }
+    return true;
+}
+#endif
@@ -0,0 +1,385 @@
+/**
+ * @file monstro-tmovegen.c
+ * 
+ * @section LICENSE License
+ * 
+ * This is free and unencumbered software released into the public domain.
+ *
+ * Anyone is free to copy, modify, publish, use, compile, sell, or
+ * distribute this software, either in source code form or as a compiled
+ * binary, for any purpose, commercial or non-commercial, and by any
+ * means.
+ * 
+ * In jurisdictions that recognize copyright laws, the author or authors
+ * of this software dedicate any and all copyright interest in the
+ * software to the public domain. We make this dedication for the benefit
+ * of the public at large and to the detriment of our heirs and
+ * successors. We intend this dedication to be an overt act of
+ * relinquishment in perpetuity of all present and future rights to this
+ * software under copyright law.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+ * OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ * 
+ * For more information, please refer to <https://unlicense.org>
+ * 
+ * @section DESCRIPTION Description
+ * 
+ * Test bench for the move generator in monstro-tmoves.c. It plays games 
+ * with a bot that locks every piece at the best of the placements from 
+ * generate_placements() and reports how long the generator and the 
+ * flood fill in flood_placements() take, along with the number of tucks 
+ * and kicks the flood fill finds. Usage:
+ * 
+ *      movegen-main [-c] [-r] [-n games] [-p pieces] [-s seed]
+ * 
+ * \c -r makes the bot pick a random placement instead of the best one, 
+ * which leaves a messier stack, with more tucks and kicks. 
+ * Each placement is locked through mover_pieza() with a hard drop, 
+ * which must leave the piece right where the placement says. \c -c 
+ * also checks every call against a plain breadth first search that 
+ * uses only puede_mover() and rotate_piece(), placements and number of 
+ * inputs alike, and the placements of the flood fill and their flags 
+ * against the same search, run with and without kicks, and, since the 
+ * bot hardly ever leaves a stack that needs them, the placements of an 
+ * L piece on a playfield where one of them needs a floor kick. The exit 
+ * status is \c 1 if any placement didn't match.
+ */
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include "monstro-tcore.h"
+#include "monstro-tlogic.h"
+#include "monstro-tpieces.h"
+#include "monstro-tmoves.h"
+
+// Blocks covered by a placement, to compare placements from different rotations
+typedef struct {
+    int y;
+    MONSTRO_TROW rows[4];
+} BLOCKS;
+
+MONSTRO_TGAME board, scratch;
+MONSTRO_TPLACEMENT placements[MONSTRO_TMOVES_MAX], flooded[MONSTRO_TMOVES_MAX];
+uint8_t seen[4][MONSTRO_TMOVES_ROWS][MONSTRO_TMOVES_COLUMNS];
+
+
+
+double now(void) {
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return t.tv_sec + t.tv_nsec * 1e-9;
+}
+
+
+
+uint32_t next_random(uint32_t *state) {
+    *state = *state * 1103515245 + 12345;
+    return *state >> 16;
+}
+
+
+
+/*
+ * Scores the playfield after placing a piece: cleared lines are good, 
+ * holes and height are bad.
+ */
+int score_playfield(const MONSTRO_TROW *playfield) {
+    MONSTRO_TROW cover = 0;
+    int lines = 0, holes = 0, height = 0;
+    
+    for (int y = MONSTRO_TFIELD_SIZE - 1; y > 0; y--) {
+        MONSTRO_TROW row = playfield[y];
+        if (row == MONSTRO_TFULL_ROW) {
+            lines++;
+            continue;
+        }
+        if (row != MONSTRO_TWALLS && height == 0)
+            height = y;
+        holes += __builtin_popcountll((MONSTRO_TROW)(cover & ~row));
+        cover |= row & ~MONSTRO_TWALLS;
+    }
+    return lines * 6 - holes * 8 - height * 2;
+}
+
+
+
+BLOCKS placement_blocks(int piece, int rotation, int x, int y) {
+    uint64_t p = piezas[piece][rotation];
+    int skip = __builtin_ctzll(p) / 16;
+    BLOCKS blocks = {y + skip, {0}};
+    
+    for (int i = skip; i < 4; i++)
+        blocks.rows[i - skip] = (MONSTRO_TROW)((p >> (i * 16)) & 0xFFFF) << x;
+    return blocks;
+}
+
+
+
+/*
+ * The same search as generate_placements(), the plain way: a queue of 
+ * states checked one by one with puede_mover() and rotate_piece(). 
+ * Only the rotations that set one of the given action flags are 
+ * followed; a failed floor kick of the I piece sets none.
+ */
+int reference_placements(const MONSTRO_TGAME *game, BLOCKS *found, int *inputs, int kicks) {
+    static int queue[MONSTRO_TMOVES_MAX][4];
+    MONSTRO_TGAME *g = &scratch;
+    int tail = 0, count = 0;
+    
+    memset(seen, 0, sizeof(seen));
+    memcpy(g->playfield, game->playfield, sizeof(game->playfield));
+    borrar_pieza(g->playfield, piezas[game->piece][game->rotation], game->x, game->y);
+    g->piece = game->piece;
+    
+#define VISIT(r, x, y, n) if (!seen[r][(y) - MONSTRO_TMOVES_MIN_Y][x]) { \
+                              seen[r][(y) - MONSTRO_TMOVES_MIN_Y][x] = 1; \
+                              queue[tail][0] = r; queue[tail][1] = x; queue[tail][2] = y; queue[tail][3] = n; tail++; }
+    VISIT(game->rotation, game->x, game->y, 0);
+    for (int head = 0; head < tail; head++) {
+        int r = queue[head][0], x = queue[head][1], y = queue[head][2], n = queue[head][3] + 1;
+        uint64_t piece = piezas[g->piece][r];
+        int resting = y == MONSTRO_TMOVES_MIN_Y || !puede_mover(g->playfield, piece, x, y - 1);
+        
+        if (resting) {
+            BLOCKS blocks = placement_blocks(g->piece, r, x, y);
+            int i = 0;
+            while (i < count && memcmp(&found[i], &blocks, sizeof(blocks)) != 0)
+                i++;
+            if (i == count) {
+                inputs[count] = n - 1;
+                found[count++] = blocks;
+            }
+        }
+        else
+            VISIT(r, x, y - 1, n);
+        if (x + 1 < MONSTRO_TMOVES_COLUMNS && puede_mover(g->playfield, piece, x + 1, y))
+            VISIT(r, x + 1, y, n);
+        if (x > 0 && puede_mover(g->playfield, piece, x - 1, y))
+            VISIT(r, x - 1, y, n);
+        for (int i = 0; i < 2; i++) {
+            g->rotation = r;
+            g->x = x;
+            g->y = y;
+            g->snap_count = resting;
+            if (rotate_piece(g, i ? MONSTRO_TINPUT_ROTATE_RIGHT : MONSTRO_TINPUT_ROTATE_LEFT) && g->x < MONSTRO_TMOVES_COLUMNS && 
+                ((g->flags & kicks) || (g->flags == 0 && (kicks & MONSTRO_TACTION_FLOOR_KICK))))
+                VISIT(g->rotation, g->x, g->y, n);
+        }
+    }
+#undef VISIT
+    
+    return count;
+}
+
+
+
+int find_blocks(const BLOCKS *found, int count, BLOCKS blocks) {
+    int i = 0;
+    while (i < count && memcmp(&found[i], &blocks, sizeof(blocks)) != 0)
+        i++;
+    return i;
+}
+
+
+
+/*
+ * Compares the placements of the current piece with the ones from the 
+ * reference search and the flood fill with the same search, with and 
+ * without kicks; returns the number of differences.
+ */
+int check_placements(const MONSTRO_TGAME *game, int count, int flood_count) {
+    static BLOCKS found[MONSTRO_TMOVES_MAX], unkicked[MONSTRO_TMOVES_MAX], wall_kicked[MONSTRO_TMOVES_MAX];
+    static BLOCKS dropped[MONSTRO_TMOVES_MAX];
+    static int inputs[MONSTRO_TMOVES_MAX], ignored[MONSTRO_TMOVES_MAX];
+    const int rotations = MONSTRO_TACTION_ROTATE_LEFT | MONSTRO_TACTION_ROTATE_RIGHT;
+    int expected = reference_placements(game, found, inputs, rotations | MONSTRO_TACTION_WALL_KICK | MONSTRO_TACTION_FLOOR_KICK);
+    int errors = abs(expected - count) + abs(expected - flood_count);
+    
+    for (int i = 0; i < count; i++) {
+        const MONSTRO_TPLACEMENT *p = &placements[i];
+        int j = find_blocks(found, expected, placement_blocks(game->piece, p->rotation, p->x, p->y));
+        if (j == expected || inputs[j] != p->inputs)
+            errors++;
+    }
+    
+// Straight drops from the row of the piece, with wall kicks only
+    int unkicked_count = reference_placements(game, unkicked, ignored, rotations);
+    int wall_kicked_count = reference_placements(game, wall_kicked, ignored, rotations | MONSTRO_TACTION_WALL_KICK);
+    int dropped_count = 0;
+    for (int r = 0; r < 4; r++)
+        for (int x = 0; x < MONSTRO_TMOVES_COLUMNS; x++) {
+            int y = game->y;
+            if (!seen[r][y - MONSTRO_TMOVES_MIN_Y][x])
+                continue;
+            while (y > MONSTRO_TMOVES_MIN_Y && puede_mover(scratch.playfield, piezas[game->piece][r], x, y - 1))
+                y--;
+            dropped[dropped_count++] = placement_blocks(game->piece, r, x, y);
+        }
+    
+    for (int i = 0; i < flood_count; i++) {
+        const MONSTRO_TPLACEMENT *p = &flooded[i];
+        BLOCKS blocks = placement_blocks(game->piece, p->rotation, p->x, p->y);
+        int flags = 0;
+        if (find_blocks(dropped, dropped_count, blocks) == dropped_count)
+            flags |= MONSTRO_TMOVES_TUCK;
+        if (find_blocks(unkicked, unkicked_count, blocks) == unkicked_count)
+            flags |= (find_blocks(wall_kicked, wall_kicked_count, blocks) < wall_kicked_count) ? 
+                     MONSTRO_TACTION_WALL_KICK : MONSTRO_TACTION_FLOOR_KICK;
+        if (find_blocks(found, expected, blocks) == expected || flags != p->flags)
+            errors++;
+    }
+    return errors;
+}
+
+
+
+/*
+ * A playfield, from the floor up and from the left wall, where the 
+ * only way for an L piece to lock at the cells marked with L is a 
+ * floor kick, since the overhang right above them keeps it from 
+ * dropping or sliding in there.
+ */
+const char *floor_kick_rows[] = {
+    "..........",
+    ".#........",
+    ".LLL..#...",
+    "..#L##....",
+};
+
+
+
+/*
+ * Checks the placements of an L piece spawned over floor_kick_rows, 
+ * which must include the one at the cells marked with L, flagged as 
+ * needing a floor kick; returns the number of differences.
+ */
+int check_floor_kick(void) {
+    MONSTRO_TGAME *game = &board;
+    int rows = sizeof(floor_kick_rows) / sizeof(floor_kick_rows[0]), found = false;
+    
+    start_game(game, 1);
+    for (int y = 0; y < rows; y++)
+        for (int x = 0; floor_kick_rows[y][x]; x++)
+            if (floor_kick_rows[y][x] == '#')
+                game->playfield[y + 1] |= (MONSTRO_TROW)1 << (MONSTRO_TWALL_SIZE + MONSTRO_TWELL_WIDTH - 1 - x);
+    game->piece = _L_;
+    game->rotation = 0;
+    game->x = MONSTRO_TWALL_SIZE + (MONSTRO_TWELL_WIDTH - 4) / 2;
+    game->y = MONSTRO_TFIELD_SIZE - 4;
+    poner_pieza(game->playfield, piezas[_L_][0], game->x, game->y);
+    
+    int count = generate_placements(game, placements);
+    int flood_count = flood_placements(game, flooded);
+    for (int i = 0; i < flood_count; i++) {
+        const MONSTRO_TPLACEMENT *p = &flooded[i];
+        found |= p->rotation == 0 && p->x == MONSTRO_TWALL_SIZE + MONSTRO_TWELL_WIDTH - 4 && p->y == 2 && 
+                 (p->flags & MONSTRO_TACTION_FLOOR_KICK);
+    }
+    return check_placements(game, count, flood_count) + !found;
+}
+
+
+
+int main(int argc, char **argv) {
+    long games = 100, pieces = 1000;
+    uint64_t seed = 1;
+    uint32_t random = 1;
+    int check = false, randomly = false, option;
+    
+    while ((option = getopt(argc, argv, "crn:p:s:")) != -1)
+        switch (option) {
+            case 'c': check = true; break;
+            case 'r': randomly = true; break;
+            case 'n': games = atol(optarg); break;
+            case 'p': pieces = atol(optarg); break;
+            case 's': seed = strtoull(optarg, NULL, 10); break;
+            default:
+                fprintf(stderr, "usage: %s [-c] [-r] [-n games] [-p pieces] [-s seed]\n", argv[0]);
+                return 2;
+        }
+    
+    uint64_t calls = 0, total = 0, lines = 0, mismatches = 0, errors = 0;
+    uint64_t tucks = 0, wall_kicks = 0, floor_kicks = 0;
+    int most = 0;
+    double busy = 0.0, flood_busy = 0.0, start = now();
+    MONSTRO_TGAME *game = &board;
+    for (long n = 0; n < games; n++) {
+        start_game(game, seed + n);
+        for (long i = 0; i < pieces && spawn_piece(game); i++) {
+            double t = now();
+            int count = generate_placements(game, placements);
+            busy += now() - t;
+            t = now();
+            int flood_count = flood_placements(game, flooded);
+            flood_busy += now() - t;
+            calls++;
+            total += count;
+            most = (count > most) ? count : most;
+            for (int j = 0; j < flood_count; j++) {
+                tucks += (flooded[j].flags & MONSTRO_TMOVES_TUCK) != 0;
+                wall_kicks += (flooded[j].flags & MONSTRO_TACTION_WALL_KICK) != 0;
+                floor_kicks += (flooded[j].flags & MONSTRO_TACTION_FLOOR_KICK) != 0;
+            }
+            if (check)
+                mismatches += check_placements(game, count, flood_count) != 0;
+            if (count == 0)
+                break;
+            
+        // Lock the piece at the best placement
+            MONSTRO_TROW *field = scratch.playfield;
+            uint64_t piece = piezas[game->piece][game->rotation];
+            int best = 0, best_score = INT32_MIN;
+            memcpy(field, game->playfield, sizeof(game->playfield));
+            borrar_pieza(field, piece, game->x, game->y);
+            for (int j = 0; j < count; j++) {
+                const MONSTRO_TPLACEMENT *p = &placements[j];
+                uint64_t candidate = piezas[game->piece][p->rotation];
+                poner_pieza(field, candidate, p->x, p->y);
+                int score = randomly ? (int)next_random(&random) : score_playfield(field) - (int)(next_random(&random) & 3);
+                borrar_pieza(field, candidate, p->x, p->y);
+                if (score > best_score) {
+                    best_score = score;
+                    best = j;
+                }
+            }
+            const MONSTRO_TPLACEMENT *p = &placements[best];
+            borrar_pieza(game->playfield, piece, game->x, game->y);
+            game->rotation = p->rotation;
+            game->x = p->x;
+            game->y = p->y;
+            poner_pieza(game->playfield, piezas[game->piece][p->rotation], p->x, p->y);
+            game->inputs = MONSTRO_TINPUT_UP;
+            mover_pieza(game);
+            if (!(game->flags & MONSTRO_TACTION_SNAP) || game->y != p->y)
+                errors++;
+            lines += __builtin_popcount(game->flags & MONSTRO_TACTION_CLEARED);
+        }
+    }
+    double seconds = now() - start;
+    if (check)
+        mismatches += check_floor_kick() != 0;
+    
+    printf("games: count=%ld lines=%llu\n", games, (unsigned long long)lines);
+    printf("placements: calls=%llu average=%.1f most=%d\n", (unsigned long long)calls, 
+           calls ? (double)total / calls : 0.0, most);
+    printf("generator: average=%.2fus calls_per_second=%.0f\n", calls ? busy * 1e6 / calls : 0.0, calls / busy);
+    printf("flood: average=%.2fus calls_per_second=%.0f tucks=%llu wall_kicks=%llu floor_kicks=%llu\n", 
+           calls ? flood_busy * 1e6 / calls : 0.0, calls / flood_busy, (unsigned long long)tucks, 
+           (unsigned long long)wall_kicks, (unsigned long long)floor_kicks);
+    if (check)
+        printf("check: mismatches=%llu\n", (unsigned long long)mismatches);
+    printf("total: seconds=%.3f errors=%llu\n", seconds, (unsigned long long)errors);
+    
+    return errors != 0 || mismatches != 0;
+}
@@ -0,0 +1,661 @@
+/**
+ * @file monstro-tmoves.c
+ * 
+ * @section LICENSE License
+ * 
+ * This is free and unencumbered software released into the public domain.
+ *
+ * Anyone is free to copy, modify, publish, use, compile, sell, or
+ * distribute this software, either in source code form or as a compiled
+ * binary, for any purpose, commercial or non-commercial, and by any
+ * means.
+ * 
+ * In jurisdictions that recognize copyright laws, the author or authors
+ * of this software dedicate any and all copyright interest in the
+ * software to the public domain. We make this dedication for the benefit
+ * of the public at large and to the detriment of our heirs and
+ * successors. We intend this dedication to be an overt act of
+ * relinquishment in perpetuity of all present and future rights to this
+ * software under copyright law.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+ * OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ * 
+ * For more information, please refer to <https://unlicense.org>
+ * 
+ * @section DESCRIPTION Description
+ * 
+ * This file contains an optional move generator, available only when 
+ * \c MONSTRO_TWANT_MOVES is defined, that finds every place where the 
+ * current piece can lock, for bots and for analysis tools that need 
+ * more than the straight drops from the spawn position:
+ * 
+ *      MONSTRO_TPLACEMENT placements[MONSTRO_TMOVES_MAX];
+ *      int count = generate_placements(&game, placements);
+ *      for (int i = 0; i < count; i++)
+ *          // piezas[game.piece][placements[i].rotation] can lock at 
+ *          // (placements[i].x, placements[i].y)
+ * 
+ * Starting from the current position of the piece, it does a breadth 
+ * first search over the states of the piece, its rotation and its 
+ * position, following every input a player can give: moving left or 
+ * right, a soft drop of one row and both rotations, wall kicks and 
+ * floor kicks included, as done by rotate_piece(). Every state from 
+ * where the piece can't fall any further is a placement, so slides 
+ * and tucks under overhangs are found along with the straight drops.
+ * 
+ * Each input is taken as its own game tick, without the timing of 
+ * gravity or of the snap counter, and the piece is taken as started 
+ * to snap whenever it rests on something, which is what decides the 
+ * floor kicks. With 20G gravity, where the piece can't stay above its 
+ * landing row, some of the placements may not be reachable.
+ * 
+ * Placements that cover the same blocks are only listed once, which 
+ * happens with every rotation of the O piece and with the two 
+ * horizontal and the two vertical rotations of the I, S and Z pieces. 
+ * Each one keeps the first state that was found for it and the number 
+ * of inputs needed to get there, which the search makes the fewest.
+ * 
+ * To keep the search fast, the positions where each rotation fits are 
+ * computed up front, for each row, as bit masks over \c x, so that 
+ * every move, rotation and kick is just a bit test; the kicks follow 
+ * the same steps as rotate_piece(), which remains the reference for 
+ * them. Also, the empty rows above the stack are only searched once, 
+ * which is where most of the states of the piece are.
+ * 
+ * flood_reach() does the same search as a flood fill over whole rows 
+ * of states at once, without counting inputs, and also finds which 
+ * states can be reached without kicks, with wall kicks only and with 
+ * straight drops, so that reach_flags() can tell whether a placement 
+ * is a tuck or needs a wall kick or a floor kick, and 
+ * flood_placements() can list the placements with those flags.
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include "monstro-tcore.h"
+#include "monstro-tlogic.h"
+#include "monstro-tpieces.h"
+#include "monstro-tmoves.h"
+
+#define ROW(y)          MONSTRO_TMOVES_ROW(y)      // Row 0 is below the lowest row, where nothing fits
+#define BIT(x)          ((uint64_t)1 << (x))
+#define COLUMNS_MASK    (BIT(MONSTRO_TMOVES_COLUMNS) - 1)
+
+// Rotations of a piece that cover the same blocks
+typedef struct {
+    int first[4];           // First rotation covering the same blocks as each rotation
+    int dx[4], dy[4];       // Offset of the blocks of each rotation within the 4x4 box
+} SYMMETRY;
+
+// State of the search
+typedef struct {
+    uint64_t fits[4][MONSTRO_TMOVES_ROWS + 1];      // Positions where each rotation fits, by row
+    uint64_t seen[4][MONSTRO_TMOVES_ROWS + 1];      // States already queued
+    uint64_t placed[4][MONSTRO_TMOVES_ROWS + 1];    // Placements already listed, by their first rotation
+    SYMMETRY symmetry;
+    MONSTRO_TPLACEMENT queue[MONSTRO_TMOVES_MAX];
+    int tail;
+} SEARCH;
+
+
+
+/**
+ * Finds, for each rotation of a piece, the first rotation that covers 
+ * the same blocks once both are moved to the bottom right corner of 
+ * their 4x4 box.
+ */
+static void find_symmetries(SYMMETRY *symmetry, int piece) {
+    uint64_t shape[4];
+    
+    for (int r = 0; r < 4; r++) {
+        uint64_t p = piezas[piece][r];
+        uint64_t columns = (p | p >> 16 | p >> 32 | p >> 48) & 0xFFFF;
+        symmetry->dy[r] = __builtin_ctzll(p) / 16;
+        symmetry->dx[r] = __builtin_ctzll(columns);
+        shape[r] = p >> (symmetry->dy[r] * 16 + symmetry->dx[r]);
+        symmetry->first[r] = r;
+        for (int i = 0; i < r; i++)
+            if (shape[i] == shape[r]) {
+                symmetry->first[r] = i;
+                break;
+            }
+    }
+}
+
+
+
+/**
+ * Copies the playfield of a game, without its current piece, after a 
+ * the zeroed guard rows; see \c MONSTRO_TGUARD_ROWS.
+ * 
+ * @param rows  An array of <tt>MONSTRO_TGUARD_ROWS + MONSTRO_TFIELD_SIZE</tt> rows.
+ * @return      The playfield within \c rows.
+ */
+static MONSTRO_TROW *locked_playfield(const MONSTRO_TGAME *game, MONSTRO_TROW *rows) {
+    MONSTRO_TROW *playfield = rows + MONSTRO_TGUARD_ROWS;
+    
+    memset(rows, 0, MONSTRO_TGUARD_ROWS * sizeof(MONSTRO_TROW));
+    memcpy(playfield, game->playfield, sizeof(game->playfield));
+    borrar_pieza(playfield, piezas[game->piece][game->rotation], game->x, game->y);
+    return playfield;
+}
+
+
+
+/**
+ * Tells whether the current piece of a game is in a position the 
+ * search can start from.
+ */
+static int valid_position(const MONSTRO_TGAME *game, uint64_t fits[4][MONSTRO_TMOVES_ROWS + 1]) {
+    return game->x >= 0 && game->x < MONSTRO_TMOVES_COLUMNS && game->y >= MONSTRO_TMOVES_MIN_Y && 
+           game->y <= MONSTRO_TFIELD_SIZE - 4 && (fits[game->rotation][ROW(game->y)] & BIT(game->x));
+}
+
+
+
+/**
+ * Computes the positions where each rotation of a piece fits, for 
+ * every row the piece can be at.
+ * 
+ * A block of the piece in column \c c collides at \c x when bit 
+ * <tt>x + c</tt> of its row is set, that is, when bit \c x of the row 
+ * shifted right by \c c is set, so each row of the piece rules out 
+ * every \c x at once.
+ */
+static void find_fits(uint64_t fits[4][MONSTRO_TMOVES_ROWS + 1], const MONSTRO_TROW *playfield, int piece) {
+    for (int r = 0; r < 4; r++) {
+        uint64_t p = piezas[piece][r];
+        fits[r][0] = 0;
+        for (int y = MONSTRO_TMOVES_MIN_Y; y <= MONSTRO_TFIELD_SIZE - 4; y++) {
+            uint64_t blocked = 0;
+            for (int i = 0; i < 4; i++)
+                for (unsigned int columns = (p >> (i * 16)) & 0xF; columns; columns &= columns - 1)
+                    blocked |= (uint64_t)(playfield[y + i] >> __builtin_ctz(columns));
+            fits[r][ROW(y)] = ~blocked & COLUMNS_MASK;
+        }
+    }
+}
+
+
+
+/**
+ * Queues a state of the piece, unless it was already queued.
+ */
+static inline void visit(SEARCH *search, int rotation, int x, int y, int inputs) {
+    uint64_t *seen = &search->seen[rotation][ROW(y)];
+    if (*seen & BIT(x))
+        return;
+    *seen |= BIT(x);
+    search->queue[search->tail++] = (MONSTRO_TPLACEMENT){x, y, rotation, inputs, 0};
+}
+
+
+
+/**
+ * Returns the positions of a row where a rotation fits and that 
+ * weren't queued yet.
+ */
+static inline uint64_t unseen(const SEARCH *search, int rotation, int y) {
+    return search->fits[rotation][ROW(y)] & ~search->seen[rotation][ROW(y)];
+}
+
+
+
+/**
+ * Queues a state of the piece known not to be queued yet.
+ */
+static inline void queue(SEARCH *search, int rotation, int x, int y, int inputs) {
+    search->seen[rotation][ROW(y)] |= BIT(x);
+    search->queue[search->tail++] = (MONSTRO_TPLACEMENT){x, y, rotation, inputs, 0};
+}
+
+
+
+/**
+ * Queues the state a rotation that collides kicks the piece to, if any.
+ * 
+ * This follows rotation_movement() in monstro-tlogic.c, as called by 
+ * rotate_piece(), step by step, but tests the positions on the bit 
+ * masks instead of the playfield. Any change to the kicks there must 
+ * be made here too; <tt>movegen-main -c</tt> checks both agree.
+ */
+static void kick(SEARCH *search, int piece, int rotation, int candidate, int x, int y, int resting, int inputs) {
+    const int y_maxima = MONSTRO_TFIELD_SIZE - 4;
+    uint64_t fits = search->fits[candidate][ROW(y)];
+    
+// Wall kick; the spin after it never happens, since the snap count is reset first
+    if (x > 0 && (fits & BIT(x - 1))) {
+        visit(search, candidate, x - 1, y, inputs);
+        return;
+    }
+    if (fits & BIT(x + 1)) {
+        visit(search, candidate, x + 1, y, inputs);
+        return;
+    }
+    
+// Floor kick, with the special case of the I piece
+    int oy = y, snapping = resting;
+    if (piece == _I_ && resting && rotation == 0 && y + 3 <= y_maxima) {
+        candidate = (candidate + 2) % 4;
+        rotation = 2;
+        y += 2;
+        snapping = false;
+    }
+    int i = snapping ? 1 : 0;
+    if (y + i + 1 <= y_maxima && (search->fits[candidate][ROW(y + i + 1)] & BIT(x))) {
+        visit(search, candidate, x, y + i + 1, inputs);
+        return;
+    }
+    
+// A failed floor kick still leaves the I piece in its other horizontal 
+// rotation, two rows up or, if it doesn't fit there, where it was
+    if (y != oy) {
+        if (search->fits[rotation][ROW(y)] & BIT(x))
+            visit(search, rotation, x, y, inputs);
+        else if (search->fits[rotation][ROW(oy)] & BIT(x))
+            visit(search, rotation, x, oy, inputs);
+    }
+}
+
+
+
+/**
+ * Queues the states one input away from a state of the piece and, if 
+ * the piece can't fall any further, lists it as a placement. The soft 
+ * drop is left out when \c fall is \c false.
+ * 
+ * @return  The new number of placements.
+ */
+static int expand(SEARCH *search, MONSTRO_TPLACEMENT state, int piece, int fall, 
+                  MONSTRO_TPLACEMENT *placements, int count) {
+    int r = state.rotation, x = state.x, y = state.y;
+    int inputs = state.inputs + (state.inputs < 255);
+    int resting = !(search->fits[r][ROW(y - 1)] & BIT(x));
+    
+    if (resting) {
+    // List the placement under the first rotation with the same blocks
+        const SYMMETRY *symmetry = &search->symmetry;
+        int first = symmetry->first[r];
+        int px = x + symmetry->dx[r] - symmetry->dx[first];
+        int py = y + symmetry->dy[r] - symmetry->dy[first];
+        uint64_t *placed = &search->placed[first][ROW(py)];
+        if (!(*placed & BIT(px))) {
+            *placed |= BIT(px);
+            placements[count++] = state;
+        }
+    }
+    else if (fall && (unseen(search, r, y - 1) & BIT(x)))
+        queue(search, r, x, y - 1, inputs);
+    uint64_t open = unseen(search, r, y);
+    if (open & BIT(x + 1))
+        queue(search, r, x + 1, y, inputs);
+    if (x > 0 && (open & BIT(x - 1)))
+        queue(search, r, x - 1, y, inputs);
+    
+// Every rotation of the O piece covers the same blocks and it never 
+// kicks, so rotating it doesn't lead anywhere new
+    if (piece == _O_)
+        return count;
+    for (int i = 0; i < 2; i++) {
+        int rotation = (r + ((i == 0) ? 3 : 1)) % 4;
+        if (search->fits[rotation][ROW(y)] & BIT(x))
+            visit(search, rotation, x, y, inputs);
+        else
+            kick(search, piece, r, rotation, x, y, resting, inputs);
+    }
+    return count;
+}
+
+
+
+/**
+ * Finds every place where the current piece of a game can lock.
+ * 
+ * The game itself isn't modified. The current piece must be on the 
+ * playfield, as it is after spawn_piece() or mover_pieza(); no 
+ * placements are found if it's not in a valid position.
+ * 
+ * @param game          A \c MONSTRO_TGAME struct representing the current game.
+ * @param placements    An array of at least \c MONSTRO_TMOVES_MAX 
+ *                      placements that receives the places where the 
+ *                      piece can lock, in the order they were found.
+ * @return              The number of placements.
+ */
+int generate_placements(const MONSTRO_TGAME *game, MONSTRO_TPLACEMENT *placements) {
+    SEARCH search;
+// See monstro-tlogic.h for the guard rows
+    MONSTRO_TROW rows[MONSTRO_TGUARD_ROWS + MONSTRO_TFIELD_SIZE];
+    MONSTRO_TROW *playfield = locked_playfield(game, rows);
+    int piece = game->piece, count = 0;
+    
+    find_symmetries(&search.symmetry, piece);
+    find_fits(search.fits, playfield, piece);
+    memset(search.seen, 0, sizeof(search.seen));
+    memset(search.placed, 0, sizeof(search.placed));
+    search.tail = 0;
+    if (!valid_position(game, search.fits))
+        return 0;
+    visit(&search, game->rotation, game->x, game->y, 0);
+    
+// Above the stack, from the row where the piece no longer touches 
+// anything but the walls, even one row below, the piece can't rest 
+// nor kick upwards and every row is alike: the states of a row are 
+// the ones of the row of the piece, one more input away for each row 
+// they are below it. Only that row is searched; the rows under it up 
+// to the stack get the same states and the search goes on from the 
+// row below them.
+    int sky = MONSTRO_TFIELD_SIZE;
+    while (sky > 1 && playfield[sky - 1] == MONSTRO_TWALLS)
+        sky--;
+    sky++;
+    int layer = 0, drop = game->y - sky + 1;
+    if (sky <= game->y) {
+        for (int head = 0; head < search.tail; head++)
+            count = expand(&search, search.queue[head], piece, false, placements, count);
+        layer = search.tail;
+        for (int r = 0; r < 4; r++)
+            for (int y = sky; y < game->y; y++)
+                search.seen[r][ROW(y)] = search.seen[r][ROW(game->y)];
+    }
+    
+// The states of the row below the ones that are alike are merged with 
+// the queue by number of inputs, which keeps the search breadth first
+    int seed = 0, head = layer;
+    while (seed < layer || head < search.tail) {
+        MONSTRO_TPLACEMENT state;
+        if (seed < layer && (head == search.tail || search.queue[seed].inputs + drop <= search.queue[head].inputs)) {
+            state = search.queue[seed++];
+            state.y = sky - 1;
+            state.inputs = (state.inputs + drop < 255) ? state.inputs + drop : 255;
+            if (!(unseen(&search, state.rotation, state.y) & BIT(state.x)))
+                continue;
+            search.seen[state.rotation][ROW(state.y)] |= BIT(state.x);
+        }
+        else
+            state = search.queue[head++];
+        count = expand(&search, state, piece, true, placements, count);
+    }
+    
+    return count;
+}
+
+
+
+/**
+ * Spreads a set of states of a row to every position it can get to by 
+ * moving left or right, without going through a position that doesn't 
+ * fit.
+ * 
+ * This is an occluded fill: at each step, the set moves twice as far as 
+ * in the previous one, over the positions that fit all along the way, 
+ * so it takes a handful of shifts instead of one per column.
+ */
+static inline uint64_t fill_row(uint64_t set, uint64_t fits) {
+    uint64_t up = fits, down = fits;
+    
+    set &= fits;
+    for (int shift = 1; shift < MONSTRO_TMOVES_COLUMNS; shift *= 2) {
+        set |= (up & (set << shift)) | (down & (set >> shift));
+        up &= up << shift;
+        down &= down >> shift;
+    }
+    return set;
+}
+
+
+
+/**
+ * Adds states to a row of a bitboard.
+ * 
+ * @return  \c true if any of the states is new.
+ */
+static inline int add_states(uint64_t *row, uint64_t states) {
+    if (!(states & ~*row))
+        return false;
+    *row |= states;
+    return true;
+}
+
+
+
+/**
+ * Flood fills a bitboard from the states already in it, following 
+ * moves, soft drops, rotations and, as asked by \c kicks, wall kicks 
+ * and floor kicks.
+ * 
+ * The bitboard is swept from the top row down. Within a row, moves, 
+ * rotations and wall kicks are repeated until the row doesn't change, 
+ * then every state of the row falls one row, if it fits there. A floor 
+ * kick takes states up to a row that was already swept, so the sweep 
+ * goes back up to it. The kicks are the ones of kick(), applied to 
+ * every state of a row at once.
+ */
+static void flood(const MONSTRO_TREACH *reach, uint64_t set[4][MONSTRO_TMOVES_ROWS + 1], int kicks) {
+    const int y_maxima = MONSTRO_TFIELD_SIZE - 4;
+    const uint64_t (*fits)[MONSTRO_TMOVES_ROWS + 1] = reach->fits;
+    int piece = reach->piece;
+    int walls = (kicks & MONSTRO_TACTION_WALL_KICK) && piece != _O_;
+    int floors = (kicks & MONSTRO_TACTION_FLOOR_KICK) && piece != _O_;
+    
+    for (int y = y_maxima; y >= MONSTRO_TMOVES_MIN_Y; y--) {
+        if (!(set[0][ROW(y)] | set[1][ROW(y)] | set[2][ROW(y)] | set[3][ROW(y)]))
+            continue;
+        
+    // Where the piece fits the same in this row, the one above it and the 
+    // one below it, it can't rest nor kick, so if it also got the same 
+    // states as the row above, it ends up with the same states; this 
+    // skips most of the empty rows above the stack
+        int alike = y < y_maxima;
+        for (int r = 0; r < 4 && alike; r++)
+            alike = fits[r][ROW(y - 1)] == fits[r][ROW(y)] && fits[r][ROW(y)] == fits[r][ROW(y + 1)] && 
+                    set[r][ROW(y)] == set[r][ROW(y + 1)];
+        if (alike) {
+            for (int r = 0; r < 4; r++)
+                set[r][ROW(y - 1)] |= set[r][ROW(y)] & fits[r][ROW(y - 1)];
+            continue;
+        }
+        
+        int top = y, changed;
+        do {
+            changed = false;
+            for (int r = 0; r < 4; r++) {
+                uint64_t states = fill_row(set[r][ROW(y)], fits[r][ROW(y)]);
+                uint64_t resting = states & ~fits[r][ROW(y - 1)];
+                set[r][ROW(y)] = states;
+                if (!states || piece == _O_)
+                    continue;
+                for (int i = 0; i < 2; i++) {
+                    int candidate = (r + ((i == 0) ? 3 : 1)) % 4;
+                    uint64_t rotated = fits[candidate][ROW(y)];
+                    uint64_t blocked = states & ~rotated;
+                    uint64_t added = states & rotated;
+                    if (walls) {
+                        uint64_t left = blocked & (rotated << 1);
+                        uint64_t right = blocked & ~left & (rotated >> 1);
+                        added |= (left >> 1) | (right << 1);
+                        blocked &= ~(left | right);
+                    }
+                    changed |= add_states(&set[candidate][ROW(y)], added);
+                    if (!floors || !blocked)
+                        continue;
+                    
+                // The I piece resting in rotation 0 first turns to rotation 2, two 
+                // rows up, and if the floor kick fails from there it stays that way
+                    if (piece == _I_ && r == 0 && y + 3 <= y_maxima) {
+                        uint64_t special = blocked & resting;
+                        int other = (candidate + 2) % 4;
+                        uint64_t kicked = special & fits[other][ROW(y + 3)];
+                        uint64_t turned = special & ~kicked & fits[2][ROW(y + 2)];
+                        if (add_states(&set[other][ROW(y + 3)], kicked))
+                            top = (y + 3 > top) ? y + 3 : top;
+                        if (add_states(&set[2][ROW(y + 2)], turned))
+                            top = (y + 2 > top) ? y + 2 : top;
+                        changed |= add_states(&set[2][ROW(y)], special & ~kicked & ~turned & fits[2][ROW(y)]);
+                        blocked &= ~special;
+                    }
+                    if (y + 1 <= y_maxima && add_states(&set[candidate][ROW(y + 1)], blocked & ~resting & fits[candidate][ROW(y + 1)]))
+                        top = (y + 1 > top) ? y + 1 : top;
+                    if (y + 2 <= y_maxima && add_states(&set[candidate][ROW(y + 2)], blocked & resting & fits[candidate][ROW(y + 2)]))
+                        top = (y + 2 > top) ? y + 2 : top;
+                }
+            }
+        } while (changed);
+        
+        for (int r = 0; r < 4; r++)
+            set[r][ROW(y - 1)] |= set[r][ROW(y)] & fits[r][ROW(y - 1)];
+        if (top > y)
+            y = top + 1;
+    }
+}
+
+
+
+/**
+ * Finds every state the current piece of a game can get to, as 
+ * bitboards, with a flood fill.
+ * 
+ * This is the same search as generate_placements(), but instead of 
+ * visiting the states one by one, it works on a whole row of states at 
+ * once and doesn't count inputs. Along with every state the piece can 
+ * get to, it finds the ones it can get to without kicks, with wall 
+ * kicks only and with straight drops from its row, which is what 
+ * reach_flags() needs to tell tucks and kicks apart. The states a 
+ * bitboard holds are read as:
+ * 
+ *      if (reach.reachable[r][MONSTRO_TMOVES_ROW(y)] & ((uint64_t)1 << x))
+ *          // the piece can get to rotation r at (x, y)
+ * 
+ * @param game  A \c MONSTRO_TGAME struct representing the current game, 
+ *              with its current piece on the playfield; the game 
+ *              itself isn't modified.
+ * @param reach The bitboards of the piece.
+ * @return      \c true if the piece is in a valid position; otherwise, 
+ *              \c false and every bitboard but \c fits is empty.
+ */
+int flood_reach(const MONSTRO_TGAME *game, MONSTRO_TREACH *reach) {
+// See monstro-tlogic.h for the guard rows
+    MONSTRO_TROW rows[MONSTRO_TGUARD_ROWS + MONSTRO_TFIELD_SIZE];
+    MONSTRO_TROW *playfield = locked_playfield(game, rows);
+    
+    reach->piece = game->piece;
+    reach->rotation = game->rotation;
+    reach->x = game->x;
+    reach->y = game->y;
+    find_fits(reach->fits, playfield, game->piece);
+    memset(reach->unkicked, 0, sizeof(reach->unkicked));
+    memset(reach->dropped, 0, sizeof(reach->dropped));
+    if (!valid_position(game, reach->fits)) {
+        memset(reach->reachable, 0, sizeof(reach->reachable));
+        memset(reach->wall_kicked, 0, sizeof(reach->wall_kicked));
+        return false;
+    }
+    
+// Each bitboard holds the previous one, so it starts from it
+    reach->unkicked[game->rotation][ROW(game->y)] = BIT(game->x);
+    flood(reach, reach->unkicked, 0);
+    memcpy(reach->wall_kicked, reach->unkicked, sizeof(reach->wall_kicked));
+    flood(reach, reach->wall_kicked, MONSTRO_TACTION_WALL_KICK);
+    memcpy(reach->reachable, reach->wall_kicked, sizeof(reach->reachable));
+    flood(reach, reach->reachable, MONSTRO_TACTION_WALL_KICK | MONSTRO_TACTION_FLOOR_KICK);
+    
+    for (int r = 0; r < 4; r++) {
+        reach->dropped[r][ROW(game->y)] = reach->wall_kicked[r][ROW(game->y)];
+        for (int y = game->y - 1; y >= MONSTRO_TMOVES_MIN_Y; y--)
+            reach->dropped[r][ROW(y)] = reach->dropped[r][ROW(y + 1)] & reach->fits[r][ROW(y)];
+    }
+    return true;
+}
+
+
+
+/**
+ * Tells how the current piece can get to a state where it locks.
+ * 
+ * Every rotation covering the same blocks as the given one is taken 
+ * into account, so the flags are the same for every state that locks 
+ * the piece in the same place.
+ * 
+ * @param reach     The bitboards from flood_reach().
+ * @param rotation  The rotation of the piece.
+ * @param x         The position \c x of the piece.
+ * @param y         The position \c y of the piece.
+ * @return          \c MONSTRO_TMOVES_TUCK if the piece can't get there 
+ *                  by dropping straight down from a state of its 
+ *                  row, plus \c MONSTRO_TACTION_WALL_KICK if it needs 
+ *                  a wall kick or \c MONSTRO_TACTION_FLOOR_KICK if it 
+ *                  needs a floor kick, maybe along with wall kicks. 
+ *                  \c MONSTRO_TACTION_SPIN is never returned: in 
+ *                  rotation_movement() the snap count is reset right 
+ *                  before it's checked for a spin, so a spin can't 
+ *                  happen.
+ */
+int reach_flags(const MONSTRO_TREACH *reach, int rotation, int x, int y) {
+    SYMMETRY symmetry;
+    int dropped = false, unkicked = false, wall_kicked = false;
+    
+    find_symmetries(&symmetry, reach->piece);
+    for (int r = 0; r < 4; r++) {
+        if (symmetry.first[r] != symmetry.first[rotation])
+            continue;
+        int rx = x + symmetry.dx[rotation] - symmetry.dx[r];
+        int ry = y + symmetry.dy[rotation] - symmetry.dy[r];
+        if (rx < 0 || rx >= MONSTRO_TMOVES_COLUMNS || ry < MONSTRO_TMOVES_MIN_Y || ry > MONSTRO_TFIELD_SIZE - 4)
+            continue;
+        dropped |= (reach->dropped[r][ROW(ry)] >> rx) & 1;
+        unkicked |= (reach->unkicked[r][ROW(ry)] >> rx) & 1;
+        wall_kicked |= (reach->wall_kicked[r][ROW(ry)] >> rx) & 1;
+    }
+    
+    int flags = dropped ? 0 : MONSTRO_TMOVES_TUCK;
+    if (!unkicked)
+        flags |= wall_kicked ? MONSTRO_TACTION_WALL_KICK : MONSTRO_TACTION_FLOOR_KICK;
+    return flags;
+}
+
+
+
+/**
+ * Finds every place where the current piece of a game can lock, with 
+ * a flood fill.
+ * 
+ * This finds the same placements as generate_placements() from the 
+ * bitboards of flood_reach(), along with their flags from reach_flags(), 
+ * but it doesn't count inputs, so \c inputs is always \c 0.
+ * 
+ * @param game          A \c MONSTRO_TGAME struct representing the current game.
+ * @param placements    An array of at least \c MONSTRO_TMOVES_MAX 
+ *                      placements that receives the places where the 
+ *                      piece can lock, by rotation and from the bottom up.
+ * @return              The number of placements.
+ */
+int flood_placements(const MONSTRO_TGAME *game, MONSTRO_TPLACEMENT *placements) {
+    MONSTRO_TREACH reach;
+    SYMMETRY symmetry;
+    uint64_t placed[4][MONSTRO_TMOVES_ROWS + 1] = {{0}};
+    int count = 0;
+    
+    if (!flood_reach(game, &reach))
+        return 0;
+    find_symmetries(&symmetry, game->piece);
+    for (int r = 0; r < 4; r++) {
+        int first = symmetry.first[r];
+        for (int y = MONSTRO_TMOVES_MIN_Y; y <= MONSTRO_TFIELD_SIZE - 4; y++)
+            for (uint64_t locks = reach.reachable[r][ROW(y)] & ~reach.fits[r][ROW(y - 1)]; locks; locks &= locks - 1) {
+                int x = __builtin_ctzll(locks);
+                int px = x + symmetry.dx[r] - symmetry.dx[first];
+                int py = y + symmetry.dy[r] - symmetry.dy[first];
+                if (placed[first][ROW(py)] & BIT(px))
+                    continue;
+                placed[first][ROW(py)] |= BIT(px);
+                placements[count++] = (MONSTRO_TPLACEMENT){x, y, r, 0, reach_flags(&reach, r, x, y)};
+            }
+    }
+    return count;
+}
@@ -34,7 +34,6 @@
  */
 
 #include <time.h>
-#include <stdlib.h>
 #include <ncurses.h> 
 #include "monstro-tlogic.h"
 
@@ -42,14 +41,12 @@
 
 #define KEY_SPACE    32
 #define COLOR_ORANGE 16
+#define VISIBLE_ROWS (MONSTRO_TFIELD_SIZE - 4)      // Top 4 rows are not visible
+#define TEXT_COLUMN  (MONSTRO_TFIELD_WIDTH * 2 + 1)
 
 
 
-MONSTRO_TGAME game = { .playfield = { 0xFFFF, 0xE007, 0xE007, 0xE007, 0xE007, 0xE007, 
-                                      0xE007, 0xE007, 0xE007, 0xE007, 0xE007, 0xE007, 
-                                      0xE007, 0xE007, 0xE007, 0xE007, 0xE007, 0xE007, 
-                                      0xE007, 0xE007, 0xE007, 0xE007, 0xE007, 0xE007 }, 
-                        .snap_default = MONSTRO_TSNAP_LIMIT, .snap_index = 1, 
+MONSTRO_TGAME game = { .snap_default = MONSTRO_TSNAP_LIMIT, .snap_index = 1, 
                         .drop_default = MONSTRO_TDROP_LIMIT, .drop_index = 1, 
                         .move_default = MONSTRO_TMOVE_LIMIT, .move_index = 1};
 int total_lines = 0;
@@ -61,30 +58,30 @@ int game_over = false;
  * Draws the playfield using ncurses.
  */
 void draw_playfield(MONSTRO_TGAME *game) {
-    static uint16_t previous[24] = {0};
+    static MONSTRO_TROW previous[MONSTRO_TFIELD_SIZE] = {0};
     int color;
     
-    for (int y = 0; y < 20; y++)
-        for (int x = 0; x < 16; x++)
+    for (int y = 0; y < VISIBLE_ROWS; y++)
+        for (int x = 0; x < MONSTRO_TFIELD_WIDTH; x++)
 #ifdef MONSTRO_TWANT_COLORS
             if (has_colors() && game->color_playfield[y][x] != -1) {
                 attron(COLOR_PAIR(game->color_playfield[y][x] + 1));
-                mvprintw(20 - y, x * 2, "[]");
+                mvprintw(VISIBLE_ROWS - y, x * 2, "[]");
             }
             
             attron(COLOR_PAIR(game->piece + 1));
             poner_pieza(previous, game->current_piece, game->x, game->y);
-            for (int y = 0; y < 20; y++)
-                for (int x = 0; x < 16; x++)
-                    if (previous[y] & (1 << x))
-                        mvprintw(20 - y, x * 2, "[]");
+            for (int y = 0; y < VISIBLE_ROWS; y++)
+                for (int x = 0; x < MONSTRO_TFIELD_WIDTH; x++)
+                    if (previous[y] & ((MONSTRO_TROW)1 << x))
+                        mvprintw(VISIBLE_ROWS - y, x * 2, "[]");
             borrar_pieza(previous, game->current_piece, game->x, game->y);
 #else
-            if (game->playfield[y] & (1 << x)) {
-                if (has_colors() && (x < 3 || x > 12 || y == 0))
+            if (game->playfield[y] & ((MONSTRO_TROW)1 << x)) {
+                if (has_colors() && ((MONSTRO_TWALLS >> x) & 1 || y == 0))
                     attroff(A_REVERSE);
                 else attron(A_REVERSE);
-                mvprintw(20 - y, x * 2, "[]");
+                mvprintw(VISIBLE_ROWS - y, x * 2, "[]");
             }
 #endif
 }
@@ -96,7 +93,8 @@ void draw_playfield(MONSTRO_TGAME *game) {
  */
 void initialization() {
 // ncurses initialization
-    srand(time(NULL));
+    init_playfield(&game);
+    seed_game(&game, time(NULL));
     initscr();
     cbreak();
     noecho();
@@ -134,6 +132,12 @@ void initialization() {
         }
     }
     init_color_playfield(&game);
+#endif
+#ifdef MONSTRO_TWANT_COLUMNS
+    init_columns(&game);
+#endif
+#ifdef MONSTRO_TWANT_HASH
+    init_hash(&game);
 #endif
     spawn_piece(&game);
 }
@@ -147,6 +151,7 @@ void logic() {
     int c = getch();
     
     if (c != ERR) {
+        if (c == KEY_UP)    game.inputs |= MONSTRO_TINPUT_UP;
         if (c == KEY_DOWN)  game.inputs |= MONSTRO_TINPUT_DOWN;
         if (c == KEY_LEFT)  game.inputs |= MONSTRO_TINPUT_RIGHT;
         if (c == KEY_RIGHT) game.inputs |= MONSTRO_TINPUT_LEFT;
@@ -168,15 +173,7 @@ void logic() {
     }
     if (game.flags & MONSTRO_TACTION_CLEARED) {
     // Count cleared lines and increase speed every few lines
-        total_lines += (game.flags & MONSTRO_TACTION_CLEARED0) ? 1 : 0;
-        total_lines += (game.flags & MONSTRO_TACTION_CLEARED1) ? 1 : 0;
-        total_lines += (game.flags & MONSTRO_TACTION_CLEARED2) ? 1 : 0;
-        total_lines += (game.flags & MONSTRO_TACTION_CLEARED3) ? 1 : 0;
-        if (total_lines > 10) {
-            total_lines -= 10;
-            game.drop_default /= 2;
-            game.snap_default -= game.snap_default / 8;
-        }
+        level_up(&game, &total_lines, __builtin_popcount(game.flags & MONSTRO_TACTION_CLEARED));
     }
 }
 
@@ -191,12 +188,12 @@ void update() {
     
     attroff(COLOR_PAIR);
     // mvprintw(0, 0, "KEY %d", c);
-    mvprintw(1, 33, "¡¡¡monstrominos by monstrochan!!!");
-    mvprintw(2, 33, "---------------------------------");
-    mvprintw(3, 33, "Version consola para monstros con");
-    mvprintw(4, 33, "PCs cuanticas  peruanas porque el");
-    mvprintw(5, 33, "monstro siempre al servicio de la");
-    mvprintw(6, 33, "comunidad.");
+    mvprintw(1, TEXT_COLUMN, "¡¡¡monstrominos by monstrochan!!!");
+    mvprintw(2, TEXT_COLUMN, "---------------------------------");
+    mvprintw(3, TEXT_COLUMN, "Version consola para monstros con");
+    mvprintw(4, TEXT_COLUMN, "PCs cuanticas  peruanas porque el");
+    mvprintw(5, TEXT_COLUMN, "monstro siempre al servicio de la");
+    mvprintw(6, TEXT_COLUMN, "comunidad.");
     
     refresh();
 }
@@ -0,0 +1,200 @@
+/**
+ * @file monstro-tpacked.c
+ * 
+ * @section LICENSE License
+ * 
+ * This is free and unencumbered software released into the public domain.
+ *
+ * Anyone is free to copy, modify, publish, use, compile, sell, or
+ * distribute this software, either in source code form or as a compiled
+ * binary, for any purpose, commercial or non-commercial, and by any
+ * means.
+ * 
+ * In jurisdictions that recognize copyright laws, the author or authors
+ * of this software dedicate any and all copyright interest in the
+ * software to the public domain. We make this dedication for the benefit
+ * of the public at large and to the detriment of our heirs and
+ * successors. We intend this dedication to be an overt act of
+ * relinquishment in perpetuity of all present and future rights to this
+ * software under copyright law.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+ * OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ * 
+ * For more information, please refer to <https://unlicense.org>
+ * 
+ * @section DESCRIPTION Description
+ * 
+ * This file contains an optional packed layout for the game state, 
+ * available only when \c MONSTRO_TWANT_PACKED is defined, meant for 
+ * programs that keep a large number of games resident in memory, such 
+ * as self-play. Every field of \c MONSTRO_TGAME other than the 
+ * playfield is an \c int, although its values fit in a few bits; 
+ * \c MONSTRO_TPACKED stores them in bit fields and bytes instead, drops 
+ * the floor row, which never changes, and drops the fields that are 
+ * not part of the state between calls to the logic:
+ * 
+ * - \c flags is returned by mover_pieza_packed() instead.
+ * - \c snap_index and \c drop_index are recomputed from the inputs at 
+ * the beginning of every call to mover_pieza().
+ * 
+ * With the default playfield dimensions the result is exactly 64 bytes, 
+ * one cache line, down from <tt>sizeof(MONSTRO_TGAME)</tt>, 128 bytes 
+ * with the guard rows, spread over two or three cache lines. The 
+ * packed layout can't hold the color playfield, the column index nor 
+ * the hash, so it can't be combined with those options, and the 
+ * \c *_default values, which bound the counters, must be \c 127 or 
+ * less, with \c move_default up to \c 255 as \c move_count is a byte. 
+ * The piece position is stored in 6 bit fields, so the playfield can't 
+ * be more than 35 rows high nor 35 columns wide.
+ * 
+ * mover_pieza_packed() and spawn_piece_packed() work on a packed game 
+ * by unpacking it into a \c MONSTRO_TGAME on the stack, calling the 
+ * regular logic and packing the result back, so the gameplay is always 
+ * the same as with \c MONSTRO_TGAME. The unpacked copy only lives in 
+ * the L1 cache for the duration of the call, but converting both ways 
+ * still costs more than it saves: a tick on a packed game takes about 
+ * 20% longer than mover_pieza() on a \c MONSTRO_TGAME, both when the 
+ * same game is ticked over and over (28 against 23 ns) and when a 
+ * million games are ticked in random order (66 against 53 ns). The 
+ * packed layout halves the memory taken by resident games; it doesn't 
+ * make ticking them faster.
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include "monstro-tlogic.h"
+
+
+
+/**
+ * Packs a game without checking its values; see pack_game().
+ */
+static inline void store_game(const MONSTRO_TGAME *game, MONSTRO_TPACKED *packed) {
+    packed->random_state = game->random_state;
+    packed->piece = game->piece;
+    packed->rotation = game->rotation;
+    packed->inputs = game->inputs;
+    packed->x = game->x;
+    packed->y = game->y;
+    packed->move_default = game->move_default;
+    packed->snap_default = game->snap_default;
+    packed->snap_count = game->snap_count;
+    packed->drop_default = game->drop_default;
+    packed->drop_count = game->drop_count;
+    packed->move_count = game->move_count;
+    packed->move_index = game->move_index;
+    memcpy(packed->playfield, &game->playfield[1], sizeof(packed->playfield));
+}
+
+
+
+/**
+ * Unpacks a game; see unpack_game().
+ */
+static inline void load_game(const MONSTRO_TPACKED *packed, MONSTRO_TGAME *game) {
+    memset(game->guard, 0, sizeof(game->guard));
+    game->playfield[0] = MONSTRO_TFULL_ROW;
+    memcpy(&game->playfield[1], packed->playfield, sizeof(packed->playfield));
+    game->piece = packed->piece;
+    game->rotation = packed->rotation;
+    game->x = packed->x;
+    game->y = packed->y;
+    game->inputs = packed->inputs;
+    game->flags = 0;
+    game->snap_default = packed->snap_default;
+    game->snap_count = packed->snap_count;
+    game->snap_index = 1;
+    game->drop_default = packed->drop_default;
+    game->drop_count = packed->drop_count;
+    game->drop_index = 1;
+    game->move_default = packed->move_default;
+    game->move_count = packed->move_count;
+    game->move_index = packed->move_index;
+    game->random_state = packed->random_state;
+}
+
+
+
+/**
+ * Packs a game.
+ * 
+ * @param game      A \c MONSTRO_TGAME struct representing the game to pack.
+ * @param packed    A \c MONSTRO_TPACKED struct where the game will be packed.
+ * @return          \c true if the game was packed, \c false if some 
+ *                  value doesn't fit in the packed layout, in which 
+ *                  case \c packed is left untouched.
+ */
+int pack_game(const MONSTRO_TGAME *game, MONSTRO_TPACKED *packed) {
+    if (game->snap_default > 127 || game->drop_default > 127 || game->move_default > 255 || 
+        (unsigned)game->snap_count > 255 || (unsigned)game->drop_count > 255 || 
+        (unsigned)game->move_count > 255 || (unsigned)game->move_index > 255 || 
+        game->x < -32 || game->x > 31 || game->y < -32 || game->y > 31)
+        return false;
+    
+    store_game(game, packed);
+    return true;
+}
+
+
+
+/**
+ * Unpacks a game.
+ * 
+ * The fields that are not part of the packed layout are set to the 
+ * values they would have at the beginning of a call to mover_pieza(): 
+ * \c flags is \c 0 and \c snap_index and \c drop_index are \c 1.
+ * 
+ * @param packed    A \c MONSTRO_TPACKED struct representing the game to unpack.
+ * @param game      A \c MONSTRO_TGAME struct where the game will be unpacked.
+ */
+void unpack_game(const MONSTRO_TPACKED *packed, MONSTRO_TGAME *game) {
+    load_game(packed, game);
+}
+
+
+
+/**
+ * Performs the game logic on a packed game; this is the packed 
+ * equivalent of setting \c inputs and calling mover_pieza().
+ * 
+ * @param packed    A \c MONSTRO_TPACKED struct representing the current game.
+ * @param inputs    The game inputs for this call.
+ * @return          The game action flags for this call.
+ */
+int mover_pieza_packed(MONSTRO_TPACKED *packed, int inputs) {
+    MONSTRO_TGAME copy;
+    
+    load_game(packed, &copy);
+    copy.inputs = inputs;
+    mover_pieza(&copy);
+    store_game(&copy, packed);
+    
+    return copy.flags;
+}
+
+
+
+/**
+ * Spawns a new piece into a packed game; this is the packed equivalent 
+ * of spawn_piece().
+ * 
+ * @param packed    A \c MONSTRO_TPACKED struct representing the current game.
+ * @return          \c true if the piece could be placed on the playfield.
+ */
+int spawn_piece_packed(MONSTRO_TPACKED *packed) {
+    MONSTRO_TGAME copy;
+    int spawned;
+    
+    load_game(packed, &copy);
+    spawned = spawn_piece(&copy);
+    store_game(&copy, packed);
+    
+    return spawned;
+}
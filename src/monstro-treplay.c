@@ -0,0 +1,504 @@
+/**
+ * @file monstro-treplay.c
+ * 
+ * @section LICENSE License
+ * 
+ * This is free and unencumbered software released into the public domain.
+ *
+ * Anyone is free to copy, modify, publish, use, compile, sell, or
+ * distribute this software, either in source code form or as a compiled
+ * binary, for any purpose, commercial or non-commercial, and by any
+ * means.
+ * 
+ * In jurisdictions that recognize copyright laws, the author or authors
+ * of this software dedicate any and all copyright interest in the
+ * software to the public domain. We make this dedication for the benefit
+ * of the public at large and to the detriment of our heirs and
+ * successors. We intend this dedication to be an overt act of
+ * relinquishment in perpetuity of all present and future rights to this
+ * software under copyright law.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+ * OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ * 
+ * For more information, please refer to <https://unlicense.org>
+ * 
+ * @section DESCRIPTION Description
+ * 
+ * This file contains an optional replay recorder and player, available 
+ * only when \c MONSTRO_TWANT_REPLAY is defined. Since the logic is 
+ * deterministic, a game is fully described by its seed plus the inputs 
+ * of every call to mover_pieza(), so that's all a replay stores:
+ * 
+ *      // Start recording right after the first spawn_piece()
+ *      seed_game(&game, seed);
+ *      spawn_piece(&game);
+ *      start_recording(&recorder, &game, seed, MONSTRO_TREPLAY_INTERVAL);
+ * 
+ *      ...
+ *      // Within the game loop, call mover_pieza_recorded() instead of mover_pieza()
+ *      mover_pieza_recorded(&recorder, &game);
+ *      if (game.flags & MONSTRO_TACTION_SPAWN)
+ *          game_over = !spawn_piece(&game);
+ * 
+ *      ...
+ *      size_t size = finish_recording(&recorder, &game);
+ *      // Write recorder.data somewhere, then free_recording(&recorder)
+ * 
+ * The caller may change the \c *_default limits between calls, as the 
+ * sample implementations do when the player clears lines; the recorder 
+ * detects the changes and stores them along with the inputs.
+ * 
+ * @section FORMAT Replay format
+ * 
+ * A replay starts with a 16 byte header: the characters \c MTRP, the 
+ * format version, the playfield size, width and well width, and the 
+ * seed as a little endian 64 bit value. The initial snap, drop and 
+ * move limits follow as varints (7 bits per byte, least significant 
+ * first, high bit set on every byte but the last).
+ * 
+ * The rest are records. The inputs change only once in a while, so 
+ * they are stored as runs of ticks with the same inputs. In a record 
+ * byte the low 6 bits are the inputs and the top 2 bits are the length 
+ * of the run, from 1 to 3 ticks; a 0 length means that a varint 
+ * follows. If the varint is 4 or more, it's the length of the run; 
+ * otherwise the low 6 bits of the record byte are not inputs but a 
+ * record type:
+ * 
+ * - \c 0 marks the end of the replay and is followed by the 
+ * game_checksum() of the final state of the game, after the last 
+ * piece spawned, as a little endian 32 bit value.
+ * - \c 1 is a checkpoint: the game_checksum() of the game after the 
+ * last tick, as a little endian 32 bit value. The recorder writes one 
+ * every \c interval ticks so the player can detect a desync close to 
+ * where it happened; with an interval of 1, the player reports the 
+ * exact tick where the game diverged, at the cost of 6 bytes per tick.
+ * - \c 2 sets the snap, drop and move limits to the 3 varints that 
+ * follow, before the next tick.
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include "monstro-treplay.h"
+
+#define HEADER_SIZE         16
+#define SHORT_RUN            3      // Longest run stored in the record byte
+#define RECORD_END           0
+#define RECORD_CHECKPOINT    1
+#define RECORD_LIMITS        2
+
+static const uint8_t magic[4] = {'M', 'T', 'R', 'P'};
+
+
+
+/**
+ * Makes room for \c n more bytes at the end of the replay.
+ */
+static int reserve(MONSTRO_TRECORDER *recorder, size_t n) {
+    if (recorder->failed)
+        return false;
+    if (recorder->size + n > recorder->capacity) {
+        size_t capacity = recorder->capacity * 2 + n;
+        uint8_t *data = realloc(recorder->data, capacity);
+        if (!data) {
+            recorder->failed = true;
+            return false;
+        }
+        recorder->data = data;
+        recorder->capacity = capacity;
+    }
+    return true;
+}
+
+
+
+static void put_byte(MONSTRO_TRECORDER *recorder, uint8_t value) {
+    if (reserve(recorder, 1))
+        recorder->data[recorder->size++] = value;
+}
+
+
+
+static void put_varint(MONSTRO_TRECORDER *recorder, uint64_t value) {
+    if (!reserve(recorder, 10))
+        return;
+    for (; value >= 0x80; value >>= 7)
+        recorder->data[recorder->size++] = (value & 0x7F) | 0x80;
+    recorder->data[recorder->size++] = value;
+}
+
+
+
+static void put_uint(MONSTRO_TRECORDER *recorder, uint64_t value, int bytes) {
+    if (!reserve(recorder, bytes))
+        return;
+    for (int i = 0; i < bytes; i++)
+        recorder->data[recorder->size++] = value >> (i * 8);
+}
+
+
+
+/**
+ * Writes the current run of inputs, if any.
+ */
+static void flush_run(MONSTRO_TRECORDER *recorder) {
+    if (recorder->run == 0)
+        return;
+    if (recorder->run <= SHORT_RUN)
+        put_byte(recorder, recorder->run << 6 | recorder->inputs);
+    else {
+        put_byte(recorder, recorder->inputs);
+        put_varint(recorder, recorder->run);
+    }
+    recorder->run = 0;
+}
+
+
+
+static void put_limits(MONSTRO_TRECORDER *recorder, const MONSTRO_TGAME *game) {
+    put_varint(recorder, game->snap_default);
+    put_varint(recorder, game->drop_default);
+    put_varint(recorder, game->move_default);
+    recorder->snap_default = game->snap_default;
+    recorder->drop_default = game->drop_default;
+    recorder->move_default = game->move_default;
+}
+
+
+
+/**
+ * Starts recording a game.
+ * 
+ * This must be called right after the first call to spawn_piece(), 
+ * with the game seeded with \c seed and its limits set.
+ * 
+ * @param recorder  A \c MONSTRO_TRECORDER struct to initialize.
+ * @param game      A \c MONSTRO_TGAME struct representing the game to record.
+ * @param seed      The value passed to seed_game().
+ * @param interval  The number of ticks between checkpoints, 0 for none.
+ * @return          \c true if the recording started, \c false if 
+ *                  the memory for it couldn't be allocated.
+ */
+int start_recording(MONSTRO_TRECORDER *recorder, const MONSTRO_TGAME *game, uint64_t seed, int interval) {
+    memset(recorder, 0, sizeof(*recorder));
+    recorder->interval = interval;
+    
+    if (reserve(recorder, 256)) {
+        memcpy(recorder->data, magic, sizeof(magic));
+        recorder->data[4] = MONSTRO_TREPLAY_VERSION;
+        recorder->data[5] = MONSTRO_TFIELD_SIZE;
+        recorder->data[6] = MONSTRO_TFIELD_WIDTH;
+        recorder->data[7] = MONSTRO_TWELL_WIDTH;
+        recorder->size = 8;
+        put_uint(recorder, seed, 8);
+        put_limits(recorder, game);
+    }
+    return !recorder->failed;
+}
+
+
+
+/**
+ * Performs the game logic, the same as mover_pieza(), and records the 
+ * inputs of the call.
+ * 
+ * @param recorder  A \c MONSTRO_TRECORDER struct representing the recording.
+ * @param game      A \c MONSTRO_TGAME struct representing the current game.
+ */
+void mover_pieza_recorded(MONSTRO_TRECORDER *recorder, MONSTRO_TGAME *game) {
+    int inputs = game->inputs & 0x3F;
+    
+    if (game->snap_default != recorder->snap_default || game->drop_default != recorder->drop_default || 
+        game->move_default != recorder->move_default) {
+        flush_run(recorder);
+        put_byte(recorder, RECORD_LIMITS);
+        put_byte(recorder, 0);
+        put_limits(recorder, game);
+    }
+    if (inputs != recorder->inputs) {
+        flush_run(recorder);
+        recorder->inputs = inputs;
+    }
+    recorder->run++;
+    
+    mover_pieza(game);
+    recorder->ticks++;
+    
+    if (recorder->interval > 0 && recorder->ticks % recorder->interval == 0) {
+        flush_run(recorder);
+        put_byte(recorder, RECORD_CHECKPOINT);
+        put_byte(recorder, 0);
+        put_uint(recorder, game_checksum(game, 0), 4);
+    }
+}
+
+
+
+/**
+ * Ends the recording.
+ * 
+ * @param recorder  A \c MONSTRO_TRECORDER struct representing the recording.
+ * @param game      A \c MONSTRO_TGAME struct representing the recorded game.
+ * @return          The size of the replay in \c recorder->data, or \c 0 
+ *                  if the memory for the replay couldn't be allocated.
+ */
+size_t finish_recording(MONSTRO_TRECORDER *recorder, const MONSTRO_TGAME *game) {
+    flush_run(recorder);
+// The final checksum covers the limits, which the caller may have 
+// changed after the last tick
+    if (game->snap_default != recorder->snap_default || game->drop_default != recorder->drop_default || 
+        game->move_default != recorder->move_default) {
+        put_byte(recorder, RECORD_LIMITS);
+        put_byte(recorder, 0);
+        put_limits(recorder, game);
+    }
+    put_byte(recorder, RECORD_END);
+    put_byte(recorder, 0);
+    put_uint(recorder, game_checksum(game, 0), 4);
+    
+    return recorder->failed ? 0 : recorder->size;
+}
+
+
+
+/**
+ * Frees the memory used by a recording.
+ * 
+ * @param recorder  A \c MONSTRO_TRECORDER struct representing the recording.
+ */
+void free_recording(MONSTRO_TRECORDER *recorder) {
+    free(recorder->data);
+    memset(recorder, 0, sizeof(*recorder));
+}
+
+
+
+/**
+ * Reads a varint; returns \c false if the data ends before it does.
+ */
+static int get_varint(const uint8_t **data, const uint8_t *end, uint64_t *value) {
+    *value = 0;
+    for (int shift = 0; *data < end && shift < 64; shift += 7) {
+        uint8_t byte = *(*data)++;
+        *value |= (uint64_t)(byte & 0x7F) << shift;
+        if (!(byte & 0x80))
+            return true;
+    }
+    return false;
+}
+
+
+
+static int get_limits(const uint8_t **data, const uint8_t *end, MONSTRO_TGAME *game) {
+    uint64_t snap, drop, move;
+    
+    if (!get_varint(data, end, &snap) || !get_varint(data, end, &drop) || !get_varint(data, end, &move) || 
+        snap > INT32_MAX || drop > INT32_MAX || move > INT32_MAX)
+        return false;
+    game->snap_default = snap;
+    game->drop_default = drop;
+    game->move_default = move;
+    return true;
+}
+
+
+
+static void spawn_next(MONSTRO_TGAME *game, MONSTRO_TREPLAY_RESULT *result) {
+    int spawned = spawn_piece(game);
+    result->pieces += spawned;
+    result->game_over |= !spawned;
+}
+
+
+
+/**
+ * Starts playing a replay back: checks its header and sets the game up 
+ * the same way as the sample implementations do, up to the first 
+ * spawn_piece(). The replay is then played with continue_replay().
+ * 
+ * @param data      The replay.
+ * @param size      The size of the replay, in bytes.
+ * @param game      A \c MONSTRO_TGAME struct where the game will be played.
+ * @param cursor    A \c MONSTRO_TREPLAY_CURSOR struct to initialize.
+ * @param result    A \c MONSTRO_TREPLAY_RESULT struct where the outcome 
+ *                  of the replay will be stored.
+ * @return          \c MONSTRO_TREPLAY_PAUSED if the replay is ready to be 
+ *                  played, \c MONSTRO_TREPLAY_CORRUPT or 
+ *                  \c MONSTRO_TREPLAY_INCOMPATIBLE otherwise.
+ */
+int start_replay(const uint8_t *data, size_t size, MONSTRO_TGAME *game, MONSTRO_TREPLAY_CURSOR *cursor, MONSTRO_TREPLAY_RESULT *result) {
+    const uint8_t *start = data, *end = data + size;
+    
+    memset(result, 0, sizeof(*result));
+    memset(cursor, 0, sizeof(*cursor));
+    if (size < HEADER_SIZE || memcmp(data, magic, sizeof(magic)) != 0)
+        return MONSTRO_TREPLAY_CORRUPT;
+    if (data[4] != MONSTRO_TREPLAY_VERSION || data[5] != MONSTRO_TFIELD_SIZE || 
+        data[6] != MONSTRO_TFIELD_WIDTH || data[7] != MONSTRO_TWELL_WIDTH)
+        return MONSTRO_TREPLAY_INCOMPATIBLE;
+    for (int i = 0; i < 8; i++)
+        result->seed |= (uint64_t)data[8 + i] << (i * 8);
+    data += HEADER_SIZE;
+    
+    start_game(game, result->seed);
+    if (!get_limits(&data, end, game))
+        return MONSTRO_TREPLAY_CORRUPT;
+    result->game_over = !spawn_piece(game);
+    result->pieces = !result->game_over;
+    cursor->offset = data - start;
+    
+    return MONSTRO_TREPLAY_PAUSED;
+}
+
+
+
+/**
+ * Plays a replay started with start_replay(), re-simulating the game 
+ * without any rendering and verifying every checkpoint, until it ends 
+ * or until \c result->ticks reaches \c ticks.
+ * 
+ * Just like the sample implementations, spawn_piece() is called whenever 
+ * mover_pieza() sets \c MONSTRO_TACTION_SPAWN. When the replay pauses, 
+ * \c game holds the state of the game between two ticks, as a frontend 
+ * would see it, and the replay can be resumed by calling this function 
+ * again with the same \c cursor and \c result. On a desync, \c game holds 
+ * the state at the checkpoint that didn't match.
+ * 
+ * @param data      The replay.
+ * @param size      The size of the replay, in bytes.
+ * @param game      A \c MONSTRO_TGAME struct where the game is being played.
+ * @param cursor    A \c MONSTRO_TREPLAY_CURSOR struct holding the position 
+ *                  within the replay.
+ * @param result    A \c MONSTRO_TREPLAY_RESULT struct where the outcome 
+ *                  of the replay is being stored.
+ * @param ticks     The tick at which to pause, \c UINT64_MAX to play the 
+ *                  replay to the end.
+ * @return          \c MONSTRO_TREPLAY_OK, \c MONSTRO_TREPLAY_PAUSED, 
+ *                  \c MONSTRO_TREPLAY_DESYNC or \c MONSTRO_TREPLAY_CORRUPT.
+ */
+int continue_replay(const uint8_t *data, size_t size, MONSTRO_TGAME *game, MONSTRO_TREPLAY_CURSOR *cursor, 
+                    MONSTRO_TREPLAY_RESULT *result, uint64_t ticks) {
+    const uint8_t *start = data, *end = data + size;
+    int outcome = MONSTRO_TREPLAY_CORRUPT;
+    
+    if (cursor->offset > size)
+        return MONSTRO_TREPLAY_CORRUPT;
+    data += cursor->offset;
+    
+// The recorder computes checkpoints before the caller spawns the next 
+// piece, so the player spawns it right before the next tick instead
+    for (;;) {
+        if (cursor->run > 0) {
+            uint64_t run = cursor->run;
+            int inputs = cursor->inputs, spawn = cursor->spawn;
+            
+            if (run > ticks - result->ticks)
+                run = ticks - result->ticks;
+            cursor->run -= run;
+            result->ticks += run;
+            while (run-- > 0) {
+                if (spawn)
+                    spawn_next(game, result);
+                game->inputs = inputs;
+                mover_pieza(game);
+                if (game->flags & MONSTRO_TACTION_CLEARED)
+                    result->lines += __builtin_popcount(game->flags & MONSTRO_TACTION_CLEARED);
+                spawn = game->flags & MONSTRO_TACTION_SPAWN;
+            }
+            cursor->spawn = spawn;
+            if (cursor->run > 0) {
+                outcome = MONSTRO_TREPLAY_PAUSED;
+                break;
+            }
+        }
+        if (data >= end)
+            break;
+        
+        const uint8_t *position = data;
+        uint8_t record = *data++;
+        uint64_t run = record >> 6;
+        
+        if (run == 0) {
+            if (!get_varint(&data, end, &run))
+                break;
+            if (run == 0) {
+                if (record == RECORD_END || record == RECORD_CHECKPOINT) {
+                    if (end - data < 4)
+                        break;
+                    if (record == RECORD_END && cursor->spawn) {
+                        spawn_next(game, result);
+                        cursor->spawn = false;
+                    }
+                    uint32_t checksum = data[0] | data[1] << 8 | data[2] << 16 | (uint32_t)data[3] << 24;
+                    data += 4;
+                    if (checksum != game_checksum(game, 0)) {
+                        outcome = MONSTRO_TREPLAY_DESYNC;
+                        break;
+                    }
+                    result->checkpoints++;
+                    if (record == RECORD_END) {
+                        outcome = MONSTRO_TREPLAY_OK;
+                        break;
+                    }
+                }
+                else if (record != RECORD_LIMITS || !get_limits(&data, end, game))
+                    break;
+                continue;
+            }
+            if (run <= SHORT_RUN)
+                break;
+        }
+        
+        // Checkpoints and limits that follow the last tick are processed before pausing
+        if (result->ticks >= ticks) {
+            data = position;
+            outcome = MONSTRO_TREPLAY_PAUSED;
+            break;
+        }
+        cursor->inputs = record & 0x3F;
+        cursor->run = run;
+    }
+    
+    if (outcome == MONSTRO_TREPLAY_PAUSED && cursor->spawn) {
+        spawn_next(game, result);
+        cursor->spawn = false;
+    }
+    cursor->offset = data - start;
+    
+    return outcome;
+}
+
+
+
+/**
+ * Plays a replay back from start to end; see start_replay() and 
+ * continue_replay().
+ * 
+ * On return, \c game holds the state of the game at the end of the 
+ * replay or, on a desync, at the checkpoint that didn't match, and 
+ * \c result->ticks tells which tick that is.
+ * 
+ * @param data      The replay.
+ * @param size      The size of the replay, in bytes.
+ * @param game      A \c MONSTRO_TGAME struct where the game will be played.
+ * @param result    A \c MONSTRO_TREPLAY_RESULT struct where the outcome 
+ *                  of the replay will be stored.
+ * @return          \c MONSTRO_TREPLAY_OK, \c MONSTRO_TREPLAY_DESYNC, 
+ *                  \c MONSTRO_TREPLAY_CORRUPT or \c MONSTRO_TREPLAY_INCOMPATIBLE.
+ */
+int play_replay(const uint8_t *data, size_t size, MONSTRO_TGAME *game, MONSTRO_TREPLAY_RESULT *result) {
+    MONSTRO_TREPLAY_CURSOR cursor;
+    int outcome = start_replay(data, size, game, &cursor, result);
+    
+    if (outcome != MONSTRO_TREPLAY_PAUSED)
+        return outcome;
+    outcome = continue_replay(data, size, game, &cursor, result, UINT64_MAX);
+    return (outcome == MONSTRO_TREPLAY_PAUSED) ? MONSTRO_TREPLAY_CORRUPT : outcome;
+}
@@ -0,0 +1,340 @@
+/**
+ * @file monstro-troom.c
+ * 
+ * @section LICENSE License
+ * 
+ * This is free and unencumbered software released into the public domain.
+ *
+ * Anyone is free to copy, modify, publish, use, compile, sell, or
+ * distribute this software, either in source code form or as a compiled
+ * binary, for any purpose, commercial or non-commercial, and by any
+ * means.
+ * 
+ * In jurisdictions that recognize copyright laws, the author or authors
+ * of this software dedicate any and all copyright interest in the
+ * software to the public domain. We make this dedication for the benefit
+ * of the public at large and to the detriment of our heirs and
+ * successors. We intend this dedication to be an overt act of
+ * relinquishment in perpetuity of all present and future rights to this
+ * software under copyright law.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+ * OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ * 
+ * For more information, please refer to <https://unlicense.org>
+ * 
+ * @section DESCRIPTION Description
+ * 
+ * This file contains an optional battle room, available only when 
+ * \c MONSTRO_TWANT_ROOM is defined, that plays up to 
+ * \c MONSTRO_TROOM_BOARDS boards in the same process, all of them 
+ * ticked together, where the lines cleared on each board are sent as 
+ * garbage to another board that is still playing.
+ * 
+ * Each tick, advance_room() plays every board with its inputs, the 
+ * same way as the sample implementations, and collects the attacks 
+ * sent during the tick in a single outbox; only once every board has 
+ * played are the attacks delivered to the queues of their targets, so 
+ * the result doesn't depend on the order of the boards. Clearing 1, 2, 
+ * 3 or 4 lines sends 0, 1, 2 or 4 garbage rows, which first cancel the 
+ * rows waiting in the queue of the board and only then are sent. The 
+ * rows waiting in the queue are added to the playfield when a new 
+ * piece spawns, up to \c MONSTRO_TROOM_GARBAGE rows per piece, with a 
+ * single call to add_garbage(). Every board gets the same sequence of 
+ * pieces, while the targets and the holes come from the random 
+ * generator of the room, so a room is reproducible from its seed and 
+ * inputs.
+ * 
+ * A single scheduler drives the whole room at \c MONSTRO_TROOM_RATE 
+ * ticks per second:
+ * 
+ *      init_room(&room, seed, 100);
+ * 
+ *      ...
+ *      while (room.alive > 1) {
+ *          wait_room(&room);
+ *          // Read the inputs of every board
+ *          advance_room(&room, inputs);
+ *      }
+ * 
+ * wait_room() sleeps until the deadline of the next tick, which keeps 
+ * the rate fixed regardless of how long each tick takes, and reports 
+ * how late it woke up; a room that falls more than 
+ * \c MONSTRO_TROOM_MAX_LATE ticks behind gives up those ticks instead of 
+ * playing them in a burst. The time spent in advance_room() is kept 
+ * along with these counters, so the headroom left in each tick is 
+ * known.
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <time.h>
+#include "monstro-troom.h"
+
+#define QUEUED(board, index)    ((board)->queue[(index) & (MONSTRO_TROOM_QUEUE - 1)])
+
+// Garbage rows sent for each number of lines cleared at once
+static const uint8_t garbage_rows[5] = {0, 0, 1, 2, 4};
+
+
+
+static inline int64_t now(void) {
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return (int64_t)t.tv_sec * 1000000000 + t.tv_nsec;
+}
+
+
+
+/**
+ * Returns a pseudo random value in the range [0, n), from the same 
+ * PCG32 generator as spawn_piece(), see pcg32_next().
+ */
+static int random_range(MONSTRO_TROOM *room, int n) {
+    return (int)(((uint64_t)pcg32_next(&room->random_state) * n) >> 32);
+}
+
+
+
+/**
+ * Picks a random board still playing, other than the given one, as its 
+ * new target. Returns -1 if there is none.
+ */
+static int pick_target(MONSTRO_TROOM *room, int index) {
+    if (room->alive < 2)
+        return -1;
+    int skip = random_range(room, room->alive - 1);
+    for (int i = 0; i < room->count; i++)
+        if (i != index && !room->boards[i].game_over && skip-- == 0)
+            return i;
+    return -1;
+}
+
+
+
+/**
+ * Cancels up to the given number of rows waiting in the queue of a 
+ * board and returns the number of rows left to send.
+ */
+static int cancel_garbage(MONSTRO_TROOM_BOARD *board, int rows) {
+    while (rows > 0 && board->head != board->tail) {
+        MONSTRO_TROOM_ATTACK *attack = &QUEUED(board, board->head);
+        int cancelled = (rows < attack->rows) ? rows : attack->rows;
+        attack->rows -= cancelled;
+        board->cancelled += cancelled;
+        rows -= cancelled;
+        if (attack->rows == 0)
+            board->head++;
+    }
+    return rows;
+}
+
+
+
+/**
+ * Adds to the playfield of a board up to \c MONSTRO_TROOM_GARBAGE rows 
+ * from the front of its queue, all of them with a single call to 
+ * add_garbage().
+ * 
+ * @return  \c false if the board topped out.
+ */
+static int receive_garbage(MONSTRO_TROOM_BOARD *board) {
+    int holes[MONSTRO_TROOM_GARBAGE];
+    int count = 0;
+    
+    while (count < MONSTRO_TROOM_GARBAGE && board->head != board->tail) {
+        MONSTRO_TROOM_ATTACK *attack = &QUEUED(board, board->head);
+        while (count < MONSTRO_TROOM_GARBAGE && attack->rows > 0) {
+            holes[count++] = attack->hole;
+            attack->rows--;
+        }
+        if (attack->rows == 0)
+            board->head++;
+    }
+    if (count == 0)
+        return true;
+    board->received += count;
+    return add_garbage(&board->game, holes, count);
+}
+
+
+
+/**
+ * Adds an attack to the queue of a board; when the queue is full, its 
+ * rows go to the last attack in the queue instead.
+ */
+static void queue_attack(MONSTRO_TROOM_BOARD *board, const MONSTRO_TROOM_ATTACK *attack) {
+    if (board->tail - board->head < MONSTRO_TROOM_QUEUE) {
+        QUEUED(board, board->tail++) = *attack;
+        return;
+    }
+    MONSTRO_TROOM_ATTACK *last = &QUEUED(board, board->tail - 1);
+    last->rows = (last->rows + attack->rows > UINT8_MAX) ? UINT8_MAX : last->rows + attack->rows;
+}
+
+
+
+/**
+ * Ends the game of a board, gives it its place and credits the boards 
+ * that were attacking it.
+ */
+static void knock_out(MONSTRO_TROOM *room, int index) {
+    MONSTRO_TROOM_BOARD *board = &room->boards[index];
+    
+    board->game_over = true;
+    board->place = room->alive--;
+    board->head = board->tail;
+    for (int i = 0; i < room->count; i++)
+        if (room->boards[i].target == index && !room->boards[i].game_over)
+            room->boards[i].knockouts++;
+    if (room->alive == 1)
+        for (int i = 0; i < room->count; i++)
+            if (!room->boards[i].game_over)
+                room->boards[i].place = 1;
+}
+
+
+
+/**
+ * Plays one tick of a board, the same as the sample implementations, 
+ * and puts the garbage it sends, if any, in the outbox of the room.
+ */
+static inline void step_board(MONSTRO_TROOM *room, int index, int inputs) {
+    MONSTRO_TROOM_BOARD *board = &room->boards[index];
+    MONSTRO_TGAME *game = &board->game;
+    
+    game->inputs = inputs;
+    mover_pieza(game);
+    if (game->flags & MONSTRO_TACTION_CLEARED) {
+        int lines = __builtin_popcount(game->flags & MONSTRO_TACTION_CLEARED);
+        board->lines += lines;
+        level_up(game, &board->level_lines, lines);
+        int rows = cancel_garbage(board, garbage_rows[lines]);
+        if (rows > 0) {
+            MONSTRO_TROOM_ATTACK *attack = &room->outbox[room->sent];
+            attack->from = index;
+            attack->rows = rows;
+            attack->hole = random_range(room, MONSTRO_TWELL_WIDTH);
+            room->targets[room->sent++] = board->target;
+            board->sent += rows;
+        }
+    }
+// The garbage waiting in the queue goes in only when the locked piece 
+// cleared no lines, once the new piece spawns
+    if ((game->flags & MONSTRO_TACTION_SPAWN) && (!spawn_piece(game) || 
+        (!(game->flags & MONSTRO_TACTION_CLEARED) && !receive_garbage(board))))
+        knock_out(room, index);
+}
+
+
+
+/**
+ * Starts a room. Every board starts with an empty playfield and the 
+ * same sequence of pieces, and with a random target.
+ * 
+ * @param room      A \c MONSTRO_TROOM struct to initialize.
+ * @param seed      The seed of the room.
+ * @param count     The number of boards, from 2 to \c MONSTRO_TROOM_BOARDS.
+ * @return          \c true if the room started, \c false if the number 
+ *                  of boards is out of range.
+ */
+int init_room(MONSTRO_TROOM *room, uint64_t seed, int count) {
+    if (count < 2 || count > MONSTRO_TROOM_BOARDS)
+        return false;
+    
+    memset(room, 0, sizeof(*room));
+    room->count = room->alive = count;
+    room->random_state = seed * 2 + 1;
+    room->period = 1000000000 / MONSTRO_TROOM_RATE;
+    
+    for (int i = 0; i < count; i++) {
+        MONSTRO_TGAME *game = &room->boards[i].game;
+        start_game(game, seed);
+        room->boards[i].target = pick_target(room, i);
+        spawn_piece(game);
+    }
+    
+    return true;
+}
+
+
+
+/**
+ * Plays the next tick of every board still playing and delivers the 
+ * attacks sent during it.
+ * 
+ * @param room      A \c MONSTRO_TROOM struct representing the room.
+ * @param inputs    The inputs of each board, one byte per board.
+ */
+void advance_room(MONSTRO_TROOM *room, const uint8_t *inputs) {
+    int64_t start = now();
+    
+    room->sent = 0;
+    for (int i = 0; i < room->count; i++)
+        if (!room->boards[i].game_over)
+            step_board(room, i, inputs[i] & 0x3F);
+    
+// Boards whose target topped out pick a new one before the attacks are 
+// delivered, so no garbage is lost on a board that's already out
+    for (int i = 0; i < room->count; i++) {
+        MONSTRO_TROOM_BOARD *board = &room->boards[i];
+        if (!board->game_over && (board->target < 0 || room->boards[board->target].game_over))
+            board->target = pick_target(room, i);
+    }
+    for (int i = 0; i < room->sent; i++) {
+        int target = room->targets[i];
+        if (target < 0 || room->boards[target].game_over)
+            target = room->boards[room->outbox[i].from].target;
+        if (target >= 0)
+            queue_attack(&room->boards[target], &room->outbox[i]);
+    }
+    room->tick++;
+    
+    int64_t busy = now() - start;
+    room->busy += busy;
+    if (busy > room->worst_busy)
+        room->worst_busy = busy;
+}
+
+
+
+/**
+ * Waits until the deadline of the next tick. The first call sets the 
+ * deadline of the first tick to the current time.
+ * 
+ * @param room      A \c MONSTRO_TROOM struct representing the room.
+ * @return          The time between the deadline and the return of 
+ *                  this function, in nanoseconds.
+ */
+int64_t wait_room(MONSTRO_TROOM *room) {
+    int64_t time = now();
+    
+    if (room->deadline == 0)
+        room->deadline = time;
+    while (time < room->deadline) {
+        struct timespec t = { .tv_sec = room->deadline / 1000000000, .tv_nsec = room->deadline % 1000000000 };
+        clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &t, NULL);
+        time = now();
+    }
+    
+    int64_t lag = time - room->deadline;
+    if (lag > room->worst_lag)
+        room->worst_lag = lag;
+    if (lag >= room->period)
+        room->late++;
+// Too far behind; the missed ticks are given up and the schedule starts 
+// again from now
+    if (lag > MONSTRO_TROOM_MAX_LATE * room->period) {
+        room->dropped += lag / room->period;
+        room->deadline = time;
+    }
+    room->deadline += room->period;
+    
+    return lag;
+}
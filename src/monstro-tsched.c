@@ -0,0 +1,298 @@
+/**
+ * @file monstro-tsched.c
+ * 
+ * @section LICENSE License
+ * 
+ * This is free and unencumbered software released into the public domain.
+ *
+ * Anyone is free to copy, modify, publish, use, compile, sell, or
+ * distribute this software, either in source code form or as a compiled
+ * binary, for any purpose, commercial or non-commercial, and by any
+ * means.
+ * 
+ * In jurisdictions that recognize copyright laws, the author or authors
+ * of this software dedicate any and all copyright interest in the
+ * software to the public domain. We make this dedication for the benefit
+ * of the public at large and to the detriment of our heirs and
+ * successors. We intend this dedication to be an overt act of
+ * relinquishment in perpetuity of all present and future rights to this
+ * software under copyright law.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+ * OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ * 
+ * For more information, please refer to <https://unlicense.org>
+ * 
+ * @section DESCRIPTION Description
+ * 
+ * This file contains an optional scheduler, available only when 
+ * \c MONSTRO_TWANT_SCHEDULER is defined, that lets a single thread play 
+ * thousands of game sessions, each one at its own tick rate, instead 
+ * of having a thread per session.
+ * 
+ * Each session is a MONSTRO_TTASK, a state machine whose resume 
+ * function is called once per tick and plays that tick, usually with a 
+ * single call to mover_pieza(), keeping whatever it needs between 
+ * ticks in \c state and \c data:
+ * 
+ *      int resume(MONSTRO_TTASK *task) {
+ *          SESSION *session = task->data;
+ *          switch (task->state) {
+ *              case WAITING: ...
+ *              case PLAYING: ...
+ *          }
+ *          return task->state != FINISHED;
+ *      }
+ * 
+ *      ...
+ *      init_scheduler(&scheduler);
+ *      add_task(&scheduler, &task, scheduler_time(), 1000000000 / 60);
+ *      run_scheduler(&scheduler, end);
+ * 
+ * The deadlines of the tasks are kept in a hashed timer wheel: a ring 
+ * of \c MONSTRO_TSCHED_SLOTS lists, each one holding the tasks due in 
+ * the same \c MONSTRO_TSCHED_RESOLUTION nanoseconds, modulo one turn of 
+ * the wheel. Adding, removing and rescheduling a task takes constant 
+ * time, and each wake up only looks at the slots that went by since 
+ * the last one. Within a slot, each task is resumed only once its own 
+ * deadline is reached, and run_scheduler() sleeps until the earliest 
+ * one, so the resolution of the wheel doesn't add any jitter.
+ * 
+ * The next deadline of a task is always its previous one plus its 
+ * period, so ticks don't drift. A task that falls behind is resumed 
+ * once per wake up until it catches up, unless it falls more than 
+ * \c MONSTRO_TSCHED_MAX_LATE periods behind, in which case the missed 
+ * ticks are given up. Each task keeps the lag of its ticks, so it's 
+ * known when the scheduler can't keep up.
+ * 
+ * A resume function may add new tasks, but it must not remove any; it 
+ * returns \c false to remove its own task instead.
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <time.h>
+#include "monstro-tsched.h"
+
+#define SLOT_INDEX(slot)    ((int)((slot) & (MONSTRO_TSCHED_SLOTS - 1)))
+
+
+
+/**
+ * Returns the current time, in nanoseconds of CLOCK_MONOTONIC, the 
+ * clock used for every deadline.
+ */
+int64_t scheduler_time(void) {
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return (int64_t)t.tv_sec * 1000000000 + t.tv_nsec;
+}
+
+
+
+/**
+ * Puts a task in the slot of its deadline, or in the next slot to check 
+ * if the deadline already went by.
+ */
+static void insert_task(MONSTRO_TSCHEDULER *scheduler, MONSTRO_TTASK *task) {
+    int64_t slot = task->deadline / MONSTRO_TSCHED_RESOLUTION;
+    int index = SLOT_INDEX((slot < scheduler->slot) ? scheduler->slot : slot);
+    
+    task->slot = index;
+    task->prev = NULL;
+    task->next = scheduler->slots[index];
+    if (task->next)
+        task->next->prev = task;
+    scheduler->slots[index] = task;
+}
+
+
+
+static void unlink_task(MONSTRO_TSCHEDULER *scheduler, MONSTRO_TTASK *task) {
+    if (task->prev)
+        task->prev->next = task->next;
+    else
+        scheduler->slots[task->slot] = task->next;
+    if (task->next)
+        task->next->prev = task->prev;
+}
+
+
+
+/**
+ * Resumes a task for its tick due now and sets its next deadline.
+ * 
+ * The lag runs up to the time the task is actually resumed, not the 
+ * start of the pass, so it includes the time spent on the tasks 
+ * resumed before it in the same pass.
+ * 
+ * @return  \c false if the task ended.
+ */
+static inline int resume_task(MONSTRO_TTASK *task) {
+    int64_t now = scheduler_time();
+    int64_t lag = now - task->deadline;
+    
+    task->ticks++;
+    task->last_lag = lag;
+    task->total_lag += lag;
+    if (lag > task->worst_lag)
+        task->worst_lag = lag;
+    if (lag > MONSTRO_TSCHED_LATE)
+        task->late++;
+    if (!task->resume(task))
+        return false;
+    
+    task->deadline += task->period;
+    if (lag > MONSTRO_TSCHED_MAX_LATE * task->period) {
+        int64_t missed = (now - task->deadline) / task->period + 1;
+        task->skipped += missed;
+        task->deadline += missed * task->period;
+    }
+    return true;
+}
+
+
+
+/**
+ * Starts an empty scheduler.
+ * 
+ * @param scheduler A \c MONSTRO_TSCHEDULER struct to initialize.
+ */
+void init_scheduler(MONSTRO_TSCHEDULER *scheduler) {
+    memset(scheduler, 0, sizeof(*scheduler));
+    scheduler->slot = scheduler_time() / MONSTRO_TSCHED_RESOLUTION;
+}
+
+
+
+/**
+ * Adds a task to the scheduler.
+ * 
+ * @param scheduler A \c MONSTRO_TSCHEDULER struct representing the scheduler.
+ * @param task      The task, with its \c resume function and \c data set; 
+ *                  every other field is reset.
+ * @param start     The deadline of the first tick, see scheduler_time().
+ * @param period    The time between ticks, in nanoseconds, at least 
+ *                  \c MONSTRO_TSCHED_RESOLUTION.
+ * @return          \c true if the task was added, \c false if the 
+ *                  period is too short.
+ */
+int add_task(MONSTRO_TSCHEDULER *scheduler, MONSTRO_TTASK *task, int64_t start, int64_t period) {
+    if (period < MONSTRO_TSCHED_RESOLUTION)
+        return false;
+    
+    task->state = 0;
+    task->period = period;
+    task->deadline = start;
+    task->ticks = task->late = task->skipped = 0;
+    task->last_lag = task->worst_lag = task->total_lag = 0;
+    insert_task(scheduler, task);
+    scheduler->count++;
+    return true;
+}
+
+
+
+/**
+ * Removes a task from the scheduler; this must not be called from a 
+ * resume function.
+ * 
+ * @param scheduler A \c MONSTRO_TSCHEDULER struct representing the scheduler.
+ * @param task      A task added to the scheduler.
+ */
+void remove_task(MONSTRO_TSCHEDULER *scheduler, MONSTRO_TTASK *task) {
+    unlink_task(scheduler, task);
+    scheduler->count--;
+}
+
+
+
+/**
+ * Resumes every task due by the given time, once each.
+ * 
+ * @param scheduler A \c MONSTRO_TSCHEDULER struct representing the scheduler.
+ * @param now       The current time, see scheduler_time(); the tasks due 
+ *                  by then are resumed, but the lag of each one is taken 
+ *                  when it is resumed.
+ * @return          The earliest deadline left, \c INT64_MAX if there are 
+ *                  no tasks.
+ */
+int64_t advance_scheduler(MONSTRO_TSCHEDULER *scheduler, int64_t now) {
+    int64_t last = now / MONSTRO_TSCHED_RESOLUTION;
+    int64_t start = scheduler_time();
+    
+// Tasks due in later turns of the wheel, or later within the current 
+// slot, stay where they are; the current slot is checked again on the 
+// next call
+    for (;;) {
+        MONSTRO_TTASK *task = scheduler->slots[SLOT_INDEX(scheduler->slot)];
+        while (task) {
+            MONSTRO_TTASK *next = task->next;
+            if (task->deadline <= now) {
+                unlink_task(scheduler, task);
+                scheduler->resumed++;
+                if (resume_task(task))
+                    insert_task(scheduler, task);
+                else
+                    scheduler->count--;
+            }
+            task = next;
+        }
+        if (scheduler->slot >= last)
+            break;
+        scheduler->slot++;
+    }
+    scheduler->busy += scheduler_time() - start;
+    
+// The earliest deadline is in the first slot, from the current one, 
+// with a task due within this turn of the wheel
+    if (scheduler->count == 0)
+        return INT64_MAX;
+    int64_t earliest = INT64_MAX;
+    for (int64_t slot = scheduler->slot; slot < scheduler->slot + MONSTRO_TSCHED_SLOTS; slot++) {
+        int64_t end = (slot + 1) * MONSTRO_TSCHED_RESOLUTION;
+        for (MONSTRO_TTASK *task = scheduler->slots[SLOT_INDEX(slot)]; task; task = task->next)
+            if (task->deadline < end && task->deadline < earliest)
+                earliest = task->deadline;
+        if (earliest != INT64_MAX)
+            return earliest;
+    }
+    for (int i = 0; i < MONSTRO_TSCHED_SLOTS; i++)
+        for (MONSTRO_TTASK *task = scheduler->slots[i]; task; task = task->next)
+            if (task->deadline < earliest)
+                earliest = task->deadline;
+    return earliest;
+}
+
+
+
+/**
+ * Resumes the tasks at their deadlines, sleeping in between, until the 
+ * given time or until there are no tasks left.
+ * 
+ * @param scheduler A \c MONSTRO_TSCHEDULER struct representing the scheduler.
+ * @param end       The time to return at, see scheduler_time().
+ */
+void run_scheduler(MONSTRO_TSCHEDULER *scheduler, int64_t end) {
+    for (;;) {
+        int64_t now = scheduler_time();
+        if (now >= end)
+            return;
+        int64_t next = advance_scheduler(scheduler, now);
+        if (scheduler->count == 0)
+            return;
+        if (next > end)
+            next = end;
+        if (next > scheduler_time()) {
+            struct timespec t = { .tv_sec = next / 1000000000, .tv_nsec = next % 1000000000 };
+            clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &t, NULL);
+            scheduler->wakeups++;
+        }
+    }
+}
@@ -0,0 +1,555 @@
+/**
+ * @file monstro-tserver.c
+ * 
+ * @section LICENSE License
+ * 
+ * This is free and unencumbered software released into the public domain.
+ *
+ * Anyone is free to copy, modify, publish, use, compile, sell, or
+ * distribute this software, either in source code form or as a compiled
+ * binary, for any purpose, commercial or non-commercial, and by any
+ * means.
+ * 
+ * In jurisdictions that recognize copyright laws, the author or authors
+ * of this software dedicate any and all copyright interest in the
+ * software to the public domain. We make this dedication for the benefit
+ * of the public at large and to the detriment of our heirs and
+ * successors. We intend this dedication to be an overt act of
+ * relinquishment in perpetuity of all present and future rights to this
+ * software under copyright law.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+ * OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ * 
+ * For more information, please refer to <https://unlicense.org>
+ * 
+ * @section DESCRIPTION Description
+ * 
+ * Game server that hosts one game per client connection, over TCP or a 
+ * Unix socket, on a small pool of threads. Usage:
+ * 
+ *      server-main [-p port] [-a address] [-u path] [-t threads]
+ * 
+ * Each thread runs its own event loop on its own epoll instance, and 
+ * every thread waits on the listening socket with \c EPOLLEXCLUSIVE, 
+ * so a new connection wakes up a single thread, which then owns the 
+ * connection for its whole life; nothing is shared between threads but 
+ * the listening socket and the statistics written at exit. Every 
+ * socket is non-blocking, so an idle connection costs only its buffers 
+ * and a slow client never holds back the rest.
+ * 
+ * Messages have no framing besides their type, the first byte, and 
+ * every value is in little endian order. A client starts a game with
+ * 
+ *      Offset  Size  Contents
+ *      0       1     S
+ *      1       8     Seed for seed_game()
+ * 
+ * and plays it by sending batches of inputs, each one played as a call 
+ * to mover_pieza(), the same way as the sample implementations:
+ * 
+ *      Offset  Size  Contents
+ *      0       1     I
+ *      1       1     Number of inputs, N
+ *      2       N     Inputs, one byte each
+ * 
+ * After each of these two messages, the server sends the state of the 
+ * game as a delta with only the rows of the playfield that changed 
+ * since the previous delta; the first delta of a game compares against 
+ * an empty playfield, so it has every row:
+ * 
+ *      Offset  Size  Contents
+ *      0       1     D
+ *      1       4     Number of ticks played, the low 32 bits
+ *      5       2     Game action flags of every tick of the batch, ORed
+ *      7       1     Piece
+ *      8       1     Rotation
+ *      9       1     x
+ *      10      1     y, signed
+ *      11      1     1 if the game is over, 0 otherwise
+ *      12      M     One bit per row, set if the row changed
+ *      12 + M  R     Changed rows, from the bottom up
+ * 
+ * The playfield includes the current piece, as drawn by the sample 
+ * implementations. Inputs received after the game is over are ignored. 
+ * \c Q asks for the state of the whole game, to be checked against a 
+ * local copy:
+ * 
+ *      Offset  Size  Contents
+ *      0       1     C
+ *      1       8     Number of ticks played
+ *      9       8     Number of lines cleared
+ *      17      4     game_checksum() of the game
+ *      21      1     1 if the game is over, 0 otherwise
+ * 
+ * The messages read by a single wake up are all handled before any 
+ * reply is written, and then each connection gets all of its replies 
+ * with a single write; when a client doesn't read its replies, the 
+ * server stops reading its messages until it does. The server runs 
+ * until \c SIGINT or \c SIGTERM, and then writes its statistics.
+ */
+
+#define _GNU_SOURCE     /* For accept4() */
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <signal.h>
+#include <errno.h>
+#include <pthread.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <sys/resource.h>
+#include <sys/un.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+#include "monstro-tserver.h"
+#include "monstro-tbytes.h"
+
+#define MAX_THREADS     64
+#define MAX_EVENTS      256
+#define READ_SIZE       512
+#define WRITE_SIZE      4096
+
+typedef struct {
+    MONSTRO_TGAME game;
+    MONSTRO_TROW sent[MONSTRO_TFIELD_SIZE];     /* Playfield as of the last delta */
+    uint64_t ticks, lines;
+    int level_lines;
+    int playing, game_over;
+    int flags;          /* Flags of the ticks since the last delta */
+    int socket;
+    int events;         /* Events the socket is registered for */
+    int dirty;          /* Set if it's in the list of connections to write */
+    size_t read_size, write_start, write_size;
+    uint8_t read_buffer[READ_SIZE];
+    uint8_t write_buffer[WRITE_SIZE];
+} CLIENT;
+
+typedef struct {
+    pthread_t thread;
+    int epoll;
+    CLIENT *dirty[MAX_EVENTS];
+    int dirty_count;
+// Statistics
+    uint64_t clients, peak_clients, accepted;
+    uint64_t ticks, messages, reads, writes, bytes_read, bytes_written;
+} WORKER;
+
+WORKER workers[MAX_THREADS];
+int listener = -1;
+volatile sig_atomic_t stop = false;
+
+
+
+void handle_signal(int signal) {
+    (void)signal;
+    stop = true;
+}
+
+
+
+/*
+ * Starts a new game for a client, the same as the other implementations.
+ */
+void new_game(CLIENT *client, uint64_t seed) {
+    MONSTRO_TGAME *game = &client->game;
+    
+    start_game(game, seed);
+    memset(client->sent, 0, sizeof(client->sent));
+    client->ticks = client->lines = 0;
+    client->level_lines = 0;
+    client->flags = 0;
+    client->playing = true;
+    client->game_over = !spawn_piece(game);
+}
+
+
+
+/*
+ * Plays one tick of a game, the same as the sample implementations.
+ */
+void step_game(CLIENT *client, int inputs) {
+    MONSTRO_TGAME *game = &client->game;
+    
+    game->inputs = inputs;
+    mover_pieza(game);
+    client->flags |= game->flags;
+    client->ticks++;
+    if (game->flags & MONSTRO_TACTION_SPAWN)
+        client->game_over = !spawn_piece(game);
+    if (game->flags & MONSTRO_TACTION_CLEARED) {
+        int lines = __builtin_popcount(game->flags & MONSTRO_TACTION_CLEARED);
+        client->lines += lines;
+        level_up(game, &client->level_lines, lines);
+    }
+}
+
+
+
+/*
+ * Queues the delta of a game since the last one; there must be room for 
+ * MONSTRO_TSERVER_DELTA_SIZE bytes in the write buffer.
+ */
+void write_delta(CLIENT *client) {
+    const MONSTRO_TGAME *game = &client->game;
+    uint8_t *buffer = client->write_buffer + client->write_size;
+    uint8_t *row = buffer + MONSTRO_TSERVER_DELTA_HEADER;
+    
+    buffer[0] = MONSTRO_TSERVER_DELTA;
+    put_le(buffer + 1, client->ticks, 4);
+    put_le(buffer + 5, client->flags, 2);
+    buffer[7] = game->piece;
+    buffer[8] = game->rotation;
+    buffer[9] = game->x;
+    buffer[10] = (uint8_t)(int8_t)game->y;
+    buffer[11] = client->game_over;
+    memset(buffer + 12, 0, MONSTRO_TSERVER_MASK_SIZE);
+    for (int y = 0; y < MONSTRO_TFIELD_SIZE; y++)
+        if (game->playfield[y] != client->sent[y]) {
+            buffer[12 + y / 8] |= 1 << (y % 8);
+            put_le(row, game->playfield[y], sizeof(MONSTRO_TROW));
+            row += sizeof(MONSTRO_TROW);
+            client->sent[y] = game->playfield[y];
+        }
+    client->write_size = row - client->write_buffer;
+    client->flags = 0;
+}
+
+
+
+void write_checksum(CLIENT *client) {
+    uint8_t *buffer = client->write_buffer + client->write_size;
+    
+    buffer[0] = MONSTRO_TSERVER_CHECKSUM;
+    put_le(buffer + 1, client->ticks, 8);
+    put_le(buffer + 9, client->lines, 8);
+    put_le(buffer + 17, client->playing ? game_checksum(&client->game, 0) : 0, 4);
+    buffer[21] = client->game_over;
+    client->write_size += MONSTRO_TSERVER_CHECKSUM_SIZE;
+}
+
+
+
+/*
+ * Changes the events a socket is registered for, if needed.
+ */
+void watch_client(WORKER *worker, CLIENT *client, int events) {
+    if (client->events == events)
+        return;
+    struct epoll_event event = { .events = events, .data.ptr = client };
+    epoll_ctl(worker->epoll, EPOLL_CTL_MOD, client->socket, &event);
+    client->events = events;
+}
+
+
+
+void close_client(WORKER *worker, CLIENT *client) {
+    close(client->socket);
+    client->socket = -1;
+    worker->clients--;
+// A connection waiting to be written is freed once the list is done
+    if (!client->dirty)
+        free(client);
+}
+
+
+
+/*
+ * Adds a connection with replies to write to the list of the worker.
+ */
+void mark_client(WORKER *worker, CLIENT *client) {
+    if (client->write_size > 0 && !client->dirty) {
+        client->dirty = true;
+        worker->dirty[worker->dirty_count++] = client;
+    }
+}
+
+
+
+/*
+ * Handles every complete message in the read buffer, as long as there's 
+ * room for their replies.
+ * 
+ * @return  \c false if the client sent an invalid message.
+ */
+int handle_messages(WORKER *worker, CLIENT *client) {
+    size_t start = 0;
+    
+    while (start < client->read_size) {
+        const uint8_t *message = client->read_buffer + start;
+        size_t size = client->read_size - start;
+        size_t length;
+        
+        switch (message[0]) {
+            case MONSTRO_TSERVER_START: length = 9; break;
+            case MONSTRO_TSERVER_INPUTS: length = (size < 2) ? 2 : 2 + (size_t)message[1]; break;
+            case MONSTRO_TSERVER_QUERY: length = 1; break;
+            default: return false;
+        }
+        if (size < length || WRITE_SIZE - client->write_size < MONSTRO_TSERVER_DELTA_SIZE)
+            break;
+        
+        switch (message[0]) {
+            case MONSTRO_TSERVER_START:
+                new_game(client, get_le(message + 1, 8));
+                write_delta(client);
+                break;
+            case MONSTRO_TSERVER_INPUTS:
+                if (!client->playing)
+                    return false;
+                for (int i = 0; i < message[1] && !client->game_over; i++, worker->ticks++)
+                    step_game(client, message[2 + i] & 0x3F);
+                write_delta(client);
+                break;
+            case MONSTRO_TSERVER_QUERY:
+                write_checksum(client);
+                break;
+        }
+        worker->messages++;
+        start += length;
+    }
+    
+    memmove(client->read_buffer, client->read_buffer + start, client->read_size - start);
+    client->read_size -= start;
+    return true;
+}
+
+
+
+/*
+ * Writes as much of the write buffer as the socket takes. Reading is 
+ * paused while the buffer has no room for another reply, and the socket 
+ * is watched for writing while anything is left.
+ */
+void flush_client(WORKER *worker, CLIENT *client) {
+    while (client->write_start < client->write_size) {
+        ssize_t written = send(client->socket, client->write_buffer + client->write_start, 
+                               client->write_size - client->write_start, MSG_NOSIGNAL);
+        if (written < 0) {
+            if (errno == EINTR)
+                continue;
+            if (errno != EAGAIN && errno != EWOULDBLOCK) {
+                close_client(worker, client);
+                return;
+            }
+            break;
+        }
+        worker->writes++;
+        worker->bytes_written += written;
+        client->write_start += written;
+    }
+    if (client->write_start == client->write_size)
+        client->write_start = client->write_size = 0;
+    else if (client->write_start > 0 && WRITE_SIZE - client->write_size < MONSTRO_TSERVER_DELTA_SIZE) {
+        memmove(client->write_buffer, client->write_buffer + client->write_start, client->write_size - client->write_start);
+        client->write_size -= client->write_start;
+        client->write_start = 0;
+    }
+    
+    int full = WRITE_SIZE - client->write_size < MONSTRO_TSERVER_DELTA_SIZE;
+    watch_client(worker, client, (full ? 0 : EPOLLIN) | (client->write_size ? EPOLLOUT : 0) | EPOLLRDHUP);
+}
+
+
+
+/*
+ * Reads whatever the client sent and handles it.
+ */
+void read_client(WORKER *worker, CLIENT *client) {
+    if (client->read_size < READ_SIZE) {
+        ssize_t size = recv(client->socket, client->read_buffer + client->read_size, READ_SIZE - client->read_size, 0);
+        if (size == 0 || (size < 0 && errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR)) {
+            close_client(worker, client);
+            return;
+        }
+        if (size > 0) {
+            worker->reads++;
+            worker->bytes_read += size;
+            client->read_size += size;
+        }
+    }
+    if (!handle_messages(worker, client))
+        close_client(worker, client);
+    else
+        mark_client(worker, client);
+}
+
+
+
+void accept_clients(WORKER *worker) {
+    for (;;) {
+        int socket = accept4(listener, NULL, NULL, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (socket < 0)
+            return;
+        CLIENT *client = calloc(1, sizeof(CLIENT));
+        if (!client) {
+            close(socket);
+            continue;
+        }
+        int one = 1;
+        setsockopt(socket, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+        client->socket = socket;
+        client->events = EPOLLIN | EPOLLRDHUP;
+        struct epoll_event event = { .events = client->events, .data.ptr = client };
+        if (epoll_ctl(worker->epoll, EPOLL_CTL_ADD, socket, &event) != 0) {
+            close(socket);
+            free(client);
+            continue;
+        }
+        worker->accepted++;
+        if (++worker->clients > worker->peak_clients)
+            worker->peak_clients = worker->clients;
+    }
+}
+
+
+
+void *run_worker(void *data) {
+    WORKER *worker = data;
+    struct epoll_event events[MAX_EVENTS];
+    
+    while (!stop) {
+        int count = epoll_wait(worker->epoll, events, MAX_EVENTS, 250);
+        for (int i = 0; i < count; i++) {
+            CLIENT *client = events[i].data.ptr;
+            if (!client) {
+                accept_clients(worker);
+                continue;
+            }
+            if (events[i].events & (EPOLLERR | EPOLLHUP)) {
+                close_client(worker, client);
+                continue;
+            }
+            if (events[i].events & EPOLLIN)
+                read_client(worker, client);
+            else if (events[i].events & EPOLLRDHUP)
+                close_client(worker, client);
+            else if (events[i].events & EPOLLOUT)
+                mark_client(worker, client);
+        }
+        
+    // One write per connection for everything it got during this wake up; 
+    // a connection that had its reading paused handles what it has left 
+    // as soon as its replies make room. Connections closed meanwhile 
+    // stay in the list until here.
+        for (int i = 0; i < worker->dirty_count; i++) {
+            CLIENT *client = worker->dirty[i];
+            while (client->socket >= 0) {
+                flush_client(worker, client);
+                size_t pending = client->read_size;
+                if (client->socket < 0 || pending == 0 || !(client->events & EPOLLIN))
+                    break;
+                if (!handle_messages(worker, client))
+                    close_client(worker, client);
+                else if (client->read_size == pending)
+                    break;
+            }
+            client->dirty = false;
+            if (client->socket < 0)
+                free(client);
+        }
+        worker->dirty_count = 0;
+    }
+    
+    return NULL;
+}
+
+
+
+int open_listener(const char *address, int port, const char *path) {
+    if (path) {
+        struct sockaddr_un local = { .sun_family = AF_UNIX };
+        if (strlen(path) >= sizeof(local.sun_path))
+            return -1;
+        strcpy(local.sun_path, path);
+        unlink(path);
+        listener = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+        if (listener < 0 || bind(listener, (struct sockaddr *)&local, sizeof(local)) != 0)
+            return -1;
+    }
+    else {
+        struct sockaddr_in local = { .sin_family = AF_INET, .sin_port = htons(port) };
+        int one = 1;
+        if (inet_pton(AF_INET, address, &local.sin_addr) != 1)
+            return -1;
+        listener = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+        if (listener < 0)
+            return -1;
+        setsockopt(listener, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+        if (bind(listener, (struct sockaddr *)&local, sizeof(local)) != 0)
+            return -1;
+    }
+    return listen(listener, SOMAXCONN);
+}
+
+
+
+int main(int argc, char **argv) {
+    const char *address = "127.0.0.1", *path = NULL;
+    int port = MONSTRO_TSERVER_PORT, threads = 4, option;
+    
+    while ((option = getopt(argc, argv, "p:a:u:t:")) != -1)
+        switch (option) {
+            case 'p': port = atoi(optarg); break;
+            case 'a': address = optarg; break;
+            case 'u': path = optarg; break;
+            case 't': threads = atoi(optarg); break;
+            default:
+                fprintf(stderr, "usage: %s [-p port] [-a address] [-u path] [-t threads]\n", argv[0]);
+                return 2;
+        }
+    if (threads < 1 || threads > MAX_THREADS) {
+        fprintf(stderr, "invalid number of threads, it must be from 1 to %d\n", MAX_THREADS);
+        return 2;
+    }
+    
+// Every connection takes a file descriptor
+    struct rlimit limit;
+    if (getrlimit(RLIMIT_NOFILE, &limit) == 0) {
+        limit.rlim_cur = limit.rlim_max;
+        setrlimit(RLIMIT_NOFILE, &limit);
+    }
+    if (open_listener(address, port, path) != 0) {
+        perror("listen");
+        return 1;
+    }
+    signal(SIGINT, handle_signal);
+    signal(SIGTERM, handle_signal);
+    signal(SIGPIPE, SIG_IGN);
+    
+    for (int i = 0; i < threads; i++) {
+        struct epoll_event event = { .events = EPOLLIN | EPOLLEXCLUSIVE, .data.ptr = NULL };
+        workers[i].epoll = epoll_create1(EPOLL_CLOEXEC);
+        if (workers[i].epoll < 0 || epoll_ctl(workers[i].epoll, EPOLL_CTL_ADD, listener, &event) != 0 || 
+            pthread_create(&workers[i].thread, NULL, run_worker, &workers[i]) != 0) {
+            perror("worker");
+            return 1;
+        }
+    }
+    for (int i = 0; i < threads; i++)
+        pthread_join(workers[i].thread, NULL);
+    if (path)
+        unlink(path);
+    
+    for (int i = 0; i < threads; i++) {
+        const WORKER *worker = &workers[i];
+        printf("worker %d: accepted=%llu peak=%llu ticks=%llu messages=%llu reads=%llu writes=%llu "
+               "read=%llu written=%llu\n", i, (unsigned long long)worker->accepted, 
+               (unsigned long long)worker->peak_clients, (unsigned long long)worker->ticks, 
+               (unsigned long long)worker->messages, (unsigned long long)worker->reads, 
+               (unsigned long long)worker->writes, (unsigned long long)worker->bytes_read, 
+               (unsigned long long)worker->bytes_written);
+    }
+    
+    return 0;
+}
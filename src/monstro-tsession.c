@@ -0,0 +1,366 @@
+/**
+ * @file monstro-tsession.c
+ * 
+ * @section LICENSE License
+ * 
+ * This is free and unencumbered software released into the public domain.
+ *
+ * Anyone is free to copy, modify, publish, use, compile, sell, or
+ * distribute this software, either in source code form or as a compiled
+ * binary, for any purpose, commercial or non-commercial, and by any
+ * means.
+ * 
+ * In jurisdictions that recognize copyright laws, the author or authors
+ * of this software dedicate any and all copyright interest in the
+ * software to the public domain. We make this dedication for the benefit
+ * of the public at large and to the detriment of our heirs and
+ * successors. We intend this dedication to be an overt act of
+ * relinquishment in perpetuity of all present and future rights to this
+ * software under copyright law.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+ * OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ * 
+ * For more information, please refer to <https://unlicense.org>
+ * 
+ * @section DESCRIPTION Description
+ * 
+ * This file contains an optional rollback session for two player versus 
+ * matches over a network, available only when \c MONSTRO_TWANT_ROLLBACK 
+ * is defined. Instead of waiting for the inputs of the remote player, 
+ * each peer predicts them, by repeating the last ones received, and 
+ * keeps playing; when the actual inputs arrive and differ from the 
+ * prediction, the session restores the state saved at the start of 
+ * that tick and simulates the ticks since then again, all within the 
+ * same frame. Since mover_pieza() is deterministic and cheap, and a 
+ * game is just a plain struct, saving the state every tick and 
+ * simulating several ticks again per frame costs close to nothing.
+ * 
+ * Each frame, the frontend passes its inputs to advance_session() and 
+ * exchanges packets with the remote peer through any transport:
+ * 
+ *      init_session(&session, seed, local, 2, 8);
+ * 
+ *      ...
+ *      // Within the game loop
+ *      while ((size = receive(buffer)) > 0)
+ *          read_packet(&session, buffer, size);
+ *      advance_session(&session, inputs);
+ *      send(buffer, write_packet(&session, buffer));
+ *      // Draw session.players[0] and session.players[1]
+ * 
+ * Local inputs apply \c delay ticks after they are given, which hides 
+ * that much latency without any rollback, and the session never gets 
+ * more than \c window ticks ahead of the last confirmed remote input; 
+ * advance_session() returns \c false, without consuming the inputs, 
+ * while the remote peer is that far behind.
+ * 
+ * Packets are unreliable datagrams. Each one carries every local input 
+ * not yet acknowledged by the remote peer, so lost, duplicated and 
+ * reordered packets need no special handling. The format is, with 
+ * every value in little endian order:
+ * 
+ *      Offset  Size  Contents
+ *      0       2     The characters MV
+ *      2       8     Number of ticks with known remote inputs, the acknowledgement
+ *      10      8     Number of ticks with a final checksum, C
+ *      18      4     Checksum after tick C - 1
+ *      22      8     Tick of the first input
+ *      30      1     Number of inputs, N
+ *      31      N     Inputs, one byte each
+ * 
+ * Once both inputs of a tick are known, its state is final and the 
+ * session chains its game_checksum() to the one of the previous tick. 
+ * Comparing the latest checksum of each peer, which is sent along with 
+ * the inputs, detects a desync within a few ticks of where it happened, 
+ * and \c desync tells the first tick found to differ.
+ * 
+ * Both games are played the same way as in the sample implementations: 
+ * spawn_piece() is called whenever mover_pieza() sets 
+ * \c MONSTRO_TACTION_SPAWN, every ten lines increase the speed and a 
+ * game stops when a piece can't be spawned, unless \c restart was set 
+ * after init_session(), in which case it starts over at the default 
+ * speed; the restarts are part of the state, so rollbacks simulate 
+ * them again like any other tick.
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include "monstro-tsession.h"
+#include "monstro-tbytes.h"
+
+#define FRAME(tick)         ((tick) & (MONSTRO_TSESSION_FRAMES - 1))
+#define PACKET_HEADER       31
+
+
+
+/**
+ * Plays one tick of a player, the same as the sample implementations. 
+ * With \c restart set, a game that tops out starts over, seeded from 
+ * its own random state so both peers pick the same seed.
+ */
+static inline void step_player(MONSTRO_TSESSION_PLAYER *player, int inputs, int restart) {
+    MONSTRO_TGAME *game = &player->game;
+    
+    if (player->game_over)
+        return;
+    game->inputs = inputs;
+    mover_pieza(game);
+    if (game->flags & MONSTRO_TACTION_SPAWN)
+        player->game_over = !spawn_piece(game);
+    if (game->flags & MONSTRO_TACTION_CLEARED) {
+        int lines = __builtin_popcount(game->flags & MONSTRO_TACTION_CLEARED);
+        player->lines += lines;
+        level_up(game, &player->level_lines, lines);
+    }
+    if (player->game_over && restart) {
+        start_game(game, game->random_state);
+        player->level_lines = 0;
+        player->game_over = !spawn_piece(game);
+        player->restarts++;
+    }
+}
+
+
+
+/**
+ * Compares the last checksum received from the remote peer, if the 
+ * local one for the same tick is known.
+ */
+static void compare_checksums(MONSTRO_TSESSION *session) {
+    uint64_t checked = session->remote_checked;
+    
+    if (checked == 0 || checked > session->checked)
+        return;
+    if (session->checked - checked < MONSTRO_TSESSION_FRAMES && 
+        session->checksums[FRAME(checked - 1)] != session->remote_checksum && checked - 1 < session->desync)
+        session->desync = checked - 1;
+    session->remote_checked = 0;
+}
+
+
+
+/**
+ * Computes the checksum of every tick whose inputs are all known.
+ */
+static void update_checksums(MONSTRO_TSESSION *session) {
+    uint64_t final = (session->confirmed < session->tick) ? session->confirmed : session->tick;
+    uint32_t checksum = session->checked ? session->checksums[FRAME(session->checked - 1)] : 0;
+    
+    if (session->rollback < final)
+        final = session->rollback;
+    for (; session->checked < final; session->checked++) {
+    // The state after a tick is the one saved at the start of the next
+        const MONSTRO_TSESSION_PLAYER *players = (session->checked + 1 < session->tick) ? 
+                                                 session->states[FRAME(session->checked + 1)] : session->players;
+        checksum = game_checksum(&players[0].game, checksum);
+        checksum = game_checksum(&players[1].game, checksum);
+        session->checksums[FRAME(session->checked)] = checksum;
+    }
+    compare_checksums(session);
+}
+
+
+
+/**
+ * Saves the state at the start of the current tick and plays it.
+ */
+static inline void step_session(MONSTRO_TSESSION *session) {
+    int frame = FRAME(session->tick);
+    int remote = !session->local;
+    
+// Ticks without a known remote input use the prediction, which is 
+// stored so that it can be checked when the input arrives
+    if (session->tick >= session->confirmed && session->remote_ticks[frame] != session->tick)
+        session->inputs[remote][frame] = session->last_remote;
+    memcpy(session->states[frame], session->players, sizeof(session->players));
+    step_player(&session->players[0], session->inputs[0][frame], session->restart);
+    step_player(&session->players[1], session->inputs[1][frame], session->restart);
+    session->tick++;
+}
+
+
+
+/**
+ * Starts a session. Both peers must call this with the same seed, 
+ * delay and window, and a different local player.
+ * 
+ * @param session   A \c MONSTRO_TSESSION struct to initialize.
+ * @param seed      The seed of both games.
+ * @param local     The index of the local player, 0 or 1.
+ * @param delay     The number of ticks between a local input and the 
+ *                  tick it applies to.
+ * @param window    The largest number of ticks to simulate with 
+ *                  predicted remote inputs, at least 1.
+ * @return          \c true if the session started, \c false if the 
+ *                  settings are out of range.
+ */
+int init_session(MONSTRO_TSESSION *session, uint64_t seed, int local, int delay, int window) {
+    if ((local != 0 && local != 1) || delay < 0 || window < 1 || delay + window > MONSTRO_TSESSION_MAX_LAG)
+        return false;
+    
+    memset(session, 0, sizeof(*session));
+    session->local = local;
+    session->delay = delay;
+    session->window = window;
+    session->rollback = UINT64_MAX;
+    session->desync = UINT64_MAX;
+    for (int i = 0; i < MONSTRO_TSESSION_FRAMES; i++)
+        session->remote_ticks[i] = UINT64_MAX;
+    
+// Nobody has inputs for the first ticks of the delay, so they are known 
+// to be empty on both sides
+    session->confirmed = session->acked = delay;
+    
+    for (int i = 0; i < 2; i++) {
+        MONSTRO_TGAME *game = &session->players[i].game;
+        start_game(game, seed);
+        session->players[i].game_over = !spawn_piece(game);
+    }
+    
+    return true;
+}
+
+
+
+/**
+ * Simulates again, with the inputs known now, every tick since the 
+ * first one that was played with a wrong prediction, if any. 
+ * advance_session() does this on its own before playing a new tick.
+ * 
+ * @param session   A \c MONSTRO_TSESSION struct representing the session.
+ */
+void rollback_session(MONSTRO_TSESSION *session) {
+    if (session->rollback < session->tick) {
+        uint64_t tick = session->tick;
+        memcpy(session->players, session->states[FRAME(session->rollback)], sizeof(session->players));
+        session->rollbacks++;
+        session->resimulated += tick - session->rollback;
+        for (session->tick = session->rollback; session->tick < tick; )
+            step_session(session);
+    }
+    session->rollback = UINT64_MAX;
+    update_checksums(session);
+}
+
+
+
+/**
+ * Plays the next tick of a session with the given local inputs.
+ * 
+ * @param session   A \c MONSTRO_TSESSION struct representing the session.
+ * @param inputs    The inputs of the local player, which apply \c delay 
+ *                  ticks later.
+ * @return          \c true if the tick was played, \c false if the 
+ *                  session must wait for the remote peer, in which case 
+ *                  the inputs are not used and should be given again.
+ */
+int advance_session(MONSTRO_TSESSION *session, int inputs) {
+    rollback_session(session);
+    if (session->tick >= session->confirmed + session->window) {
+        session->stalls++;
+        return false;
+    }
+    
+    session->inputs[session->local][FRAME(session->tick + session->delay)] = inputs & 0x3F;
+    step_session(session);
+    update_checksums(session);
+    return true;
+}
+
+
+
+/**
+ * Adds an input of the remote player, scheduling a rollback if it 
+ * doesn't match the prediction used for its tick.
+ * 
+ * @param session   A \c MONSTRO_TSESSION struct representing the session.
+ * @param tick      The tick the input applies to.
+ * @param inputs    The inputs of the remote player for that tick.
+ * @return          \c true if the input was new, \c false if it was 
+ *                  already known or too far ahead to be stored.
+ */
+int add_remote_input(MONSTRO_TSESSION *session, uint64_t tick, int inputs) {
+    int remote = !session->local;
+    
+    if (tick < session->confirmed || tick - session->confirmed >= MONSTRO_TSESSION_FRAMES || 
+        session->remote_ticks[FRAME(tick)] == tick)
+        return false;
+    
+    inputs &= 0x3F;
+    if (tick < session->tick && session->inputs[remote][FRAME(tick)] != inputs && tick < session->rollback)
+        session->rollback = tick;
+    session->inputs[remote][FRAME(tick)] = inputs;
+    session->remote_ticks[FRAME(tick)] = tick;
+    
+    while (session->remote_ticks[FRAME(session->confirmed)] == session->confirmed) {
+        session->last_remote = session->inputs[remote][FRAME(session->confirmed)];
+        session->confirmed++;
+    }
+    return true;
+}
+
+
+
+/**
+ * Writes a packet with every local input the remote peer hasn't 
+ * acknowledged yet.
+ * 
+ * @param session   A \c MONSTRO_TSESSION struct representing the session.
+ * @param buffer    A buffer of at least \c MONSTRO_TSESSION_PACKET_SIZE bytes.
+ * @return          The size of the packet.
+ */
+size_t write_packet(const MONSTRO_TSESSION *session, uint8_t *buffer) {
+    uint64_t end = session->tick + session->delay;
+    uint64_t start = (session->acked < end) ? session->acked : end;
+    
+    if (end - start > MONSTRO_TSESSION_FRAMES)
+        start = end - MONSTRO_TSESSION_FRAMES;
+    buffer[0] = 'M';
+    buffer[1] = 'V';
+    put_le(buffer + 2, session->confirmed, 8);
+    put_le(buffer + 10, session->checked, 8);
+    put_le(buffer + 18, session->checked ? session->checksums[FRAME(session->checked - 1)] : 0, 4);
+    put_le(buffer + 22, start, 8);
+    buffer[30] = end - start;
+    for (uint64_t tick = start; tick < end; tick++)
+        buffer[PACKET_HEADER + tick - start] = session->inputs[session->local][FRAME(tick)];
+    
+    return PACKET_HEADER + end - start;
+}
+
+
+
+/**
+ * Reads a packet from the remote peer.
+ * 
+ * @param session   A \c MONSTRO_TSESSION struct representing the session.
+ * @param buffer    The packet.
+ * @param size      The size of the packet.
+ * @return          \c true if the packet was valid.
+ */
+int read_packet(MONSTRO_TSESSION *session, const uint8_t *buffer, size_t size) {
+    if (size < PACKET_HEADER || buffer[0] != 'M' || buffer[1] != 'V' || size != PACKET_HEADER + (size_t)buffer[30])
+        return false;
+    
+    uint64_t acked = get_le(buffer + 2, 8);
+    uint64_t checked = get_le(buffer + 10, 8);
+    uint64_t start = get_le(buffer + 22, 8);
+    if (acked > session->acked && acked <= session->tick + session->delay)
+        session->acked = acked;
+    if (checked > session->remote_checked) {
+        session->remote_checked = checked;
+        session->remote_checksum = get_le(buffer + 18, 4);
+        compare_checksums(session);
+    }
+    for (int i = 0; i < buffer[30]; i++)
+        add_remote_input(session, start + i, buffer[PACKET_HEADER + i]);
+    
+    return true;
+}
@@ -0,0 +1,298 @@
+/**
+ * @file monstro-tsim.c
+ * 
+ * @section LICENSE License
+ * 
+ * This is free and unencumbered software released into the public domain.
+ *
+ * Anyone is free to copy, modify, publish, use, compile, sell, or
+ * distribute this software, either in source code form or as a compiled
+ * binary, for any purpose, commercial or non-commercial, and by any
+ * means.
+ * 
+ * In jurisdictions that recognize copyright laws, the author or authors
+ * of this software dedicate any and all copyright interest in the
+ * software to the public domain. We make this dedication for the benefit
+ * of the public at large and to the detriment of our heirs and
+ * successors. We intend this dedication to be an overt act of
+ * relinquishment in perpetuity of all present and future rights to this
+ * software under copyright law.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+ * OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ * 
+ * For more information, please refer to <https://unlicense.org>
+ * 
+ * @section DESCRIPTION Description
+ * 
+ * This file contains an optional simulation runner, available only when 
+ * \c MONSTRO_TWANT_SIMULATION is defined, that plays a large number of 
+ * independent games of the logic in monstro-tlogic.c on every core, 
+ * meant for offline work such as bot tuning or difficulty analysis.
+ * 
+ * Each game is played from spawn_piece() until the next piece can't be 
+ * spawned or the tick limit is reached, with the inputs returned by a 
+ * policy function, and its game length, lines cleared and action flags 
+ * are added to the statistics of the simulation.
+ * 
+ * The games are numbered and split evenly among the threads, each one 
+ * owning a range of game numbers stored in a single 64 bit word. A 
+ * thread takes games from the front of its own range and, once it runs 
+ * out, steals the back half of the range of another thread, so threads 
+ * that get shorter games don't sit idle while the rest finish. Both 
+ * operations are a single compare-and-swap on the range, without locks. 
+ * Each thread also keeps its own statistics, in its own cache lines, 
+ * which are added together only once every thread is done.
+ * 
+ * Since each game only depends on its seed and the policy, the 
+ * statistics are the same for any number of threads.
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <unistd.h>
+#include "monstro-tsim.h"
+
+#define CACHE_LINE      64
+
+
+
+typedef struct {
+// Range of game numbers left to this worker: the first one in the low 
+// 32 bits and one past the last one in the high 32 bits. It's modified 
+// by other workers when they steal from it, so it gets its own cache line.
+    uint64_t range __attribute__((aligned(CACHE_LINE)));
+    MONSTRO_TSTATS stats __attribute__((aligned(CACHE_LINE)));
+    struct RUNNER *runner;
+    int id;
+    int started;
+    pthread_t thread;
+} WORKER;
+
+typedef struct RUNNER {
+    const MONSTRO_TSIMULATION *simulation;
+    WORKER *workers;
+    int count;
+} RUNNER;
+
+static inline uint64_t make_range(uint32_t first, uint32_t end) {
+    return (uint64_t)end << 32 | first;
+}
+
+
+
+/**
+ * Takes the next game from the front of the range of a worker.
+ * 
+ * @param worker    The worker taking the game.
+ * @param index     Where to store the number of the game.
+ * @return          \c true if a game was taken, \c false if the range is empty.
+ */
+static int take_game(WORKER *worker, uint32_t *index) {
+    uint64_t range = __atomic_load_n(&worker->range, __ATOMIC_ACQUIRE);
+    
+    for (;;) {
+        uint32_t first = (uint32_t)range, end = range >> 32;
+        if (first >= end)
+            return false;
+        if (__atomic_compare_exchange_n(&worker->range, &range, make_range(first + 1, end), 
+                                        true, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)) {
+            *index = first;
+            return true;
+        }
+    }
+}
+
+
+
+/**
+ * Steals the back half of the range of another worker, which becomes 
+ * the range of the worker that steals.
+ * 
+ * @param worker    The worker stealing the games; its range must be empty.
+ * @return          \c true if some games were stolen, \c false if every 
+ *                  other worker is out of games too.
+ */
+static int steal_games(WORKER *worker) {
+    RUNNER *runner = worker->runner;
+    
+    for (int i = 1; i < runner->count; i++) {
+        WORKER *victim = &runner->workers[(worker->id + i) % runner->count];
+        uint64_t range = __atomic_load_n(&victim->range, __ATOMIC_ACQUIRE);
+        
+        for (;;) {
+            uint32_t first = (uint32_t)range, end = range >> 32;
+            if (first >= end)
+                break;
+            uint32_t middle = first + (end - first) / 2;
+            if (__atomic_compare_exchange_n(&victim->range, &range, make_range(first, middle), 
+                                            true, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)) {
+                __atomic_store_n(&worker->range, make_range(middle, end), __ATOMIC_RELEASE);
+                return true;
+            }
+        }
+    }
+    
+    return false;
+}
+
+
+
+/**
+ * Returns the inputs of the built-in policy: random movement, with a 
+ * rotation about once every 8 ticks and a hard drop about once every 
+ * 64 ticks.
+ * 
+ * @param state The state of the policy's own random number generator.
+ */
+static int random_inputs(uint64_t *state) {
+// splitmix64
+    uint64_t r = (*state += 0x9E3779B97F4A7C15ULL);
+    r = (r ^ (r >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    r = (r ^ (r >> 27)) * 0x94D049BB133111EBULL;
+    r ^= r >> 31;
+    
+    int inputs = r & (MONSTRO_TINPUT_DOWN | MONSTRO_TINPUT_LEFT | MONSTRO_TINPUT_RIGHT);
+    if (((r >> 8) & 7) == 0)
+        inputs |= (r & 0x800) ? MONSTRO_TINPUT_ROTATE_LEFT : MONSTRO_TINPUT_ROTATE_RIGHT;
+    if (((r >> 16) & 63) == 0)
+        inputs |= MONSTRO_TINPUT_UP;
+    return inputs;
+}
+
+
+
+/**
+ * Plays a game of the simulation and adds it to the statistics.
+ * 
+ * @param simulation    The simulation the game belongs to.
+ * @param index         The number of the game.
+ * @param stats         The statistics of the worker playing the game.
+ */
+static void play_game(const MONSTRO_TSIMULATION *simulation, uint32_t index, MONSTRO_TSTATS *stats) {
+    MONSTRO_TGAME played;
+    MONSTRO_TGAME *game = &played;
+    uint64_t policy_state = simulation->seed + index;
+    uint64_t ticks = 0;
+    
+    start_game(game, simulation->seed + index);
+    int playing = spawn_piece(game);
+    stats->pieces += playing;
+    
+    while (playing && (simulation->max_ticks == 0 || ticks < simulation->max_ticks)) {
+        game->inputs = simulation->policy ? simulation->policy(game, ticks, simulation->data) : random_inputs(&policy_state);
+        mover_pieza(game);
+        ticks++;
+        
+        for (unsigned int flags = game->flags; flags; flags &= flags - 1)
+            stats->flags[__builtin_ctz(flags) % MONSTRO_TSIM_FLAGS]++;
+        if (game->flags & MONSTRO_TACTION_CLEARED) {
+            int lines = __builtin_popcount(game->flags & MONSTRO_TACTION_CLEARED);
+            stats->lines += lines;
+            stats->clears[lines - 1]++;
+        }
+        if (game->flags & MONSTRO_TACTION_SPAWN) {
+            playing = spawn_piece(game);
+            stats->pieces += playing;
+        }
+    }
+    
+    stats->games++;
+    stats->ticks += ticks;
+    if (ticks < stats->shortest) stats->shortest = ticks;
+    if (ticks > stats->longest) stats->longest = ticks;
+}
+
+
+
+/**
+ * Plays games until there are none left to take or steal.
+ * 
+ * @param data  The \c WORKER running the function.
+ */
+static void *run_worker(void *data) {
+    WORKER *worker = data;
+    uint32_t index;
+    
+    do {
+        while (take_game(worker, &index))
+            play_game(worker->runner->simulation, index, &worker->stats);
+    } while (steal_games(worker));
+    
+    return NULL;
+}
+
+
+
+/**
+ * Runs a simulation.
+ * 
+ * Plays \c simulation->games games on \c simulation->threads threads, 
+ * the calling thread being one of them, and returns once every game is 
+ * over. Each game starts with the default limits in monstro-tlogic.h 
+ * and is seeded with its number plus \c simulation->seed.
+ * 
+ * @param simulation    A \c MONSTRO_TSIMULATION struct describing the simulation.
+ * @param stats         A \c MONSTRO_TSTATS struct where the statistics 
+ *                      of every game will be stored.
+ * @return              \c true if the simulation ran, \c false if the 
+ *                      memory for the threads couldn't be allocated.
+ */
+int run_simulation(const MONSTRO_TSIMULATION *simulation, MONSTRO_TSTATS *stats) {
+    RUNNER runner = { .simulation = simulation, .count = simulation->threads };
+    
+    if (runner.count <= 0) {
+        long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+        runner.count = (cpus > 0) ? cpus : 1;
+    }
+    if ((uint32_t)runner.count > simulation->games)
+        runner.count = (simulation->games > 0) ? simulation->games : 1;
+    if (posix_memalign((void **)&runner.workers, CACHE_LINE, runner.count * sizeof(WORKER)) != 0)
+        return false;
+    memset(runner.workers, 0, runner.count * sizeof(WORKER));
+    
+    for (int i = 0; i < runner.count; i++) {
+        WORKER *worker = &runner.workers[i];
+        worker->runner = &runner;
+        worker->id = i;
+        worker->range = make_range((uint64_t)simulation->games * i / runner.count, 
+                                   (uint64_t)simulation->games * (i + 1) / runner.count);
+        worker->stats.shortest = UINT64_MAX;
+    }
+    
+// If a thread can't be created, the other workers simply steal its games
+    for (int i = 1; i < runner.count; i++)
+        runner.workers[i].started = pthread_create(&runner.workers[i].thread, NULL, run_worker, &runner.workers[i]) == 0;
+    run_worker(&runner.workers[0]);
+    
+    memset(stats, 0, sizeof(*stats));
+    stats->shortest = UINT64_MAX;
+    for (int i = 0; i < runner.count; i++) {
+        WORKER *worker = &runner.workers[i];
+        if (worker->started)
+            pthread_join(worker->thread, NULL);
+        stats->games += worker->stats.games;
+        stats->ticks += worker->stats.ticks;
+        stats->pieces += worker->stats.pieces;
+        stats->lines += worker->stats.lines;
+        for (int j = 0; j < 4; j++)
+            stats->clears[j] += worker->stats.clears[j];
+        for (int j = 0; j < MONSTRO_TSIM_FLAGS; j++)
+            stats->flags[j] += worker->stats.flags[j];
+        if (worker->stats.shortest < stats->shortest) stats->shortest = worker->stats.shortest;
+        if (worker->stats.longest > stats->longest) stats->longest = worker->stats.longest;
+    }
+    if (stats->games == 0)
+        stats->shortest = 0;
+    
+    free(runner.workers);
+    return true;
+}
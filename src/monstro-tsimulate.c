@@ -0,0 +1,123 @@
+/**
+ * @file monstro-tsimulate.c
+ * 
+ * @section LICENSE License
+ * 
+ * This is free and unencumbered software released into the public domain.
+ *
+ * Anyone is free to copy, modify, publish, use, compile, sell, or
+ * distribute this software, either in source code form or as a compiled
+ * binary, for any purpose, commercial or non-commercial, and by any
+ * means.
+ * 
+ * In jurisdictions that recognize copyright laws, the author or authors
+ * of this software dedicate any and all copyright interest in the
+ * software to the public domain. We make this dedication for the benefit
+ * of the public at large and to the detriment of our heirs and
+ * successors. We intend this dedication to be an overt act of
+ * relinquishment in perpetuity of all present and future rights to this
+ * software under copyright law.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+ * OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ * 
+ * For more information, please refer to <https://unlicense.org>
+ * 
+ * @section DESCRIPTION Description
+ * 
+ * Test bench for the simulation runner in monstro-tsim.c. It runs the 
+ * same simulation with run_simulation() on 1 thread, then on 2 and so 
+ * on up to the given number of threads, and reports how many ticks per 
+ * second each run plays. Usage:
+ * 
+ *      sim-main [-c] [-n games] [-t ticks] [-j threads] [-s seed]
+ * 
+ * \c -t stops the games still running after that many ticks, \c 0 
+ * plays every game until it tops out, and \c -j defaults to one thread 
+ * per online CPU. \c -c also checks the statistics of every run against 
+ * the ones of the run on 1 thread, which plays every game on the 
+ * calling thread, one after the other; since each game only depends on 
+ * its seed, they must match no matter how the games were split among 
+ * the threads. The exit status is \c 1 if any of them didn't match.
+ */
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include "monstro-tcore.h"
+#include "monstro-tlogic.h"
+#include "monstro-tsim.h"
+
+
+
+double now(void) {
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return t.tv_sec + t.tv_nsec * 1e-9;
+}
+
+
+
+int main(int argc, char **argv) {
+    MONSTRO_TSIMULATION simulation = { .seed = 1, .games = 2000, .max_ticks = 0 };
+    MONSTRO_TSTATS serial, stats;
+    int threads = 0, check = false, option;
+    
+    while ((option = getopt(argc, argv, "cn:t:j:s:")) != -1)
+        switch (option) {
+            case 'c': check = true; break;
+            case 'n': simulation.games = strtoul(optarg, NULL, 10); break;
+            case 't': simulation.max_ticks = strtoull(optarg, NULL, 10); break;
+            case 'j': threads = atoi(optarg); break;
+            case 's': simulation.seed = strtoull(optarg, NULL, 10); break;
+            default:
+                fprintf(stderr, "usage: %s [-c] [-n games] [-t ticks] [-j threads] [-s seed]\n", argv[0]);
+                return 2;
+        }
+    if (threads <= 0) {
+        long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+        threads = (cpus > 0) ? cpus : 1;
+    }
+    
+    uint64_t mismatches = 0, errors = 0;
+    double serial_seconds = 0.0, start = now();
+    for (int n = 1; n <= threads; n++) {
+        simulation.threads = n;
+        double t = now();
+        if (!run_simulation(&simulation, &stats)) {
+            errors++;
+            continue;
+        }
+        double seconds = now() - t;
+        
+        if (n == 1) {
+            serial = stats;
+            serial_seconds = seconds;
+            printf("games: count=%llu ticks=%llu pieces=%llu lines=%llu shortest=%llu longest=%llu\n", 
+                   (unsigned long long)stats.games, (unsigned long long)stats.ticks, 
+                   (unsigned long long)stats.pieces, (unsigned long long)stats.lines, 
+                   (unsigned long long)stats.shortest, (unsigned long long)stats.longest);
+        }
+        int matches = memcmp(&stats, &serial, sizeof(stats)) == 0;
+        mismatches += !matches;
+        printf("threads=%d: seconds=%.3f ticks_per_second=%.0f speedup=%.2f", n, seconds, 
+               stats.ticks / seconds, serial_seconds / seconds);
+        printf(check ? " stats=%s\n" : "\n", matches ? "ok" : "mismatch");
+    }
+    double seconds = now() - start;
+    
+    if (check)
+        printf("check: mismatches=%llu\n", (unsigned long long)mismatches);
+    printf("total: seconds=%.3f errors=%llu\n", seconds, (unsigned long long)errors);
+    
+    return errors != 0 || (check && mismatches != 0);
+}
@@ -0,0 +1,282 @@
+/**
+ * @file monstro-tsnapshot.c
+ * 
+ * @section LICENSE License
+ * 
+ * This is free and unencumbered software released into the public domain.
+ *
+ * Anyone is free to copy, modify, publish, use, compile, sell, or
+ * distribute this software, either in source code form or as a compiled
+ * binary, for any purpose, commercial or non-commercial, and by any
+ * means.
+ * 
+ * In jurisdictions that recognize copyright laws, the author or authors
+ * of this software dedicate any and all copyright interest in the
+ * software to the public domain. We make this dedication for the benefit
+ * of the public at large and to the detriment of our heirs and
+ * successors. We intend this dedication to be an overt act of
+ * relinquishment in perpetuity of all present and future rights to this
+ * software under copyright law.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+ * OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ * 
+ * For more information, please refer to <https://unlicense.org>
+ * 
+ * @section DESCRIPTION Description
+ * 
+ * This file contains functions to save the state of a game into a 
+ * compact binary snapshot and to restore it later, for uses such as 
+ * rollback, undo while searching and resuming a game after a crash. 
+ * Neither function allocates memory; the caller provides a buffer of 
+ * at least \c MONSTRO_TSNAPSHOT_SIZE bytes, which is a compile time 
+ * constant.
+ * 
+ * The format, version \c MONSTRO_TSNAPSHOT_VERSION, is as follows, 
+ * with every multibyte value stored in little endian order:
+ * 
+ *      Offset  Size  Contents
+ *      0       4     Header: version, MONSTRO_TFIELD_SIZE, MONSTRO_TFIELD_WIDTH 
+ *                    and a mask of the optional sections present
+ *      4       8     random_state
+ *      12      19    Bit-packed state and counters, see below
+ *      31      S     Playfield, MONSTRO_TFIELD_SIZE rows of MONSTRO_TFIELD_WIDTH bits
+ *      ...     8     Playfield hash, only with MONSTRO_TWANT_HASH
+ *      ...     C     Color playfield, 4 bits per cell, only with MONSTRO_TWANT_COLORS
+ * 
+ * The state and counters are packed, from the least significant bit of 
+ * the first byte on, as: piece (3 bits), rotation (2), x (7, two's 
+ * complement), y (7, two's complement), inputs (6), flags (14), a bit 
+ * telling if the current piece is on the column index (1) and then the 
+ * nine snap, drop and move counters in the order they appear in 
+ * \c MONSTRO_TGAME, 12 bits each. Counters outside of the 0 to 4095 
+ * range can't be saved.
+ * 
+ * The column index is not saved, it's rebuilt from the playfield on 
+ * restore, and neither is \c current_piece, which is implied by the 
+ * piece and rotation. A snapshot can only be restored by a build with 
+ * the same playfield dimensions and the same optional sections.
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include "monstro-tlogic.h"
+#include "monstro-tpieces.h"
+#include "monstro-tbytes.h"
+
+
+
+#define SECTION_HASH        1
+#define SECTION_COLORS      2
+#define SECTION_COLUMNS     4
+
+#define HEADER_SIZE         4
+#define STATE_OFFSET        (HEADER_SIZE + 8)
+#define BOARD_OFFSET        (STATE_OFFSET + 19)
+#define COUNTER_BITS        12
+#define COUNTER_MAX         ((1 << COUNTER_BITS) - 1)
+
+static const uint8_t sections = 0
+#ifdef MONSTRO_TWANT_HASH
+    | SECTION_HASH
+#endif
+#ifdef MONSTRO_TWANT_COLORS
+    | SECTION_COLORS
+#endif
+#ifdef MONSTRO_TWANT_COLUMNS
+    | SECTION_COLUMNS
+#endif
+    ;
+
+
+
+/**
+ * Packs eight colors, from -1 to 7, into four bytes of two colors each.
+ */
+static inline uint32_t pack_colors(const int8_t *colors) {
+    uint64_t v = get_le((const uint8_t *)colors, 8);
+// Adds 1 to every byte without carrying into the next one
+    v = ((v & 0x7F7F7F7F7F7F7F7FULL) + 0x0101010101010101ULL) ^ (v & 0x8080808080808080ULL);
+    v = (v | (v >> 4)) & 0x00FF00FF00FF00FFULL;
+    v = (v | (v >> 8)) & 0x0000FFFF0000FFFFULL;
+    return v | (v >> 16);
+}
+
+
+
+/**
+ * Unpacks the eight colors packed by pack_colors().
+ */
+static inline void unpack_colors(int8_t *colors, uint32_t packed) {
+    uint64_t v = packed;
+    v = (v | (v << 16)) & 0x0000FFFF0000FFFFULL;
+    v = (v | (v << 8)) & 0x00FF00FF00FF00FFULL;
+    v = (v & 0x000F000F000F000FULL) | ((v & 0x00F000F000F000F0ULL) << 4);
+// Subtracts 1 from every byte without borrowing from the next one
+    v = ((v | 0x8080808080808080ULL) - 0x0101010101010101ULL) ^ 0x8080808080808080ULL;
+    put_le((uint8_t *)colors, v, 8);
+}
+
+
+
+/**
+ * Sign extends a 7 bit two's complement value.
+ */
+static inline int sign_extend7(uint64_t value) {
+    return (int)((value & 0x7F) ^ 0x40) - 0x40;
+}
+
+
+
+/**
+ * Saves the state of a game into a snapshot.
+ * 
+ * @param game      A \c MONSTRO_TGAME struct representing the game to save.
+ * @param buffer    A buffer of at least \c MONSTRO_TSNAPSHOT_SIZE bytes.
+ * @return          The size of the snapshot, which is always 
+ *                  \c MONSTRO_TSNAPSHOT_SIZE, or \c 0 if a counter is 
+ *                  out of the range supported by the format.
+ */
+size_t save_snapshot(const MONSTRO_TGAME *game, uint8_t *buffer) {
+    const int counters[9] = {game->snap_default, game->snap_count, game->snap_index, 
+                             game->drop_default, game->drop_count, game->drop_index, 
+                             game->move_default, game->move_count, game->move_index};
+    uint64_t state[3] = {0};
+    int in_play = 0;
+    
+#ifdef MONSTRO_TWANT_COLUMNS
+// The current piece is in play, as opposed to locked, if its first block 
+// is not in the column index
+    uint64_t piece = piezas[game->piece][game->rotation];
+    int bit = __builtin_ctzll(piece);
+    int row = game->y + bit / 16;
+    if (row >= 0 && row < MONSTRO_TFIELD_SIZE)
+        in_play = !((game->columns[game->x + bit % 16] >> row) & 1);
+#endif
+    
+    state[0] = (uint64_t)(game->piece & 0x7)
+             | (uint64_t)(game->rotation & 0x3) << 3
+             | (uint64_t)(game->x & 0x7F) << 5
+             | (uint64_t)(game->y & 0x7F) << 12
+             | (uint64_t)(game->inputs & 0x3F) << 19
+             | (uint64_t)(game->flags & 0x3FFF) << 25
+             | (uint64_t)in_play << 39;
+    for (int i = 0; i < 9; i++) {
+        int bit = 40 + i * COUNTER_BITS;
+        if ((unsigned)counters[i] > COUNTER_MAX)
+            return 0;
+        state[bit / 64] |= (uint64_t)counters[i] << (bit % 64);
+        if (bit % 64 + COUNTER_BITS > 64)
+            state[bit / 64 + 1] |= (uint64_t)counters[i] >> (64 - bit % 64);
+    }
+    
+    buffer[0] = MONSTRO_TSNAPSHOT_VERSION;
+    buffer[1] = MONSTRO_TFIELD_SIZE;
+    buffer[2] = MONSTRO_TFIELD_WIDTH;
+    buffer[3] = sections;
+    put_le(buffer + 4, game->random_state, 8);
+    put_le(buffer + STATE_OFFSET, state[0], 8);
+    put_le(buffer + STATE_OFFSET + 8, state[1], 8);
+    put_le(buffer + STATE_OFFSET + 16, state[2], 3);
+    
+    uint8_t *data = buffer + BOARD_OFFSET;
+#if __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+    memcpy(data, game->playfield, sizeof(game->playfield));
+    data += sizeof(game->playfield);
+#else
+    for (int y = 0; y < MONSTRO_TFIELD_SIZE; y++, data += sizeof(MONSTRO_TROW))
+        put_le(data, game->playfield[y], sizeof(MONSTRO_TROW));
+#endif
+#ifdef MONSTRO_TWANT_HASH
+    put_le(data, game->hash, 8);
+    data += 8;
+#endif
+#ifdef MONSTRO_TWANT_COLORS
+// Colors go from -1 (empty) to 7 (walls), stored as 0 to 8
+    const int8_t *colors = &game->color_playfield[0][0];
+    for (int i = 0; i < MONSTRO_TFIELD_SIZE * MONSTRO_TFIELD_WIDTH / 8; i++)
+        put_le(data + i * 4, pack_colors(colors + i * 8), 4);
+#endif
+    
+    return MONSTRO_TSNAPSHOT_SIZE;
+}
+
+
+
+/**
+ * Restores the state of a game from a snapshot.
+ * 
+ * The game is left untouched if the snapshot can't be restored.
+ * 
+ * @param game      A \c MONSTRO_TGAME struct where the game will be restored.
+ * @param buffer    The snapshot, as saved by save_snapshot().
+ * @param size      The size of the snapshot.
+ * @return          \c true if the game was restored, \c false if the 
+ *                  snapshot is too short or it comes from a different 
+ *                  version of the format or from a build with different 
+ *                  playfield dimensions or optional sections.
+ */
+int restore_snapshot(MONSTRO_TGAME *game, const uint8_t *buffer, size_t size) {
+    int *counters[9] = {&game->snap_default, &game->snap_count, &game->snap_index, 
+                        &game->drop_default, &game->drop_count, &game->drop_index, 
+                        &game->move_default, &game->move_count, &game->move_index};
+    uint64_t state[3];
+    
+    if (size < MONSTRO_TSNAPSHOT_SIZE || buffer[0] != MONSTRO_TSNAPSHOT_VERSION || 
+        buffer[1] != MONSTRO_TFIELD_SIZE || buffer[2] != MONSTRO_TFIELD_WIDTH || buffer[3] != sections)
+        return false;
+    
+    memset(game->guard, 0, sizeof(game->guard));
+    game->random_state = get_le(buffer + 4, 8);
+    state[0] = get_le(buffer + STATE_OFFSET, 8);
+    state[1] = get_le(buffer + STATE_OFFSET + 8, 8);
+    state[2] = get_le(buffer + STATE_OFFSET + 16, 3);
+    game->piece = state[0] & 0x7;
+    game->rotation = (state[0] >> 3) & 0x3;
+    game->x = sign_extend7(state[0] >> 5);
+    game->y = sign_extend7(state[0] >> 12);
+    game->inputs = (state[0] >> 19) & 0x3F;
+    game->flags = (state[0] >> 25) & 0x3FFF;
+    for (int i = 0; i < 9; i++) {
+        int bit = 40 + i * COUNTER_BITS;
+        uint64_t value = state[bit / 64] >> (bit % 64);
+        if (bit % 64 + COUNTER_BITS > 64)
+            value |= state[bit / 64 + 1] << (64 - bit % 64);
+        *counters[i] = value & COUNTER_MAX;
+    }
+    
+    const uint8_t *data = buffer + BOARD_OFFSET;
+#if __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+    memcpy(game->playfield, data, sizeof(game->playfield));
+    data += sizeof(game->playfield);
+#else
+    for (int y = 0; y < MONSTRO_TFIELD_SIZE; y++, data += sizeof(MONSTRO_TROW))
+        game->playfield[y] = get_le(data, sizeof(MONSTRO_TROW));
+#endif
+#ifdef MONSTRO_TWANT_HASH
+    game->hash = get_le(data, 8);
+    data += 8;
+#endif
+#ifdef MONSTRO_TWANT_COLORS
+    int8_t *colors = &game->color_playfield[0][0];
+    for (int i = 0; i < MONSTRO_TFIELD_SIZE * MONSTRO_TFIELD_WIDTH / 8; i++)
+        unpack_colors(colors + i * 8, get_le(data + i * 4, 4));
+    game->current_piece = piezas[game->piece][game->rotation];
+#endif
+#ifdef MONSTRO_TWANT_COLUMNS
+    uint64_t piece = piezas[game->piece][game->rotation];
+    if ((state[0] >> 39) & 1)
+        borrar_pieza(game->playfield, piece, game->x, game->y);
+    iniciar_columnas(game->columns, game->playfield);
+    if ((state[0] >> 39) & 1)
+        poner_pieza(game->playfield, piece, game->x, game->y);
+#endif
+    
+    return true;
+}
@@ -0,0 +1,213 @@
+/**
+ * @file monstro-tspectate.c
+ * 
+ * @section LICENSE License
+ * 
+ * This is free and unencumbered software released into the public domain.
+ *
+ * Anyone is free to copy, modify, publish, use, compile, sell, or
+ * distribute this software, either in source code form or as a compiled
+ * binary, for any purpose, commercial or non-commercial, and by any
+ * means.
+ * 
+ * In jurisdictions that recognize copyright laws, the author or authors
+ * of this software dedicate any and all copyright interest in the
+ * software to the public domain. We make this dedication for the benefit
+ * of the public at large and to the detriment of our heirs and
+ * successors. We intend this dedication to be an overt act of
+ * relinquishment in perpetuity of all present and future rights to this
+ * software under copyright law.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+ * OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ * 
+ * For more information, please refer to <https://unlicense.org>
+ * 
+ * @section DESCRIPTION Description
+ * 
+ * Test bench for the spectator stream in monstro-tstream.c. It plays a 
+ * game with random inputs, starting a new one whenever it's over, and 
+ * broadcasts every frame to many spectators, each one joining at a 
+ * random frame with write_keyframe() and missing some frames, and 
+ * checks that every spectator in sync sees the same playfield as the 
+ * game. Usage:
+ * 
+ *      spectate-main [-v viewers] [-t ticks] [-s seed] [-k interval] [-p loss]
+ * 
+ * Loss is the percentage of frames each spectator misses. The exit 
+ * status is \c 1 if any spectator in sync sees a different playfield.
+ */
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <time.h>
+#include "monstro-tstream.h"
+
+typedef struct {
+    MONSTRO_TVIEW view;
+    long join;          /* Frame when the spectator joins the stream */
+    uint64_t frames, missed, resyncs;
+} VIEWER;
+
+uint32_t random_state = 1;
+int inputs, hold;
+
+
+
+double now(void) {
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return t.tv_sec + t.tv_nsec * 1e-9;
+}
+
+
+
+uint32_t next_random(uint32_t *state) {
+    *state = *state * 1103515245 + 12345;
+    return *state >> 16;
+}
+
+
+
+/*
+ * Random inputs, held for a few frames like a human player would.
+ */
+int next_inputs(void) {
+    if (--hold > 0)
+        return inputs;
+    uint32_t r = next_random(&random_state);
+    int x = r & 31;
+    inputs = (x < 14) ? 0 : (x < 18) ? MONSTRO_TINPUT_DOWN : (x < 22) ? MONSTRO_TINPUT_LEFT : 
+             (x < 26) ? MONSTRO_TINPUT_RIGHT : (x < 28) ? MONSTRO_TINPUT_ROTATE_LEFT : 
+             (x < 30) ? MONSTRO_TINPUT_ROTATE_RIGHT : MONSTRO_TINPUT_UP;
+    hold = (inputs & (MONSTRO_TINPUT_UP | MONSTRO_TINPUT_ROTATE_LEFT | MONSTRO_TINPUT_ROTATE_RIGHT)) ? 
+           1 : 2 + ((r >> 5) & 15);
+    return inputs;
+}
+
+
+
+/*
+ * Game initialization, the same as in the other implementations.
+ */
+int init_game(MONSTRO_TGAME *game, uint64_t seed) {
+    start_game(game, seed);
+    return spawn_piece(game);
+}
+
+
+
+int main(int argc, char **argv) {
+    long ticks = 36000;
+    uint64_t seed = 1;
+    int count = 1000, interval = MONSTRO_TSTREAM_INTERVAL, loss = 1, option;
+    
+    while ((option = getopt(argc, argv, "v:t:s:k:p:")) != -1)
+        switch (option) {
+            case 'v': count = atoi(optarg); break;
+            case 't': ticks = atol(optarg); break;
+            case 's': seed = strtoull(optarg, NULL, 10); break;
+            case 'k': interval = atoi(optarg); break;
+            case 'p': loss = atoi(optarg); break;
+            default:
+                fprintf(stderr, "usage: %s [-v viewers] [-t ticks] [-s seed] [-k interval] [-p loss]\n", argv[0]);
+                return 2;
+        }
+    VIEWER *viewers = calloc(count > 0 ? count : 1, sizeof(VIEWER));
+    if (!viewers || count < 1 || ticks < 1 || interval < 0) {
+        fprintf(stderr, "invalid settings\n");
+        free(viewers);
+        return 2;
+    }
+    
+    MONSTRO_TGAME spectated;
+    MONSTRO_TGAME *game = &spectated;
+    MONSTRO_TSTREAM stream;
+    uint8_t frame[MONSTRO_TSTREAM_FRAME_SIZE], keyframe[MONSTRO_TSTREAM_FRAME_SIZE];
+    MONSTRO_TROW playfield[MONSTRO_TFIELD_SIZE];
+    uint64_t games = 1, mismatches = 0, checked = 0, largest = 0;
+    double encoding = 0, decoding = 0;
+    
+    random_state = seed;
+    init_stream(&stream, interval);
+    int playing = init_game(game, seed);
+    for (int i = 0; i < count; i++) {
+        init_view(&viewers[i].view);
+        viewers[i].join = next_random(&random_state) % ticks;
+    }
+    
+    for (long tick = 0; tick < ticks; tick++) {
+        if (!playing) {
+            playing = init_game(game, seed + games++);
+            game->flags = 0;
+        }
+        else {
+            game->inputs = next_inputs();
+            mover_pieza(game);
+            if (game->flags & MONSTRO_TACTION_SPAWN)
+                playing = spawn_piece(game);
+        }
+        
+        double t = now();
+        size_t size = encode_frame(&stream, game, frame);
+        encoding += now() - t;
+        if (size > largest)
+            largest = size;
+        
+        t = now();
+        for (int i = 0; i < count; i++) {
+            VIEWER *viewer = &viewers[i];
+            if (tick < viewer->join)
+                continue;
+            if (tick == viewer->join)
+                decode_frame(&viewer->view, keyframe, write_keyframe(&stream, keyframe));
+            else if ((int)(next_random(&random_state) % 100) < loss)
+                viewer->missed++;
+            else {
+                int synced = viewer->view.synced;
+                decode_frame(&viewer->view, frame, size);
+                viewer->resyncs += !synced && viewer->view.synced;
+            }
+            viewer->frames++;
+        }
+        decoding += now() - t;
+        
+    // A piece that couldn't be spawned isn't in the playfield of the game, 
+    // and a spectator that missed this frame doesn't know it yet
+        for (int i = 0; i < count && playing; i++)
+            if (tick >= viewers[i].join && viewers[i].view.synced && viewers[i].view.frame == stream.frame) {
+                draw_view(&viewers[i].view, playfield);
+                mismatches += memcmp(playfield, game->playfield, sizeof(playfield)) != 0;
+                checked++;
+            }
+    }
+    
+    uint64_t frames = 0, missed = 0, resyncs = 0, synced = 0;
+    for (int i = 0; i < count; i++) {
+        frames += viewers[i].frames;
+        missed += viewers[i].missed;
+        resyncs += viewers[i].resyncs;
+        synced += viewers[i].view.synced;
+    }
+    printf("stream: frames=%llu keyframes=%llu games=%llu bytes=%llu (%.2f per frame, largest %llu) encode=%.0fns\n", 
+           (unsigned long long)stream.frames, (unsigned long long)stream.keyframes, (unsigned long long)games, 
+           (unsigned long long)stream.bytes, (double)stream.bytes / stream.frames, (unsigned long long)largest, 
+           encoding * 1e9 / stream.frames);
+    printf("viewers: count=%d frames=%llu missed=%llu resyncs=%llu synced_at_end=%llu decode=%.0fns\n", count, 
+           (unsigned long long)frames, (unsigned long long)missed, (unsigned long long)resyncs, 
+           (unsigned long long)synced, frames ? decoding * 1e9 / frames : 0.0);
+    printf("total: checked=%llu mismatches=%llu %s\n", (unsigned long long)checked, (unsigned long long)mismatches, 
+           mismatches ? "MISMATCH" : "all views match");
+    
+    free(viewers);
+    return mismatches != 0;
+}
@@ -0,0 +1,319 @@
+/**
+ * @file monstro-tstream.c
+ * 
+ * @section LICENSE License
+ * 
+ * This is free and unencumbered software released into the public domain.
+ *
+ * Anyone is free to copy, modify, publish, use, compile, sell, or
+ * distribute this software, either in source code form or as a compiled
+ * binary, for any purpose, commercial or non-commercial, and by any
+ * means.
+ * 
+ * In jurisdictions that recognize copyright laws, the author or authors
+ * of this software dedicate any and all copyright interest in the
+ * software to the public domain. We make this dedication for the benefit
+ * of the public at large and to the detriment of our heirs and
+ * successors. We intend this dedication to be an overt act of
+ * relinquishment in perpetuity of all present and future rights to this
+ * software under copyright law.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+ * OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ * 
+ * For more information, please refer to <https://unlicense.org>
+ * 
+ * @section DESCRIPTION Description
+ * 
+ * This file contains an optional encoder and decoder for streaming a 
+ * game to spectators, available only when \c MONSTRO_TWANT_STREAM is 
+ * defined. The broadcaster encodes each frame of a game once, with 
+ * encode_frame(), and sends the very same bytes to every spectator, 
+ * who rebuilds the game with decode_frame():
+ * 
+ *      // Broadcaster, once per frame
+ *      size = encode_frame(&stream, &game, buffer);
+ *      // Send buffer to every spectator
+ * 
+ *      // Spectator, for each frame received
+ *      if (decode_frame(&view, buffer, size))
+ *          draw_view(&view, playfield);
+ * 
+ * Since the current piece moves almost every frame while the locked 
+ * blocks only change when a piece locks, the playfield is streamed 
+ * without the current piece, which is sent on its own as its index, 
+ * rotation and position. Only the rows that changed since the last 
+ * frame are sent, as the XOR of their old and new values, so most 
+ * frames take just a few bytes and a frame where nothing changed takes 
+ * three. With every value in little endian order, a frame is:
+ * 
+ *      Size  Contents
+ *      1     MONSTRO_TSTREAM_* bits telling what follows
+ *      2     Frame number, counting from 0 and wrapping around
+ *      2     Game action flags, only with MONSTRO_TSTREAM_FLAGS
+ *      3     Piece and rotation (piece + rotation * 8), x and y, only 
+ *            with MONSTRO_TSTREAM_PIECE
+ *      M     One bit per row, set if the row changed, only with 
+ *            MONSTRO_TSTREAM_ROWS
+ *      R     XOR of the old and new value of each changed row, from the 
+ *            bottom up, only with MONSTRO_TSTREAM_ROWS
+ *      R     Every row, from the bottom up, only with 
+ *            MONSTRO_TSTREAM_KEYFRAME, which always has the piece
+ * 
+ * A spectator can only start from a keyframe, which the encoder makes 
+ * every \c interval frames, and falls out of sync when it misses a 
+ * frame, until the next keyframe. A spectator that joins a stream can 
+ * also get a keyframe of the last frame encoded from write_keyframe(), 
+ * which doesn't change the stream, and then go on with the next frames.
+ * 
+ * When a piece can't be spawned, the logic leaves it out of the 
+ * playfield; the spectators still get the piece, drawn over the 
+ * playfield. The color playfield isn't streamed.
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include "monstro-tstream.h"
+#include "monstro-tpieces.h"
+#include "monstro-tbytes.h"
+
+
+
+/**
+ * Returns the row of a piece that covers row \c y of the playfield.
+ */
+static inline MONSTRO_TROW piece_row(int piece, int rotation, int x, int y, int row) {
+    int i = row - y;
+    
+    if (i < 0 || i > 3)
+        return 0;
+    return (MONSTRO_TROW)((piezas[piece][rotation] >> (i * 16)) & 0xFFFF) << x;
+}
+
+
+
+static uint8_t *write_piece(uint8_t *buffer, int piece, int rotation, int x, int y) {
+    buffer[0] = piece + rotation * 8;
+    buffer[1] = x;
+    buffer[2] = (uint8_t)(int8_t)y;
+    return buffer + 3;
+}
+
+
+
+/**
+ * Starts a stream. The first frame is always a keyframe.
+ * 
+ * @param stream    A \c MONSTRO_TSTREAM struct to initialize.
+ * @param interval  The number of frames between keyframes, 
+ *                  \c MONSTRO_TSTREAM_INTERVAL by default, or 0 for a 
+ *                  keyframe only in the first frame.
+ */
+void init_stream(MONSTRO_TSTREAM *stream, int interval) {
+    memset(stream, 0, sizeof(*stream));
+    stream->interval = interval;
+}
+
+
+
+/**
+ * Encodes the next frame of a game.
+ * 
+ * @param stream    A \c MONSTRO_TSTREAM struct representing the stream.
+ * @param game      A \c MONSTRO_TGAME struct representing the game, 
+ *                  after its call to mover_pieza() and spawn_piece(), 
+ *                  if any.
+ * @param buffer    A buffer of at least \c MONSTRO_TSTREAM_FRAME_SIZE bytes.
+ * @return          The size of the frame.
+ */
+size_t encode_frame(MONSTRO_TSTREAM *stream, const MONSTRO_TGAME *game, uint8_t *buffer) {
+    MONSTRO_TROW locked[MONSTRO_TFIELD_SIZE];
+    int keyframe = stream->countdown-- <= 0;
+    uint8_t *end = buffer + 3;
+    int contents = 0;
+    
+    for (int y = 0; y < MONSTRO_TFIELD_SIZE; y++)
+        locked[y] = game->playfield[y] & ~piece_row(game->piece, game->rotation, game->x, game->y, y);
+    
+    if (game->flags) {
+        put_le(end, game->flags, 2);
+        end += 2;
+        contents |= MONSTRO_TSTREAM_FLAGS;
+    }
+    if (keyframe || game->piece != stream->piece || game->rotation != stream->rotation || 
+        game->x != stream->x || game->y != stream->y) {
+        end = write_piece(end, game->piece, game->rotation, game->x, game->y);
+        contents |= MONSTRO_TSTREAM_PIECE;
+    }
+    if (keyframe) {
+        for (int y = 0; y < MONSTRO_TFIELD_SIZE; y++, end += sizeof(MONSTRO_TROW))
+            put_le(end, locked[y], sizeof(MONSTRO_TROW));
+        contents |= MONSTRO_TSTREAM_KEYFRAME;
+        stream->countdown = stream->interval ? stream->interval - 1 : INT32_MAX;
+        stream->keyframes++;
+    }
+    else {
+        uint8_t *mask = end;
+        uint8_t *row = mask + MONSTRO_TSTREAM_MASK_SIZE;
+        memset(mask, 0, MONSTRO_TSTREAM_MASK_SIZE);
+        for (int y = 0; y < MONSTRO_TFIELD_SIZE; y++) {
+            MONSTRO_TROW change = locked[y] ^ stream->locked[y];
+            if (change) {
+                mask[y / 8] |= 1 << (y % 8);
+                put_le(row, change, sizeof(MONSTRO_TROW));
+                row += sizeof(MONSTRO_TROW);
+            }
+        }
+        if (row > mask + MONSTRO_TSTREAM_MASK_SIZE) {
+            end = row;
+            contents |= MONSTRO_TSTREAM_ROWS;
+        }
+    }
+    
+    buffer[0] = contents;
+    put_le(buffer + 1, stream->frame, 2);
+    memcpy(stream->locked, locked, sizeof(locked));
+    stream->piece = game->piece;
+    stream->rotation = game->rotation;
+    stream->x = game->x;
+    stream->y = game->y;
+    stream->frame++;
+    stream->frames++;
+    stream->bytes += end - buffer;
+    
+    return end - buffer;
+}
+
+
+
+/**
+ * Writes a keyframe of the last frame encoded, for a spectator joining 
+ * the stream, without changing the stream; the spectator goes on with 
+ * the next frame encoded.
+ * 
+ * @param stream    A \c MONSTRO_TSTREAM struct representing the stream.
+ * @param buffer    A buffer of at least \c MONSTRO_TSTREAM_FRAME_SIZE bytes.
+ * @return          The size of the keyframe, or 0 if no frame has been 
+ *                  encoded yet.
+ */
+size_t write_keyframe(MONSTRO_TSTREAM *stream, uint8_t *buffer) {
+    if (stream->frames == 0)
+        return 0;
+    
+    uint8_t *end = write_piece(buffer + 3, stream->piece, stream->rotation, stream->x, stream->y);
+    for (int y = 0; y < MONSTRO_TFIELD_SIZE; y++, end += sizeof(MONSTRO_TROW))
+        put_le(end, stream->locked[y], sizeof(MONSTRO_TROW));
+    buffer[0] = MONSTRO_TSTREAM_KEYFRAME | MONSTRO_TSTREAM_PIECE;
+    put_le(buffer + 1, (uint16_t)(stream->frame - 1), 2);
+    stream->keyframes++;
+    
+    return end - buffer;
+}
+
+
+
+/**
+ * Starts a view, out of sync until its first keyframe.
+ * 
+ * @param view  A \c MONSTRO_TVIEW struct to initialize.
+ */
+void init_view(MONSTRO_TVIEW *view) {
+    memset(view, 0, sizeof(*view));
+}
+
+
+
+/**
+ * Decodes a frame of a stream into a view.
+ * 
+ * @param view      A \c MONSTRO_TVIEW struct representing the view.
+ * @param buffer    The frame.
+ * @param size      The size of the frame.
+ * @return          \c true if the view is in sync after the frame, 
+ *                  \c false if the frame is invalid or the view is 
+ *                  waiting for a keyframe.
+ */
+int decode_frame(MONSTRO_TVIEW *view, const uint8_t *buffer, size_t size) {
+    const uint8_t *data = buffer + 3;
+    
+    if (size < 3 || (buffer[0] & ~0xF) || 
+        (buffer[0] & (MONSTRO_TSTREAM_KEYFRAME | MONSTRO_TSTREAM_ROWS)) == (MONSTRO_TSTREAM_KEYFRAME | MONSTRO_TSTREAM_ROWS))
+        return false;
+    int contents = buffer[0];
+    uint16_t frame = get_le(buffer + 1, 2);
+    
+// A delta applies only on top of the frame right before it
+    if (!(contents & MONSTRO_TSTREAM_KEYFRAME) && (!view->synced || frame != view->frame)) {
+        view->synced = false;
+        return false;
+    }
+    
+    size_t needed = 3 + ((contents & MONSTRO_TSTREAM_FLAGS) ? 2 : 0) + ((contents & MONSTRO_TSTREAM_PIECE) ? 3 : 0) + 
+                    ((contents & MONSTRO_TSTREAM_KEYFRAME) ? MONSTRO_TFIELD_SIZE * sizeof(MONSTRO_TROW) : 0) + 
+                    ((contents & MONSTRO_TSTREAM_ROWS) ? MONSTRO_TSTREAM_MASK_SIZE : 0);
+    if (size < needed || ((contents & MONSTRO_TSTREAM_KEYFRAME) && !(contents & MONSTRO_TSTREAM_PIECE)))
+        return false;
+    if (contents & MONSTRO_TSTREAM_PIECE) {
+        const uint8_t *piece = data + ((contents & MONSTRO_TSTREAM_FLAGS) ? 2 : 0);
+        if (piece[0] % 8 >= 7 || piece[1] >= MONSTRO_TFIELD_WIDTH)
+            return false;
+    }
+    if (contents & MONSTRO_TSTREAM_ROWS) {
+        const uint8_t *mask = buffer + needed - MONSTRO_TSTREAM_MASK_SIZE;
+        int rows = 0;
+        for (int i = 0; i < MONSTRO_TSTREAM_MASK_SIZE; i++)
+            rows += __builtin_popcount(mask[i]);
+        if (size < needed + rows * sizeof(MONSTRO_TROW))
+            return false;
+    }
+    
+    view->flags = 0;
+    if (contents & MONSTRO_TSTREAM_FLAGS) {
+        view->flags = get_le(data, 2);
+        data += 2;
+    }
+    if (contents & MONSTRO_TSTREAM_PIECE) {
+        view->piece = data[0] % 8;
+        view->rotation = (data[0] / 8) % 4;
+        view->x = data[1];
+        view->y = (int8_t)data[2];
+        data += 3;
+    }
+    if (contents & MONSTRO_TSTREAM_KEYFRAME) {
+        for (int y = 0; y < MONSTRO_TFIELD_SIZE; y++, data += sizeof(MONSTRO_TROW))
+            view->locked[y] = get_le(data, sizeof(MONSTRO_TROW));
+        view->synced = true;
+    }
+    if (contents & MONSTRO_TSTREAM_ROWS) {
+        const uint8_t *mask = data;
+        data += MONSTRO_TSTREAM_MASK_SIZE;
+        for (int y = 0; y < MONSTRO_TFIELD_SIZE; y++)
+            if (mask[y / 8] & (1 << (y % 8))) {
+                view->locked[y] ^= get_le(data, sizeof(MONSTRO_TROW));
+                data += sizeof(MONSTRO_TROW);
+            }
+    }
+    view->frame = frame + 1;
+    
+    return true;
+}
+
+
+
+/**
+ * Draws the playfield of a view, along with its current piece, the same 
+ * as the playfield of the game.
+ * 
+ * @param view      A \c MONSTRO_TVIEW struct representing the view.
+ * @param playfield An array of \c MONSTRO_TFIELD_SIZE rows.
+ */
+void draw_view(const MONSTRO_TVIEW *view, MONSTRO_TROW *playfield) {
+    for (int y = 0; y < MONSTRO_TFIELD_SIZE; y++)
+        playfield[y] = view->locked[y] | piece_row(view->piece, view->rotation, view->x, view->y, y);
+}
@@ -0,0 +1,200 @@
+/**
+ * @file monstro-tticker.c
+ * 
+ * @section LICENSE License
+ * 
+ * This is free and unencumbered software released into the public domain.
+ *
+ * Anyone is free to copy, modify, publish, use, compile, sell, or
+ * distribute this software, either in source code form or as a compiled
+ * binary, for any purpose, commercial or non-commercial, and by any
+ * means.
+ * 
+ * In jurisdictions that recognize copyright laws, the author or authors
+ * of this software dedicate any and all copyright interest in the
+ * software to the public domain. We make this dedication for the benefit
+ * of the public at large and to the detriment of our heirs and
+ * successors. We intend this dedication to be an overt act of
+ * relinquishment in perpetuity of all present and future rights to this
+ * software under copyright law.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+ * OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ * 
+ * For more information, please refer to <https://unlicense.org>
+ * 
+ * @section DESCRIPTION Description
+ * 
+ * Test bench for the session scheduler in monstro-tsched.c. It plays 
+ * many game sessions on a single thread, each one a task with random 
+ * inputs and its own start time within the first period, and reports 
+ * the lag of their ticks. Usage:
+ * 
+ *      ticker-main [-f] [-n sessions] [-d seconds] [-r rate] [-s seed]
+ * 
+ * Each session goes through three states: it starts a game, plays it 
+ * until a piece can't be spawned and then waits for two seconds before 
+ * starting the next one. \c -f plays the sessions back to back, with a 
+ * simulated clock instead of sleeping, which measures how many session 
+ * ticks per second a single thread can play. The exit status is \c 1 
+ * if any tick was given up.
+ */
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include "monstro-tlogic.h"
+#include "monstro-tsched.h"
+
+enum {STARTING, PLAYING, WAITING};
+
+typedef struct {
+    MONSTRO_TGAME game;
+    MONSTRO_TTASK task;
+    uint64_t seed;
+    uint32_t random;
+    int inputs, hold;
+    int wait;           /* Ticks left to wait before the next game */
+    uint64_t games, lines;
+} SESSION;
+
+int rate = 60;
+
+
+
+uint32_t next_random(uint32_t *state) {
+    *state = *state * 1103515245 + 12345;
+    return *state >> 16;
+}
+
+
+
+/*
+ * Random inputs, held for a few frames like a human player would.
+ */
+int next_inputs(SESSION *session) {
+    if (--session->hold > 0)
+        return session->inputs;
+    uint32_t r = next_random(&session->random);
+    int x = r & 31;
+    session->inputs = (x < 14) ? 0 : (x < 18) ? MONSTRO_TINPUT_DOWN : (x < 22) ? MONSTRO_TINPUT_LEFT : 
+                      (x < 26) ? MONSTRO_TINPUT_RIGHT : (x < 28) ? MONSTRO_TINPUT_ROTATE_LEFT : 
+                      (x < 30) ? MONSTRO_TINPUT_ROTATE_RIGHT : MONSTRO_TINPUT_UP;
+    session->hold = (session->inputs & (MONSTRO_TINPUT_UP | MONSTRO_TINPUT_ROTATE_LEFT | MONSTRO_TINPUT_ROTATE_RIGHT)) ? 
+                    1 : 2 + ((r >> 5) & 15);
+    return session->inputs;
+}
+
+
+
+/*
+ * Plays one tick of a session.
+ */
+int resume_session(MONSTRO_TTASK *task) {
+    SESSION *session = task->data;
+    MONSTRO_TGAME *game = &session->game;
+    
+    switch (task->state) {
+        case STARTING:
+            start_game(game, session->seed + session->games++);
+            task->state = spawn_piece(game) ? PLAYING : WAITING;
+            session->wait = 2 * rate;
+            break;
+        case PLAYING:
+            game->inputs = next_inputs(session);
+            mover_pieza(game);
+            if ((game->flags & MONSTRO_TACTION_SPAWN) && !spawn_piece(game))
+                task->state = WAITING;
+            session->lines += __builtin_popcount(game->flags & MONSTRO_TACTION_CLEARED);
+            break;
+        case WAITING:
+            if (--session->wait <= 0)
+                task->state = STARTING;
+            break;
+    }
+    return true;
+}
+
+
+
+int main(int argc, char **argv) {
+    int count = 10000, seconds = 10, simulated = false, option;
+    uint64_t seed = 1;
+    
+    while ((option = getopt(argc, argv, "fn:d:r:s:")) != -1)
+        switch (option) {
+            case 'f': simulated = true; break;
+            case 'n': count = atoi(optarg); break;
+            case 'd': seconds = atoi(optarg); break;
+            case 'r': rate = atoi(optarg); break;
+            case 's': seed = strtoull(optarg, NULL, 10); break;
+            default:
+                fprintf(stderr, "usage: %s [-f] [-n sessions] [-d seconds] [-r rate] [-s seed]\n", argv[0]);
+                return 2;
+        }
+    SESSION *sessions = calloc(count > 0 ? count : 1, sizeof(SESSION));
+    int64_t period = (rate > 0) ? 1000000000 / rate : 0;
+    if (!sessions || count < 1 || seconds < 1 || period < MONSTRO_TSCHED_RESOLUTION) {
+        fprintf(stderr, "invalid settings\n");
+        free(sessions);
+        return 2;
+    }
+    
+    MONSTRO_TSCHEDULER scheduler;
+    init_scheduler(&scheduler);
+    int64_t start = scheduler_time() + period;
+    for (int i = 0; i < count; i++) {
+        SESSION *session = &sessions[i];
+        session->seed = seed * count + i;
+        session->random = session->seed;
+        session->task.resume = resume_session;
+        session->task.data = session;
+        add_task(&scheduler, &session->task, start + period * i / count, period);
+    }
+    
+    int64_t end = start + (int64_t)seconds * 1000000000;
+    int64_t begin = scheduler_time();
+// The simulated clock moves at least one slot at a time, like a busy 
+// thread would wake up
+    if (simulated)
+        for (int64_t now = start; now < end; ) {
+            int64_t next = advance_scheduler(&scheduler, now);
+            now = (next > now + MONSTRO_TSCHED_RESOLUTION) ? next : now + MONSTRO_TSCHED_RESOLUTION;
+        }
+    else
+        run_scheduler(&scheduler, end);
+    double elapsed = (scheduler_time() - begin) * 1e-9;
+    
+    uint64_t ticks = 0, late = 0, skipped = 0, games = 0, lines = 0, slow = 0;
+    int64_t total_lag = 0, worst_lag = 0;
+    for (int i = 0; i < count; i++) {
+        const MONSTRO_TTASK *task = &sessions[i].task;
+        ticks += task->ticks;
+        late += task->late;
+        skipped += task->skipped;
+        total_lag += task->total_lag;
+        if (task->worst_lag > worst_lag)
+            worst_lag = task->worst_lag;
+        slow += task->worst_lag > MONSTRO_TSCHED_LATE;
+        games += sessions[i].games;
+        lines += sessions[i].lines;
+    }
+    printf("sessions: count=%d games=%llu lines=%llu\n", count, (unsigned long long)games, (unsigned long long)lines);
+    printf("ticks: count=%llu expected=%llu late=%llu skipped=%llu\n", (unsigned long long)ticks, 
+           (unsigned long long)count * seconds * rate, (unsigned long long)late, (unsigned long long)skipped);
+    if (!simulated)
+        printf("lag: average=%.1fus worst=%.1fus sessions_over_%dus=%llu\n", ticks ? total_lag * 1e-3 / ticks : 0.0, 
+               worst_lag * 1e-3, MONSTRO_TSCHED_LATE / 1000, (unsigned long long)slow);
+    printf("scheduler: wakeups=%llu busy=%.1f%% ticks_per_second=%.0f\n", (unsigned long long)scheduler.wakeups, 
+           100.0 * scheduler.busy * 1e-9 / elapsed, simulated ? ticks / elapsed : ticks / (double)seconds);
+    
+    free(sessions);
+    return skipped != 0;
+}
@@ -0,0 +1,378 @@
+/**
+ * @file monstro-tversus.c
+ * 
+ * @section LICENSE License
+ * 
+ * This is free and unencumbered software released into the public domain.
+ *
+ * Anyone is free to copy, modify, publish, use, compile, sell, or
+ * distribute this software, either in source code form or as a compiled
+ * binary, for any purpose, commercial or non-commercial, and by any
+ * means.
+ * 
+ * In jurisdictions that recognize copyright laws, the author or authors
+ * of this software dedicate any and all copyright interest in the
+ * software to the public domain. We make this dedication for the benefit
+ * of the public at large and to the detriment of our heirs and
+ * successors. We intend this dedication to be an overt act of
+ * relinquishment in perpetuity of all present and future rights to this
+ * software under copyright law.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+ * OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ * 
+ * For more information, please refer to <https://unlicense.org>
+ * 
+ * @section DESCRIPTION Description
+ * 
+ * Test bench for the rollback session in monstro-tsession.c. It plays 
+ * a versus match between two peers in the same process, each one with 
+ * its own MONSTRO_TSESSION and random inputs, connected by a simulated 
+ * network with latency, jitter and packet loss, or by UDP sockets on 
+ * localhost. Usage:
+ * 
+ *      versus-main [-u] [-t ticks] [-s seed] [-d delay] [-w window] 
+ *                  [-l latency] [-j jitter] [-p loss] [-f tick]
+ * 
+ * Latency and jitter are in frames, one tick per frame, and loss is a 
+ * percentage. A game that tops out starts over, so both games stay 
+ * alive and every rollback simulates live playfields again. When both 
+ * peers reach the last tick, the match goes on without new ticks until 
+ * every input is confirmed, and then the final state of both games is 
+ * compared on both peers.
+ * 
+ * The peers also compare the checksums of their ticks as they play. 
+ * When a peer detects a desync, the match stops, the first tick where 
+ * the checksums of both peers differ is reported and the state of the 
+ * games after that tick is written for both peers. \c -f injects such 
+ * a desync on the second peer at the given tick, to test this. The 
+ * exit status is \c 1 on a desync.
+ */
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <time.h>
+#include <fcntl.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include "monstro-tsession.h"
+
+#define QUEUE_SIZE 4096
+
+typedef struct {
+    uint64_t frame;     /* Frame when the packet is delivered */
+    size_t size;
+    uint8_t data[MONSTRO_TSESSION_PACKET_SIZE];
+} PACKET;
+
+typedef struct {
+    MONSTRO_TSESSION session;
+    PACKET queue[QUEUE_SIZE];   /* Packets in flight towards the other peer */
+    int queued;
+    int socket;
+    uint32_t random;
+    int inputs, hold;
+    double worst;       /* Longest call to advance_session(), in seconds */
+} PEER;
+
+PEER peers[2];
+int use_udp = false;
+int latency = 3, jitter = 1, loss = 5;
+long fault = -1;
+uint32_t network_random = 1;
+
+
+
+double now(void) {
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return t.tv_sec + t.tv_nsec * 1e-9;
+}
+
+
+
+uint32_t next_random(uint32_t *state) {
+    *state = *state * 1103515245 + 12345;
+    return *state >> 16;
+}
+
+
+
+/*
+ * Random inputs, held for a few frames like a human player would.
+ */
+int next_inputs(PEER *peer) {
+    if (--peer->hold > 0)
+        return peer->inputs;
+    uint32_t r = next_random(&peer->random);
+    int x = r & 31;
+    peer->inputs = (x < 14) ? 0 : (x < 18) ? MONSTRO_TINPUT_DOWN : (x < 22) ? MONSTRO_TINPUT_LEFT : 
+                   (x < 26) ? MONSTRO_TINPUT_RIGHT : (x < 28) ? MONSTRO_TINPUT_ROTATE_LEFT : 
+                   (x < 30) ? MONSTRO_TINPUT_ROTATE_RIGHT : MONSTRO_TINPUT_UP;
+    peer->hold = (peer->inputs & (MONSTRO_TINPUT_UP | MONSTRO_TINPUT_ROTATE_LEFT | MONSTRO_TINPUT_ROTATE_RIGHT)) ? 
+                 1 : 2 + ((r >> 5) & 15);
+    return peer->inputs;
+}
+
+
+
+/*
+ * Opens a UDP socket for each peer on localhost and connects them.
+ */
+int open_sockets(void) {
+    struct sockaddr_in address[2];
+    socklen_t length = sizeof(address[0]);
+    
+    for (int i = 0; i < 2; i++) {
+        memset(&address[i], 0, sizeof(address[i]));
+        address[i].sin_family = AF_INET;
+        address[i].sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        peers[i].socket = socket(AF_INET, SOCK_DGRAM, 0);
+        if (peers[i].socket < 0 || bind(peers[i].socket, (struct sockaddr *)&address[i], length) != 0 || 
+            getsockname(peers[i].socket, (struct sockaddr *)&address[i], &length) != 0)
+            return false;
+        fcntl(peers[i].socket, F_SETFL, O_NONBLOCK);
+    }
+    for (int i = 0; i < 2; i++)
+        if (connect(peers[i].socket, (struct sockaddr *)&address[!i], length) != 0)
+            return false;
+    return true;
+}
+
+
+
+/*
+ * Sends a packet to the other peer, through the simulated network.
+ */
+void send_packet(PEER *peer, uint64_t frame) {
+    if (peer->queued == QUEUE_SIZE || (int)(next_random(&network_random) % 100) < loss)
+        return;
+    PACKET *packet = &peer->queue[peer->queued++];
+    packet->frame = frame + latency + (jitter > 0 ? next_random(&network_random) % (jitter + 1) : 0);
+    packet->size = write_packet(&peer->session, packet->data);
+}
+
+
+
+/*
+ * Delivers the packets due by this frame from one peer to the other; 
+ * with UDP, the packets due are sent and whatever arrived is read.
+ */
+void deliver_packets(PEER *from, PEER *to, uint64_t frame) {
+    int kept = 0;
+    
+    for (int i = 0; i < from->queued; i++) {
+        PACKET *packet = &from->queue[i];
+        if (packet->frame > frame)
+            from->queue[kept++] = *packet;
+        else if (use_udp)
+            send(from->socket, packet->data, packet->size, 0);
+        else
+            read_packet(&to->session, packet->data, packet->size);
+    }
+    from->queued = kept;
+    
+    if (use_udp) {
+        uint8_t buffer[MONSTRO_TSESSION_PACKET_SIZE];
+        ssize_t size;
+        while ((size = recv(to->socket, buffer, sizeof(buffer), 0)) > 0)
+            read_packet(&to->session, buffer, size);
+    }
+}
+
+
+
+/*
+ * Returns the players of a peer after a tick, or NULL if they are no 
+ * longer saved.
+ */
+const MONSTRO_TSESSION_PLAYER *players_after(const MONSTRO_TSESSION *session, uint64_t tick) {
+    if (tick + 1 == session->tick)
+        return session->players;
+    if (tick + 1 < session->tick && session->tick - (tick + 1) < MONSTRO_TSESSION_FRAMES)
+        return session->states[(tick + 1) % MONSTRO_TSESSION_FRAMES];
+    return NULL;
+}
+
+
+
+/*
+ * Writes a game of both peers side by side, along with its counters.
+ */
+void print_games(const MONSTRO_TGAME *a, const MONSTRO_TGAME *b) {
+    const MONSTRO_TGAME *games[2] = {a, b};
+    
+    for (int y = MONSTRO_TFIELD_SIZE - 1; y >= 0; y--) {
+        for (int i = 0; i < 2; i++) {
+            for (int x = MONSTRO_TFIELD_WIDTH - 1; x >= 0; x--)
+                putchar((games[i]->playfield[y] >> x) & 1 ? '#' : '.');
+            printf(i ? "\n" : "  %s  ", a->playfield[y] == b->playfield[y] ? "  " : "<>");
+        }
+    }
+    for (int i = 0; i < 2; i++) {
+        const MONSTRO_TGAME *game = games[i];
+        printf("peer %d: piece=%d rotation=%d x=%d y=%d inputs=%d flags=%#x snap=%d/%d/%d drop=%d/%d/%d "
+               "move=%d/%d/%d random=%016llx\n", i, game->piece, game->rotation, game->x, game->y, 
+               game->inputs, game->flags, game->snap_default, game->snap_count, game->snap_index, 
+               game->drop_default, game->drop_count, game->drop_index, game->move_default, 
+               game->move_count, game->move_index, (unsigned long long)game->random_state);
+    }
+}
+
+
+
+/*
+ * Finds the first tick where the checksums of both peers differ and 
+ * writes the games that differ after it.
+ */
+void report_desync(void) {
+    const MONSTRO_TSESSION *a = &peers[0].session, *b = &peers[1].session;
+    uint64_t checked = (a->checked < b->checked) ? a->checked : b->checked;
+    uint64_t last = (a->checked > b->checked) ? a->checked : b->checked;
+    uint64_t first = (last > MONSTRO_TSESSION_FRAMES) ? last - MONSTRO_TSESSION_FRAMES : 0;
+    uint64_t tick = first;
+    
+    while (tick < checked && a->checksums[tick % MONSTRO_TSESSION_FRAMES] == b->checksums[tick % MONSTRO_TSESSION_FRAMES])
+        tick++;
+    if (tick == checked) {
+        printf("desync: before tick %llu, no longer saved\n", (unsigned long long)first);
+        return;
+    }
+    printf("desync: first diverging tick %llu\n", (unsigned long long)tick);
+    
+    const MONSTRO_TSESSION_PLAYER *players_a = players_after(a, tick), *players_b = players_after(b, tick);
+    if (!players_a || !players_b)
+        return;
+    for (int i = 0; i < 2; i++)
+        if (game_checksum(&players_a[i].game, 0) != game_checksum(&players_b[i].game, 0)) {
+            printf("player %d after tick %llu:\n", i, (unsigned long long)tick);
+            print_games(&players_a[i].game, &players_b[i].game);
+        }
+}
+
+
+
+/*
+ * Compares the final state of both games on both peers.
+ */
+int same_state(void) {
+    for (int i = 0; i < 2; i++) {
+        const MONSTRO_TSESSION_PLAYER *a = &peers[0].session.players[i], *b = &peers[1].session.players[i];
+        uint8_t snapshot_a[MONSTRO_TSNAPSHOT_SIZE], snapshot_b[MONSTRO_TSNAPSHOT_SIZE];
+        if (save_snapshot(&a->game, snapshot_a) != save_snapshot(&b->game, snapshot_b) || 
+            memcmp(snapshot_a, snapshot_b, sizeof(snapshot_a)) != 0 || a->lines != b->lines || 
+            a->restarts != b->restarts || a->game_over != b->game_over)
+            return false;
+    }
+    return true;
+}
+
+
+
+int main(int argc, char **argv) {
+    long ticks = 36000;
+    uint64_t seed = 1;
+    int delay = 2, window = 8, option;
+    
+    while ((option = getopt(argc, argv, "ut:s:d:w:l:j:p:f:")) != -1)
+        switch (option) {
+            case 'u': use_udp = true; break;
+            case 't': ticks = atol(optarg); break;
+            case 's': seed = strtoull(optarg, NULL, 10); break;
+            case 'd': delay = atoi(optarg); break;
+            case 'w': window = atoi(optarg); break;
+            case 'l': latency = atoi(optarg); break;
+            case 'j': jitter = atoi(optarg); break;
+            case 'p': loss = atoi(optarg); break;
+            case 'f': fault = atol(optarg); break;
+            default:
+                fprintf(stderr, "usage: %s [-u] [-t ticks] [-s seed] [-d delay] [-w window] "
+                                "[-l latency] [-j jitter] [-p loss] [-f tick]\n", argv[0]);
+                return 2;
+        }
+    
+    for (int i = 0; i < 2; i++) {
+        if (!init_session(&peers[i].session, seed, i, delay, window)) {
+            fprintf(stderr, "invalid delay or window, delay + window must be at most %d\n", MONSTRO_TSESSION_MAX_LAG);
+            return 2;
+        }
+        peers[i].session.restart = true;
+        peers[i].random = seed * 2 + i;
+    }
+    if (use_udp && !open_sockets()) {
+        perror("socket");
+        return 1;
+    }
+    
+// Play until both peers reach the last tick and know every input
+    uint64_t frame = 0;
+    double start = now();
+    for (; peers[0].session.tick < (uint64_t)ticks || peers[1].session.tick < (uint64_t)ticks || 
+           peers[0].session.confirmed < (uint64_t)ticks || peers[1].session.confirmed < (uint64_t)ticks; frame++) {
+        for (int i = 0; i < 2; i++) {
+            PEER *peer = &peers[i];
+            deliver_packets(&peers[!i], peer, frame);
+            double t = now();
+            if (peer->session.tick < (uint64_t)ticks) {
+                if (advance_session(&peer->session, peer->inputs))
+                    next_inputs(peer);
+            }
+            else
+                rollback_session(&peer->session);
+            t = now() - t;
+            if (t > peer->worst)
+                peer->worst = t;
+            send_packet(peer, frame);
+            
+        // The fault also goes into every state a rollback could restore, 
+        // so the first tick to differ is the first one not yet confirmed
+            if (i == 1 && fault >= 0 && peer->session.tick >= (uint64_t)fault) {
+                MONSTRO_TSESSION *session = &peer->session;
+                printf("fault: injected before tick %llu\n", (unsigned long long)session->confirmed);
+                for (uint64_t tick = session->confirmed; tick < session->tick; tick++)
+                    session->states[tick % MONSTRO_TSESSION_FRAMES][0].game.random_state ^= 1;
+                session->players[0].game.random_state ^= 1;
+                fault = -1;
+            }
+        }
+        if (peers[0].session.desync != UINT64_MAX || peers[1].session.desync != UINT64_MAX)
+            break;
+        if (use_udp && peers[0].queued == 0 && peers[1].queued == 0)
+            usleep(10);
+    }
+    double seconds = now() - start;
+    
+    for (int i = 0; i < 2; i++) {
+        rollback_session(&peers[i].session);
+        const MONSTRO_TSESSION *session = &peers[i].session;
+        printf("peer %d: ticks=%llu rollbacks=%llu resimulated=%llu (%.1f per rollback) stalls=%llu worst_frame=%.1fus\n", 
+               i, (unsigned long long)session->tick, (unsigned long long)session->rollbacks, 
+               (unsigned long long)session->resimulated, 
+               session->rollbacks ? (double)session->resimulated / session->rollbacks : 0.0, 
+               (unsigned long long)session->stalls, peers[i].worst * 1e6);
+    }
+    for (int i = 0; i < 2; i++) {
+        const MONSTRO_TSESSION_PLAYER *player = &peers[0].session.players[i];
+        printf("player %d: lines=%llu restarts=%llu game_over=%d\n", i, (unsigned long long)player->lines, 
+               (unsigned long long)player->restarts, player->game_over);
+    }
+    for (int i = 0; i < 2; i++)
+        if (peers[i].session.desync != UINT64_MAX)
+            printf("peer %d: desync detected at tick %llu\n", i, (unsigned long long)peers[i].session.desync);
+    int in_sync = peers[0].session.desync == UINT64_MAX && peers[1].session.desync == UINT64_MAX && same_state();
+    if (!in_sync)
+        report_desync();
+    printf("total: frames=%llu seconds=%.3f %s\n", (unsigned long long)frame, seconds, in_sync ? "in sync" : "DESYNC");
+    
+    return !in_sync;
+}